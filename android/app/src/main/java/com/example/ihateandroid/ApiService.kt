@@ -68,11 +68,14 @@ interface ApiService {
 
 
     // Measurement Endpoints
+    // Returns one page, newest first; pass next_cursor back as cursor until it is null.
     @GET("/api/measurement/list/sensor")
     suspend fun getSensorMeasurements(
         @Query("sensor_id") sensorId: Int,
         @Query("start_date") startDate: String,
-        @Query("end_date") endDate: String
+        @Query("end_date") endDate: String,
+        @Query("limit") limit: Int,
+        @Query("cursor") cursor: String? = null
     ): Response<MeasurementListResponse>
 }
 
@@ -123,7 +126,8 @@ data class SensorType(
 
 data class MeasurementListResponse(
     val measurements: List<Measurement>,
-    val total_count: Int
+    val total_count: Int,
+    @SerializedName("next_cursor") val nextCursor: String? = null
 )
 
 data class Measurement(
@@ -339,19 +339,29 @@ class DashboardActivity : AppCompatActivity() {
                 val startDate = SimpleDateFormat("yyyy-MM-dd'T'HH:mm:ss'Z'", Locale.getDefault()).format(tempCalendar.time)
 
 
-                val response: Response<MeasurementListResponse> = RetrofitClient.apiService.getSensorMeasurements(sensorId, startDate, endDate)
-                LoggerUtil.logInfo("Measurement response: code=${response.code()}, body=${response.body()?.measurements?.size ?: 0} measurements")
-
-                if (!response.isSuccessful) {
-                    val errorBody = response.errorBody()?.string()
-                    LoggerUtil.logError("Measurement fetch failed: code=${response.code()}, error=$errorBody")
-                    withContext(Dispatchers.Main) {
-                        handleApiError(response.code())
+                // The server answers one page at a time; follow next_cursor to get the whole range.
+                val fetched = mutableListOf<Measurement>()
+                var cursor: String? = null
+                do {
+                    val response: Response<MeasurementListResponse> =
+                        RetrofitClient.apiService.getSensorMeasurements(sensorId, startDate, endDate, MEASUREMENT_PAGE_SIZE, cursor)
+                    LoggerUtil.logInfo("Measurement response: code=${response.code()}, body=${response.body()?.measurements?.size ?: 0} measurements")
+
+                    if (!response.isSuccessful) {
+                        val errorBody = response.errorBody()?.string()
+                        LoggerUtil.logError("Measurement fetch failed: code=${response.code()}, error=$errorBody")
+                        withContext(Dispatchers.Main) {
+                            handleApiError(response.code())
+                        }
+                        return@withContext
                     }
-                    return@withContext
-                }
 
-                val measurements = response.body()?.measurements?.sortedBy { it.recordedAt } ?: emptyList()
+                    val page = response.body()
+                    fetched.addAll(page?.measurements ?: emptyList())
+                    cursor = page?.nextCursor
+                } while (cursor != null)
+
+                val measurements = fetched.sortedBy { it.recordedAt }
 
                 withContext(Dispatchers.Main) {
                     if (measurements.isEmpty()) {
@@ -517,4 +527,9 @@ class DashboardActivity : AppCompatActivity() {
             }
         }
     }
+
+    companion object {
+        // The server's maxPageSize; larger values are capped to it anyway.
+        private const val MEASUREMENT_PAGE_SIZE = 5000
+    }
 }
@@ -0,0 +1,116 @@
+#include "benchdatabase.h"
+#include "../controllers/dbcontroller.h"
+#include "../controllers/partitionmanager.h"
+#include "../repositories/hotwindowstore.h"
+#include "../repositories/measurementrepository.h"
+#include "../repositories/solarpanelrepository.h"
+#include "../repositories/sensorrepository.h"
+#include "../repositories/userrepository.h"
+#include <QtSql/QSqlError>
+#include <cstdio>
+#include <optional>
+
+namespace {
+
+// A week of one reading every 6 s.
+constexpr int seededReadings = 100800;
+constexpr int readingIntervalMs = 6000;
+constexpr qint64 seededSensorTypeId = 1;   // "temperature", part of db/ArkaNova.sql
+
+std::optional<BenchDatabase::Fixture> seeded;
+
+bool seed()
+{
+    BenchDatabase::Fixture fixture;
+
+    UserRepository users;
+    QString email = QString("bench-%1@arkanova.local").arg(QDateTime::currentMSecsSinceEpoch());
+    auto user = users.createUser(User(0, email, "bench"));
+    if (!user) {
+        return false;
+    }
+    fixture.userId = user->id();
+
+    SolarPanelRepository panels;
+    QDateTime now = QDateTime::currentDateTime();
+    auto panel = panels.createSolarPanel(SolarPanel(0, "Bench roof", *user, now, now));
+    if (!panel) {
+        return false;
+    }
+    fixture.panelId = panel->id();
+
+    SensorRepository sensors;
+    auto sensor = sensors.createSensor(Sensor(0, *panel, SensorType(seededSensorTypeId, "temperature")));
+    if (!sensor) {
+        return false;
+    }
+    fixture.sensorId = sensor->id();
+
+    fixture.lastReading = now;
+    fixture.firstReading = now.addMSecs(-qint64(seededReadings - 1) * readingIntervalMs);
+
+    QList<PendingMeasurement> readings;
+    readings.reserve(seededReadings);
+    for (int i = 0; i < seededReadings; ++i) {
+        readings.append(PendingMeasurement{fixture.sensorId, 20.0 + (i % 600) / 60.0,
+                                           fixture.firstReading.addMSecs(qint64(i) * readingIntervalMs)});
+    }
+
+    MeasurementRepository measurements;
+    QList<InsertedMeasurement> inserted;
+    fixture.readings = measurements.insertMeasurements(readings, &inserted);
+    if (fixture.readings <= 0) {
+        return false;
+    }
+    fixture.measurementId = inserted.at(inserted.size() / 2).point.id;
+
+    seeded = fixture;
+    return true;
+}
+
+}
+
+namespace BenchDatabase {
+
+bool setUp()
+{
+    if (qEnvironmentVariableIsEmpty("PGHOST")) {
+        std::fprintf(stderr, "PGHOST is not set; repository benchmarks will be skipped.\n");
+        return false;
+    }
+
+    ConnectionPool::Settings settings;
+    settings.host = qEnvironmentVariable("PGHOST");
+    settings.port = qEnvironmentVariable("PGPORT", "5432").toInt();
+    settings.userName = qEnvironmentVariable("PGUSER", "kirixo");
+    settings.password = qEnvironmentVariable("PGPASSWORD");
+    settings.databaseName = qEnvironmentVariable("PGDATABASE", "arkanovadb");
+    settings.minSize = 1;
+    settings.maxSize = 2;
+    if (!DBController::connect(settings)) {
+        std::fprintf(stderr, "Could not connect to PostgreSQL: %s\n",
+                     qPrintable(DBController::getDatabase().lastError().text()));
+        return false;
+    }
+
+    // Repository benchmarks measure the database paths, not the in-memory window.
+    HotWindowStore::Settings hotWindow;
+    hotWindow.enabled = false;
+    HotWindowStore::instance().configure(hotWindow);
+
+    PartitionManager partitions(PartitionManager::Settings{});
+    partitions.maintain();
+
+    if (!seed()) {
+        std::fprintf(stderr, "Seeding the benchmark database failed; repository benchmarks will be skipped.\n");
+        return false;
+    }
+    return true;
+}
+
+const Fixture *fixture()
+{
+    return seeded ? &*seeded : nullptr;
+}
+
+}
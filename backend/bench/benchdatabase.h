@@ -0,0 +1,30 @@
+#ifndef BENCHDATABASE_H
+#define BENCHDATABASE_H
+
+#include <QDateTime>
+
+// The PostgreSQL the repository benchmarks run against and the rows seeded into it once per
+// run. The connection comes from the standard PGHOST, PGPORT, PGUSER, PGPASSWORD and
+// PGDATABASE variables, which run-benchmarks.sh sets; without PGHOST nothing is attempted and
+// the benchmarks that need the database are skipped.
+namespace BenchDatabase {
+
+struct Fixture {
+    qint64 userId = 0;
+    qint64 panelId = 0;
+    qint64 sensorId = 0;
+    qint64 measurementId = 0;     // One of the seeded readings
+    QDateTime firstReading;
+    QDateTime lastReading;
+    int readings = 0;
+};
+
+// Connects and seeds; returns false when the benchmarks run without a database.
+bool setUp();
+
+// nullptr when setUp() found no database.
+const Fixture* fixture();
+
+}
+
+#endif // BENCHDATABASE_H
@@ -0,0 +1,27 @@
+#include <QCoreApplication>
+#include <benchmark/benchmark.h>
+#include "benchdatabase.h"
+#include "../utils/logger.h"
+
+// Runs the ArkaNova micro-benchmarks. Pass --benchmark_out=<file> --benchmark_out_format=json
+// to keep the results for comparing builds; run-benchmarks.sh does so against a throwaway
+// PostgreSQL.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Log lines would interleave with the report.
+    Logger::instance().enableConsoleOutput(false);
+    Logger::instance().setLogLevel(Logger::LogLevel::Info);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    BenchDatabase::setUp();
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include <QString>
+#include "../utils/logevent.h"
+#include "../utils/logger.h"
+
+namespace {
+
+// Blocking on a full queue instead of dropping makes the figure the sustained rate the writer
+// thread keeps up with, not the cost of discarding lines.
+void configureLogger()
+{
+    Logger::Settings settings;
+    settings.overflowPolicy = Logger::OverflowPolicy::Block;
+    Logger::instance().configure(settings);
+    Logger::instance().setLogLevel(Logger::LogLevel::Info);
+}
+
+}
+
+// What a handler pays per line with state.threads() threads logging at once.
+static void BM_LoggerLog(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        configureLogger();
+    }
+    QString message = QString("Request handled on worker %1").arg(state.thread_index());
+    for (auto _ : state) {
+        Logger::instance().log(message, Logger::LogLevel::Info);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        Logger::instance().flush();
+    }
+}
+BENCHMARK(BM_LoggerLog)->ThreadRange(1, 8)->UseRealTime();
+
+// A line below the configured level.
+static void BM_LoggerLogFiltered(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        configureLogger();
+    }
+    QString message("Not written");
+    for (auto _ : state) {
+        Logger::instance().log(message, Logger::LogLevel::Debug);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerLogFiltered)->ThreadRange(1, 8)->UseRealTime();
+
+// A structured event built and queued on every call.
+static void BM_LogEventWrite(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        configureLogger();
+    }
+    static LogSite site("bench.event", Logger::LogLevel::Info);
+    for (auto _ : state) {
+        if (site.shouldLog()) {
+            LogEvent(site).add("topic", QStringView(u"arkanova/sensors/3")).add("bytes", 64).add("value", 21.375).write();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        Logger::instance().flush();
+    }
+}
+BENCHMARK(BM_LogEventWrite)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include "benchdatabase.h"
+#include "../routes/mqttmeasurementhandler.h"
+
+namespace {
+
+enum class Payload { Valid, MissingFields, InvalidJson };
+
+}
+
+// MqttMeasurementHandler on one payload kind: parse, validate and, for valid readings, queue
+// them on the batcher. The batcher is flushed, and waited for, with the clock stopped before it
+// would flush on its own, so the database write is not part of the figure; valid readings therefore need the
+// benchmark database, rejected ones do not.
+static void BM_MqttPayload(benchmark::State& state)
+{
+    auto payload = Payload(state.range(0));
+    const BenchDatabase::Fixture* fixture = BenchDatabase::fixture();
+    if (payload == Payload::Valid && !fixture) {
+        state.SkipWithError("valid readings are flushed to the benchmark database, which is not available");
+        return;
+    }
+
+    QByteArray message;
+    switch (payload) {
+    case Payload::Valid:
+        message = QString(R"({"sensor_id": %1, "data": 21.375})").arg(fixture->sensorId).toUtf8();
+        break;
+    case Payload::MissingFields:
+        message = R"({"sensor": 3, "value": 21.375})";
+        break;
+    case Payload::InvalidJson:
+        message = R"({"sensor_id": 3, "data": 21.375)";
+        break;
+    }
+
+    MeasurementBatcher::Settings settings;
+    settings.batchSize = 1 << 16;
+    settings.maxPending = settings.batchSize;
+    settings.metricsLogIntervalMs = 0;
+    auto batcher = std::make_shared<MeasurementBatcher>(settings);
+    MqttMeasurementHandler handler(batcher);
+
+    int queued = 0;
+    for (auto _ : state) {
+        handler.saveMeasurementToDatabase(message);
+        if (payload == Payload::Valid && ++queued == settings.batchSize - 1) {
+            state.PauseTiming();
+            batcher->flushAndWait();
+            queued = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(BM_MqttPayload)
+    ->ArgName("payload")
+    ->Arg(int(Payload::Valid))
+    ->Arg(int(Payload::MissingFields))
+    ->Arg(int(Payload::InvalidJson));
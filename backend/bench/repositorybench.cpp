@@ -0,0 +1,252 @@
+#include <benchmark/benchmark.h>
+#include "benchdatabase.h"
+#include "../repositories/hotwindowstore.h"
+#include "../repositories/measurementrepository.h"
+#include "../repositories/metadatacache.h"
+#include "../repositories/sensorrepository.h"
+#include "../repositories/userrepository.h"
+
+// Repository methods against the seeded benchmark database: a week of readings, one every 6 s,
+// on a single sensor. The hot window is off, so range reads go to PostgreSQL, except where a
+// benchmark turns it on for itself.
+
+namespace {
+
+const BenchDatabase::Fixture* requireDatabase(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = BenchDatabase::fixture();
+    if (!fixture) {
+        state.SkipWithError("benchmark database not available");
+    }
+    return fixture;
+}
+
+// Reads a cursor to the end, as a streaming handler would.
+template <typename T>
+qint64 consume(RowCursor<T> cursor)
+{
+    qint64 rows = 0;
+    while (auto row = cursor.next()) {
+        benchmark::DoNotOptimize(*row);
+        ++rows;
+    }
+    return rows;
+}
+
+}
+
+static void BM_UserRepositoryFindById(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    UserRepository users;
+    for (auto _ : state) {
+        state.PauseTiming();
+        MetadataCache::instance().clear();
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(users.findUserById(fixture->userId));
+    }
+}
+BENCHMARK(BM_UserRepositoryFindById);
+
+// range(0) == 1 leaves the metadata cache warm; 0 clears it before every call.
+static void BM_SensorRepositoryGetById(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    bool cached = state.range(0) != 0;
+    SensorRepository sensors;
+    for (auto _ : state) {
+        if (!cached) {
+            state.PauseTiming();
+            MetadataCache::instance().clear();
+            state.ResumeTiming();
+        }
+        benchmark::DoNotOptimize(sensors.getSensorById(fixture->sensorId));
+    }
+}
+BENCHMARK(BM_SensorRepositoryGetById)->ArgName("cached")->Arg(0)->Arg(1);
+
+static void BM_MeasurementRepositoryFetchById(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    MeasurementRepository measurements;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(measurements.fetchById(fixture->measurementId));
+    }
+}
+BENCHMARK(BM_MeasurementRepositoryFetchById);
+
+static void BM_MeasurementRepositoryCreate(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    MeasurementRepository measurements;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(measurements.createMeasurement(21.375, fixture->sensorId));
+    }
+}
+BENCHMARK(BM_MeasurementRepositoryCreate);
+
+// One ingest flush of state.range(0) readings.
+static void BM_MeasurementRepositoryInsertBatch(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    QList<PendingMeasurement> batch;
+    QDateTime now = QDateTime::currentDateTime();
+    for (int i = 0; i < state.range(0); ++i) {
+        batch.append(PendingMeasurement{fixture->sensorId, 20.0 + i % 10, now.addMSecs(i)});
+    }
+    MeasurementRepository measurements;
+    for (auto _ : state) {
+        QList<InsertedMeasurement> inserted;
+        benchmark::DoNotOptimize(measurements.insertMeasurements(batch, &inserted));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MeasurementRepositoryInsertBatch)->Arg(100)->Arg(500);
+
+// The first page of the newest state.range(0) readings.
+static void BM_MeasurementRepositoryOpenPage(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    MeasurementRepository measurements;
+    int limit = int(state.range(0));
+    qint64 rows = 0;
+    for (auto _ : state) {
+        rows += consume(measurements.openPage(fixture->sensorId, fixture->firstReading, fixture->lastReading,
+                                              std::nullopt, limit));
+    }
+    state.SetItemsProcessed(rows);
+}
+BENCHMARK(BM_MeasurementRepositoryOpenPage)->Arg(100)->Arg(1000);
+
+// A page that starts in the hot window and continues from the database. Also checks that both
+// halves render the same way: every row of the seeded temperature sensor must show its value.
+static void BM_MeasurementRepositoryOpenPageHotWindow(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    HotWindowStore& hotWindow = HotWindowStore::instance();
+    HotWindowStore::Settings settings;
+    settings.enabled = true;
+    hotWindow.configure(settings);
+
+    // Coverage starts a second after configure(); these readings land after that.
+    constexpr int hotRows = 50;
+    QList<PendingMeasurement> batch;
+    QDateTime hotStart = QDateTime::currentDateTime().addSecs(2);
+    for (int i = 0; i < hotRows; ++i) {
+        batch.append(PendingMeasurement{fixture->sensorId, 20.0 + i % 10, hotStart.addMSecs(i * 10)});
+    }
+    MeasurementRepository measurements;
+    QList<InsertedMeasurement> inserted;
+    measurements.insertMeasurements(batch, &inserted);
+    for (const InsertedMeasurement& row : std::as_const(inserted)) {
+        hotWindow.append(row.sensorId, row.point);
+    }
+
+    QDateTime end = hotStart.addSecs(60);
+    int limit = hotRows * 2;
+    qint64 rows = 0;
+    QString mismatch;
+    for (auto _ : state) {
+        auto cursor = measurements.openPage(fixture->sensorId, fixture->firstReading, end, std::nullopt, limit);
+        int fromMemory = 0;
+        int fromDatabase = 0;
+        while (auto row = cursor.next()) {
+            bool hot = row->measurement.recordedAt() >= hotStart.addMSecs(-1);
+            if (hot) {
+                ++fromMemory;
+            } else {
+                ++fromDatabase;
+            }
+            if (row->measurement.value() && !row->measurement.reportedValue()) {
+                mismatch = QString("a %1 row hides its value").arg(hot ? "hot window" : "database");
+            }
+            benchmark::DoNotOptimize(*row);
+            ++rows;
+        }
+        if (mismatch.isEmpty() && (fromMemory == 0 || fromDatabase == 0)) {
+            mismatch = "the page does not straddle the hot-window boundary";
+        }
+        if (!mismatch.isEmpty()) {
+            break;
+        }
+    }
+
+    hotWindow.configure(HotWindowStore::Settings());
+    hotWindow.clear();
+    if (!mismatch.isEmpty()) {
+        state.SkipWithError(mismatch.toStdString().c_str());
+        return;
+    }
+    state.SetItemsProcessed(rows);
+}
+BENCHMARK(BM_MeasurementRepositoryOpenPageHotWindow);
+
+// The last state.range(0) hours as a series.
+static void BM_MeasurementRepositoryOpenSeries(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    MeasurementRepository measurements;
+    QDateTime start = fixture->lastReading.addSecs(-state.range(0) * 3600);
+    qint64 rows = 0;
+    for (auto _ : state) {
+        rows += consume(measurements.openSeries(fixture->sensorId, start, fixture->lastReading));
+    }
+    state.SetItemsProcessed(rows);
+}
+BENCHMARK(BM_MeasurementRepositoryOpenSeries)->ArgName("hours")->Arg(1)->Arg(24);
+
+// The whole seeded week in buckets of state.range(0) seconds.
+static void BM_MeasurementRepositoryAggregate(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    MeasurementBucket::Aggregates aggregates = MeasurementBucket::Aggregates(MeasurementBucket::Aggregate::Min)
+                                               | MeasurementBucket::Aggregate::Max
+                                               | MeasurementBucket::Aggregate::Avg;
+    MeasurementRepository measurements;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(measurements.aggregateBySensor(fixture->sensorId, fixture->firstReading,
+                                                                fixture->lastReading, state.range(0),
+                                                                aggregates));
+    }
+}
+BENCHMARK(BM_MeasurementRepositoryAggregate)->ArgName("bucket_seconds")->Arg(3600)->Arg(86400);
+
+static void BM_MeasurementRepositoryLatestPoint(benchmark::State& state)
+{
+    const BenchDatabase::Fixture* fixture = requireDatabase(state);
+    if (!fixture) {
+        return;
+    }
+    MeasurementRepository measurements;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(measurements.getLatestPointBySensorId(fixture->sensorId));
+    }
+}
+BENCHMARK(BM_MeasurementRepositoryLatestPoint);
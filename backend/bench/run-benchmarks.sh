@@ -0,0 +1,51 @@
+#!/bin/bash
+# Runs ArkaNova_bench against a throwaway PostgreSQL built from db/ArkaNova.sql and writes the
+# results as JSON, so runs from two builds can be compared with benchmark's compare.py.
+#
+# Usage: bench/run-benchmarks.sh <build dir> [results.json] [extra benchmark flags...]
+
+set -euo pipefail
+
+if [ $# -lt 1 ]; then
+  echo "Usage: $0 <build dir> [results.json] [extra benchmark flags...]"
+  exit 1
+fi
+
+BUILD_DIR="$1"
+OUT="${2:-bench-results.json}"
+shift $(( $# >= 2 ? 2 : 1 ))
+
+BENCH="${BUILD_DIR}/ArkaNova_bench"
+if [ ! -x "${BENCH}" ]; then
+  echo "${BENCH} not found; configure with -DARKANOVA_BUILD_BENCHMARKS=ON and build it first."
+  exit 1
+fi
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+SCHEMA="${SCRIPT_DIR}/../../db/ArkaNova.sql"
+CONTAINER="arkanova-bench-$$"
+PORT="${BENCH_PG_PORT:-55432}"
+
+docker run -d --rm --name "${CONTAINER}" \
+  -e POSTGRES_USER=kirixo \
+  -e POSTGRES_PASSWORD=1111 \
+  -e POSTGRES_DB=arkanovadb \
+  -p "${PORT}:5432" \
+  -v "${SCHEMA}:/docker-entrypoint-initdb.d/ArkaNova.sql:ro" \
+  postgres:15 > /dev/null
+trap 'docker stop "${CONTAINER}" > /dev/null' EXIT
+
+# The entrypoint restarts the server once the schema is loaded, so wait for the schema itself
+# over TCP rather than for the first accepted connection.
+echo "Waiting for PostgreSQL on port ${PORT}..."
+for _ in $(seq 1 60); do
+  if docker exec "${CONTAINER}" psql -h 127.0.0.1 -U kirixo -d arkanovadb -tAc "SELECT 1 FROM sensor_type LIMIT 1" > /dev/null 2>&1; then
+    break
+  fi
+  sleep 1
+done
+
+PGHOST=127.0.0.1 PGPORT="${PORT}" PGUSER=kirixo PGPASSWORD=1111 PGDATABASE=arkanovadb \
+  "${BENCH}" --benchmark_out="${OUT}" --benchmark_out_format=json "$@"
+
+echo "Results written to ${OUT}"
@@ -0,0 +1,134 @@
+#include <benchmark/benchmark.h>
+#include <QJsonDocument>
+#include <memory>
+#include "../models/measurement.h"
+#include "../repositories/measurementrepository.h"
+#include "../routes/jsonliststream.h"
+
+namespace {
+
+Sensor benchSensor()
+{
+    QDateTime createdAt = QDateTime::currentDateTime();
+    User user(1, "bench@arkanova.local", "bench");
+    SolarPanel panel(2, "Bench roof", user, createdAt, createdAt);
+    return Sensor(3, panel, SensorType(1, "temperature"));
+}
+
+QList<MeasurementRow> benchRows(qsizetype count)
+{
+    Sensor sensor = benchSensor();
+    QDateTime start = QDateTime::currentDateTime();
+    QList<MeasurementRow> rows;
+    rows.reserve(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        QDateTime recordedAt = start.addSecs(-i * 6);
+        rows.append(MeasurementRow{Measurement(quint64(i + 1), 20.0 + double(i % 100) / 10, recordedAt, sensor),
+                                   MeasurementKey{recordedAt.toMSecsSinceEpoch() * 1000, i + 1}});
+    }
+    return rows;
+}
+
+// Serves `rows` the way a repository cursor would.
+template <typename T>
+std::shared_ptr<RowCursor<T>> memoryCursor(const QList<T>& rows)
+{
+    auto index = std::make_shared<qsizetype>(0);
+    return std::make_shared<RowCursor<T>>([rows, index]() -> std::optional<T> {
+        if (*index >= rows.size()) {
+            return std::nullopt;
+        }
+        return rows.at((*index)++);
+    });
+}
+
+// Drains a producer the way JsonStreamDevice does, returning the bytes written.
+qint64 drain(JsonStreamDevice::Producer& producer, QByteArray& out)
+{
+    qint64 bytes = 0;
+    for (;;) {
+        bool more = producer(out);
+        if (out.size() >= 16 * 1024 || !more) {
+            bytes += out.size();
+            out.clear();
+        }
+        if (!more) {
+            return bytes;
+        }
+    }
+}
+
+}
+
+// The single-object responses, which still go through QJsonObject.
+static void BM_MeasurementToJson(benchmark::State& state)
+{
+    Measurement measurement(42, 21.5, QDateTime::currentDateTime(), benchSensor());
+    for (auto _ : state) {
+        QByteArray json = QJsonDocument(measurement.toJson()).toJson(QJsonDocument::Compact);
+        benchmark::DoNotOptimize(json.data());
+    }
+}
+BENCHMARK(BM_MeasurementToJson);
+
+static void BM_MeasurementWriteJson(benchmark::State& state)
+{
+    Measurement measurement(42, 21.5, QDateTime::currentDateTime(), benchSensor());
+    QByteArray out;
+    out.reserve(1024);
+    for (auto _ : state) {
+        out.clear();
+        measurement.writeJson(out);
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_MeasurementWriteJson);
+
+// The body of /api/measurement/list/sensor for a page of state.range(0) rows.
+static void BM_MeasurementListJson(benchmark::State& state)
+{
+    QList<MeasurementRow> rows = benchRows(state.range(0));
+    QByteArray out;
+    qint64 bytes = 0;
+    for (auto _ : state) {
+        auto lastKey = std::make_shared<MeasurementKey>();
+        JsonStreamDevice::Producer producer = makeJsonListProducer<MeasurementRow>(
+            "measurements", memoryCursor(rows), rows.size(),
+            [lastKey](QByteArray& out, const MeasurementRow& row) {
+                row.measurement.writeJson(out);
+                *lastKey = row.key;
+            },
+            [lastKey](QByteArray& out, qint64 rows, bool hasMore) {
+                out.append(",\"count\":").append(QByteArray::number(rows));
+                out.append(",\"next_cursor\":");
+                out.append(hasMore ? '"' + lastKey->encode() + '"' : QByteArray("null"));
+            });
+        bytes += drain(producer, out);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_MeasurementListJson)->Arg(100)->Arg(1000)->Arg(5000);
+
+// The body of /api/sensor/list/solarpanel.
+static void BM_SensorListJson(benchmark::State& state)
+{
+    Sensor sensor = benchSensor();
+    QList<Sensor> sensors(state.range(0), sensor);
+    QByteArray out;
+    qint64 bytes = 0;
+    for (auto _ : state) {
+        JsonStreamDevice::Producer producer = makeJsonListProducer<Sensor>(
+            "sensors", memoryCursor(sensors), std::numeric_limits<qint64>::max(),
+            [](QByteArray& out, const Sensor& sensor) {
+                sensor.writeJson(out);
+            },
+            [](QByteArray& out, qint64 rows, bool) {
+                out.append(",\"total_count\":").append(QByteArray::number(rows));
+            });
+        bytes += drain(producer, out);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_SensorListJson)->Arg(10)->Arg(100);
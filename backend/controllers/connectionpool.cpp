@@ -0,0 +1,322 @@
+#include "connectionpool.h"
+#include "dbcontroller.h"
+#include "statementcache.h"
+#include <QDeadlineTimer>
+#include <QThread>
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+#include <QDebug>
+
+ConnectionPool::Lease::Lease()
+    : db_(DBController::pool().acquire()), held_(db_.isOpen())
+{
+}
+
+ConnectionPool::Lease::~Lease()
+{
+    if (held_) {
+        DBController::pool().release();
+    }
+}
+
+QSqlDatabase ConnectionPool::Lease::database() const
+{
+    return db_;
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    closeAll();
+}
+
+void ConnectionPool::configure(const Settings &settings)
+{
+    QMutexLocker locker(&mutex_);
+    settings_ = settings;
+    if (settings_.maxSize < 1) {
+        settings_.maxSize = 1;
+    }
+    settings_.minSize = qBound(0, settings_.minSize, settings_.maxSize);
+}
+
+const ConnectionPool::Settings &ConnectionPool::settings() const
+{
+    return settings_;
+}
+
+QSqlDatabase ConnectionPool::acquire()
+{
+    QThread* thread = QThread::currentThread();
+    std::shared_ptr<Slot> slot;
+    bool needsOpen = false;
+    bool closeRetired = false;
+
+    {
+        QMutexLocker locker(&mutex_);
+        slot = slots_.value(thread);
+
+        if (!slot || !slot->reserved) {
+            // Opening a connection for this thread needs a free slot under maxSize.
+            QDeadlineTimer deadline(settings_.acquireTimeoutMs);
+            while (openCountLocked() >= settings_.maxSize && !evictOneIdleLocked()) {
+                if (!slotFreed_.wait(&mutex_, deadline)) {
+                    ++acquireTimeouts_;
+                    qWarning() << "Connection pool exhausted: no connection freed within"
+                               << settings_.acquireTimeoutMs << "ms";
+                    return QSqlDatabase();
+                }
+            }
+
+            if (!slot) {
+                slot = std::make_shared<Slot>();
+                slot->name = QString("arkanova_pool_%1").arg(++nextConnectionId_);
+                slot->owner = thread;
+                slots_.insert(thread, slot);
+                QObject::connect(thread, &QThread::finished, [this, thread]() {
+                    dropThread(thread);
+                });
+            }
+            closeRetired = slot->retired;
+            slot->retired = false;
+            slot->reserved = true;
+            needsOpen = true;
+        }
+
+        ++slot->borrowDepth;
+        ++borrows_;
+    }
+
+    // Closing, connecting and pinging happen outside the lock; only the owning thread touches
+    // its slot's connection.
+    if (needsOpen) {
+        if (closeRetired) {
+            slot->db.close();
+        }
+        if (!openSlot(*slot)) {
+            QMutexLocker locker(&mutex_);
+            slot->reserved = false;
+            --slot->borrowDepth;
+            --borrows_;
+            slotFreed_.wakeOne();
+        }
+    } else if (slot->borrowDepth == 1) {
+        ensureHealthy(*slot);
+    }
+
+    return slot->db;
+}
+
+void ConnectionPool::release()
+{
+    QMutexLocker locker(&mutex_);
+    auto slot = slots_.value(QThread::currentThread());
+    if (!slot || slot->borrowDepth == 0) {
+        return;
+    }
+
+    ++returns_;
+    if (--slot->borrowDepth == 0) {
+        slot->idleSince.start();
+        slotFreed_.wakeOne();
+    }
+}
+
+QSqlDatabase ConnectionPool::current()
+{
+    std::shared_ptr<Slot> slot;
+    bool leased = false;
+    {
+        QMutexLocker locker(&mutex_);
+        slot = slots_.value(QThread::currentThread());
+        leased = slot && slot->borrowDepth > 0 && slot->reserved;
+    }
+
+    // Only the owning thread changes borrowDepth, and the reaper leaves borrowed slots alone.
+    if (leased) {
+        if (!slot->db.isOpen()) {
+            openSlot(*slot); // Lost its connection after a failed health check; try again.
+        }
+        return slot->db;
+    }
+
+    // No lease on this thread: borrow for this call only. A retired connection is closed and
+    // reopened by acquire(), and never underneath this call since only this thread closes it.
+    QSqlDatabase db = acquire();
+    release();
+    return db;
+}
+
+int ConnectionPool::reapIdle()
+{
+    QMutexLocker locker(&mutex_);
+    int closed = 0;
+
+    for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+        Slot& slot = *it.value();
+        if (openCountLocked() <= settings_.minSize) {
+            break;
+        }
+        if (!slot.reserved || slot.borrowDepth > 0) {
+            continue;
+        }
+        if (slot.idleSince.isValid() && slot.idleSince.elapsed() >= settings_.idleTimeoutMs) {
+            retireLocked(slot);
+            ++closed;
+        }
+    }
+
+    if (closed > 0) {
+        slotFreed_.wakeAll();
+    }
+    return closed;
+}
+
+void ConnectionPool::closeAll()
+{
+    QMutexLocker locker(&mutex_);
+    for (auto &slot : slots_) {
+        if (slot->db.isOpen()) {
+            slot->db.close();
+        }
+        slot->reserved = false;
+        slot->retired = false;
+    }
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const
+{
+    QMutexLocker locker(&mutex_);
+    Stats stats;
+    for (const auto &slot : slots_) {
+        if (slot->retired) {
+            ++stats.retired;
+        }
+        if (!slot->reserved) {
+            continue;
+        }
+        ++stats.open;
+        if (slot->borrowDepth > 0) {
+            ++stats.borrowed;
+        } else {
+            ++stats.idle;
+        }
+    }
+    stats.borrows = borrows_;
+    stats.returns = returns_;
+    stats.opened = opened_;
+    stats.reaped = reaped_;
+    stats.healthCheckFailures = healthCheckFailures_;
+    stats.acquireTimeouts = acquireTimeouts_;
+    return stats;
+}
+
+bool ConnectionPool::openSlot(Slot &slot)
+{
+    if (!slot.db.isValid()) {
+        slot.db = QSqlDatabase::addDatabase("QPSQL", slot.name);
+        slot.db.setHostName(settings_.host);
+        slot.db.setUserName(settings_.userName);
+        slot.db.setPassword(settings_.password);
+        slot.db.setDatabaseName(settings_.databaseName);
+        slot.db.setPort(settings_.port);
+    }
+
+    // Runs on the owning thread. Statements prepared on a previous connection died with it,
+    // whether the reaper, a failed health check or an eviction closed it.
+    StatementCache::local().reset(slot.name);
+
+    if (!slot.db.open()) {
+        qWarning() << "Connection pool failed to open" << slot.name << ":" << slot.db.lastError().text();
+        return false;
+    }
+
+    slot.lastChecked.start();
+    QMutexLocker locker(&mutex_);
+    ++opened_;
+    return true;
+}
+
+bool ConnectionPool::ensureHealthy(Slot &slot)
+{
+    if (slot.lastChecked.isValid() && slot.lastChecked.elapsed() < settings_.healthCheckIntervalMs) {
+        return true;
+    }
+
+    QSqlQuery ping(slot.db);
+    if (slot.db.isOpen() && ping.exec("SELECT 1")) {
+        slot.lastChecked.start();
+        return true;
+    }
+
+    qWarning() << "Connection" << slot.name << "failed health check, reconnecting:" << ping.lastError().text();
+    {
+        QMutexLocker locker(&mutex_);
+        ++healthCheckFailures_;
+    }
+    ping.finish();
+    StatementCache::local().reset();
+    slot.db.close();
+    return openSlot(slot);
+}
+
+bool ConnectionPool::evictOneIdleLocked()
+{
+    std::shared_ptr<Slot> victim;
+    for (const auto &slot : slots_) {
+        if (!slot->reserved || slot->borrowDepth > 0 || !slot->idleSince.isValid()) {
+            continue;
+        }
+        if (!victim || slot->idleSince.elapsed() > victim->idleSince.elapsed()) {
+            victim = slot;
+        }
+    }
+
+    if (!victim) {
+        return false;
+    }
+
+    retireLocked(*victim);
+    return true;
+}
+
+void ConnectionPool::retireLocked(Slot &slot)
+{
+    // Closing it here would use the connection from a thread other than its owner; the owner
+    // closes it on its next acquire(), or dropThread() does when the thread finishes.
+    slot.reserved = false;
+    slot.retired = true;
+    ++reaped_;
+}
+
+void ConnectionPool::dropThread(QThread *thread)
+{
+    std::shared_ptr<Slot> slot;
+    {
+        QMutexLocker locker(&mutex_);
+        slot = slots_.take(thread);
+        slotFreed_.wakeAll();
+    }
+    if (!slot) {
+        return;
+    }
+
+    // QThread::finished is emitted from the finishing thread itself, so the connection
+    // is removed from the thread that owns it.
+    const QString name = slot->name;
+    StatementCache::local().reset();
+    slot->db.close();
+    slot->db = QSqlDatabase();
+    slot.reset();
+    QSqlDatabase::removeDatabase(name);
+}
+
+int ConnectionPool::openCountLocked() const
+{
+    int open = 0;
+    for (const auto &slot : slots_) {
+        if (slot->reserved) {
+            ++open;
+        }
+    }
+    return open;
+}
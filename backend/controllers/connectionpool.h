@@ -0,0 +1,121 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QtSql/QSqlDatabase>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <memory>
+
+class QThread;
+
+// Qt only allows a QSqlDatabase to be used from the thread that opened it, so the pool
+// hands every thread its own named connection and caps how many of them are in service.
+// Connections are only ever closed by their own thread: the reaper and eviction retire an
+// idle slot, which frees its place under maxSize at once, but the connection stays open until
+// the owner closes it on its next acquire() or when it finishes. The server can therefore see
+// up to maxSize connections in service plus the retired ones (Stats::retired) still open.
+class ConnectionPool
+{
+public:
+    struct Settings {
+        QString host;
+        QString userName;
+        QString password;
+        QString databaseName;
+        int port = 5432;
+        int minSize = 1;                 // Connections the reaper never closes
+        int maxSize = 8;                 // Cap on connections in service; retired ones still open are not counted
+        int idleTimeoutMs = 300000;      // Unborrowed connections idle longer than this get closed
+        int healthCheckIntervalMs = 30000; // A borrowed connection older than this is pinged first
+        int acquireTimeoutMs = 5000;     // How long a thread waits for a free slot when the pool is full
+    };
+
+    struct Stats {
+        int open = 0;                    // In service: borrowed or idle, excluding retired
+        int borrowed = 0;
+        int idle = 0;
+        int retired = 0;                 // Still connected, waiting for their thread to close them
+        quint64 borrows = 0;
+        quint64 returns = 0;
+        quint64 opened = 0;
+        quint64 reaped = 0;
+        quint64 healthCheckFailures = 0;
+        quint64 acquireTimeouts = 0;
+    };
+
+    // Borrows the calling thread's connection for the lifetime of the object.
+    class Lease
+    {
+    public:
+        Lease();
+        ~Lease();
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        QSqlDatabase database() const;
+
+    private:
+        QSqlDatabase db_;
+        bool held_;
+    };
+
+    ConnectionPool() = default;
+    ~ConnectionPool();
+
+    void configure(const Settings& settings);
+    const Settings& settings() const;
+
+    // Returns the calling thread's connection and bumps its borrow depth. If no slot frees up
+    // within acquireTimeoutMs or the connection cannot be opened, nothing is borrowed and the
+    // returned database is not open.
+    QSqlDatabase acquire();
+    void release();
+
+    // Returns the calling thread's connection. Outside a Lease it is borrowed and returned
+    // at once, so it counts as idle between calls and may be retired then; code that keeps a
+    // query or transaction open across calls must hold a Lease.
+    QSqlDatabase current();
+
+    // Retires connections that have not been borrowed for idleTimeoutMs, keeping minSize open.
+    int reapIdle();
+    void closeAll();
+
+    Stats stats() const;
+
+private:
+    struct Slot {
+        QString name;
+        QSqlDatabase db;
+        QThread* owner = nullptr;
+        bool reserved = false;           // Open, or being opened, and counted against maxSize
+        bool retired = false;            // Released by the reaper or an eviction; the owner closes it
+        int borrowDepth = 0;
+        QElapsedTimer idleSince;
+        QElapsedTimer lastChecked;
+    };
+
+    bool openSlot(Slot& slot);
+    bool ensureHealthy(Slot& slot);
+    bool evictOneIdleLocked();
+    void retireLocked(Slot& slot);
+    void dropThread(QThread* thread);
+    int openCountLocked() const;
+
+    Settings settings_;
+    QHash<QThread*, std::shared_ptr<Slot>> slots_;
+    mutable QMutex mutex_;
+    QWaitCondition slotFreed_;
+    quint64 nextConnectionId_ = 0;
+
+    quint64 borrows_ = 0;
+    quint64 returns_ = 0;
+    quint64 opened_ = 0;
+    quint64 reaped_ = 0;
+    quint64 healthCheckFailures_ = 0;
+    quint64 acquireTimeouts_ = 0;
+};
+
+#endif // CONNECTIONPOOL_H
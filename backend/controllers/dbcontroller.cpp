@@ -1,33 +1,39 @@
 #include "dbcontroller.h"
 
-QSqlDatabase DBController::db;
+ConnectionPool DBController::pool_;
 
 bool DBController::connect(const QString &host, const QString &username, const QString &password, const QString &database, int port)
 {
-    db = QSqlDatabase::addDatabase("QPSQL");
-    db.setHostName(host);
-    db.setUserName(username);
-    db.setPassword(password);
-    db.setDatabaseName(database);
-    db.setPort(port);
-    if(db.open()){
-        return 1;
-    } else {
-        return 0;
-    }
+    ConnectionPool::Settings settings;
+    settings.host = host;
+    settings.userName = username;
+    settings.password = password;
+    settings.databaseName = database;
+    settings.port = port;
+    return connect(settings);
 }
 
+bool DBController::connect(const ConnectionPool::Settings &settings)
+{
+    pool_.configure(settings);
+    return getDatabase().isOpen();
+}
 
 bool DBController::close()
 {
-    if (db.isOpen()) {
-        db.close();
+    if (pool_.stats().open > 0) {
+        pool_.closeAll();
         return true;
     }
     return false;
 }
 
-QSqlDatabase& DBController::getDatabase()
+QSqlDatabase DBController::getDatabase()
+{
+    return pool_.current();
+}
+
+ConnectionPool& DBController::pool()
 {
-    return db;
+    return pool_;
 }
@@ -2,6 +2,7 @@
 #define DBCONTROLLER_H
 #include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlQuery>
+#include "connectionpool.h"
 
 class DBController
 {
@@ -9,11 +10,15 @@ public:
     DBController() = default;
 
     static bool connect(const QString& host, const QString& username, const QString& password, const QString& database, int port = 5432);
+    static bool connect(const ConnectionPool::Settings& settings);
     static bool close();
-    static QSqlDatabase& getDatabase();
+
+    // Connection owned by the calling thread; every thread gets its own from the pool.
+    static QSqlDatabase getDatabase();
+    static ConnectionPool& pool();
 
 private:
-    static QSqlDatabase db;
+    static ConnectionPool pool_;
 };
 
 #endif // DBCONTROLLER_H
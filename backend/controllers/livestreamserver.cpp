@@ -0,0 +1,356 @@
+#include "livestreamserver.h"
+#include "../repositories/sensorrepository.h"
+#include "../utils/jsonwriter.h"
+#include "../utils/logger.h"
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QWebSocket>
+#include <algorithm>
+
+LiveStreamServer::LiveStreamServer(const Settings &settings, QObject *parent)
+    : QObject(parent), settings_(settings), server_("ArkaNova live", QWebSocketServer::NonSecureMode)
+{
+    settings_.maxClients = qMax(1, settings_.maxClients);
+    settings_.maxSubscriptionsPerClient = qMax(1, settings_.maxSubscriptionsPerClient);
+    settings_.maxQueuedReadings = qMax(1, settings_.maxQueuedReadings);
+    settings_.maxBufferedBytes = qMax<qint64>(1, settings_.maxBufferedBytes);
+
+    server_.setMaxPendingConnections(settings_.maxClients);
+    connect(&server_, &QWebSocketServer::newConnection, this, &LiveStreamServer::onNewConnection);
+}
+
+LiveStreamServer::~LiveStreamServer()
+{
+    server_.close();
+    const QList<QWebSocket *> sockets = clients_.keys();
+    clients_.clear();
+    for (QWebSocket *socket : sockets) {
+        socket->disconnect(this);
+        socket->close(QWebSocketProtocol::CloseCodeGoingAway);
+        delete socket;
+    }
+}
+
+bool LiveStreamServer::listen()
+{
+    if (!server_.listen(QHostAddress::Any, quint16(settings_.port))) {
+        Logger::instance().log("Live stream: could not listen on port " + QString::number(settings_.port) + ": " +
+                                   server_.errorString(), Logger::LogLevel::Error);
+        return false;
+    }
+    Logger::instance().log("Live stream: listening on port " + QString::number(settings_.port), Logger::LogLevel::Info);
+    return true;
+}
+
+LiveStreamServer::Stats LiveStreamServer::stats() const
+{
+    Stats stats = stats_;
+    stats.clients = clients_.size();
+    return stats;
+}
+
+void LiveStreamServer::onNewConnection()
+{
+    while (server_.hasPendingConnections()) {
+        QWebSocket *socket = server_.nextPendingConnection();
+        if (clients_.size() >= settings_.maxClients) {
+            socket->close(QWebSocketProtocol::CloseCodePolicyViolated, "Too many clients");
+            socket->deleteLater();
+            continue;
+        }
+
+        // Subscription requests are small; anything larger is not a client of ours.
+        socket->setMaxAllowedIncomingMessageSize(64 * 1024);
+        clients_.insert(socket, Client{socket});
+
+        connect(socket, &QWebSocket::textMessageReceived, this, [this, socket](const QString &message) {
+            auto it = clients_.find(socket);
+            if (it != clients_.end()) {
+                handleMessage(*it, message);
+            }
+        });
+        connect(socket, &QWebSocket::bytesWritten, this, [this, socket](qint64 bytes) {
+            auto it = clients_.find(socket);
+            if (it != clients_.end()) {
+                it->bufferedBytes = qMax<qint64>(0, it->bufferedBytes - bytes);
+                sendPending(*it);
+            }
+        });
+        connect(socket, &QWebSocket::disconnected, this, [this, socket]() {
+            handleDisconnected(socket);
+        });
+
+        Logger::instance().log("Live stream: client connected from " + socket->peerAddress().toString(),
+                               Logger::LogLevel::Debug);
+    }
+}
+
+void LiveStreamServer::handleDisconnected(QWebSocket *socket)
+{
+    auto it = clients_.find(socket);
+    if (it == clients_.end()) {
+        return;
+    }
+
+    for (qint64 sensorId : std::as_const(it->sensors)) {
+        auto subscribers = sensorSubscribers_.find(sensorId);
+        subscribers->remove(socket);
+        if (subscribers->isEmpty()) {
+            sensorSubscribers_.erase(subscribers);
+        }
+    }
+    for (qint64 panelId : std::as_const(it->panels)) {
+        auto subscribers = panelSubscribers_.find(panelId);
+        subscribers->remove(socket);
+        if (subscribers->isEmpty()) {
+            panelSubscribers_.erase(subscribers);
+        }
+    }
+    clients_.erase(it);
+    socket->deleteLater();
+
+    Logger::instance().log("Live stream: client disconnected", Logger::LogLevel::Debug);
+}
+
+void LiveStreamServer::handleMessage(Client &client, const QString &message)
+{
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(message.toUtf8(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        sendError(client, "Expected a JSON object");
+        return;
+    }
+
+    QJsonObject request = document.object();
+    QString action = request.value("action").toString();
+    bool subscribe = action == "subscribe";
+    if (!subscribe && action != "unsubscribe") {
+        sendError(client, "Unknown action, expected subscribe or unsubscribe");
+        return;
+    }
+
+    auto apply = [&](const char *key, QSet<qint64> &subscribed, QHash<qint64, QSet<QWebSocket *>> &index) {
+        const QJsonArray ids = request.value(key).toArray();
+        for (const QJsonValue &value : ids) {
+            qint64 id = value.toInteger(-1);
+            if (id <= 0) {
+                continue;
+            }
+            if (!subscribe) {
+                if (subscribed.remove(id)) {
+                    auto subscribers = index.find(id);
+                    subscribers->remove(client.socket);
+                    if (subscribers->isEmpty()) {
+                        index.erase(subscribers);
+                    }
+                }
+                continue;
+            }
+            if (subscribed.contains(id)) {
+                continue;
+            }
+            if (client.sensors.size() + client.panels.size() >= settings_.maxSubscriptionsPerClient) {
+                return false;
+            }
+            subscribed.insert(id);
+            index[id].insert(client.socket);
+        }
+        return true;
+    };
+
+    bool withinLimit = apply("sensors", client.sensors, sensorSubscribers_);
+    withinLimit = withinLimit && apply("panels", client.panels, panelSubscribers_);
+    if (!withinLimit) {
+        sendError(client, QString("At most %1 subscriptions per connection").arg(settings_.maxSubscriptionsPerClient));
+    }
+    sendSubscriptions(client);
+}
+
+void LiveStreamServer::publish(const QList<InsertedMeasurement> &rows)
+{
+    if (clients_.isEmpty()) {
+        return;
+    }
+
+    QSet<QWebSocket *> touched;
+    // Same rule as the HTTP outputs; looked up once per sensor in the batch.
+    SensorRepository sensorRepository;
+    QHash<qint64, bool> reportsReadings;
+    for (const InsertedMeasurement &row : rows) {
+        Reading reading{row.sensorId, row.point};
+        auto shown = reportsReadings.constFind(row.sensorId);
+        if (shown == reportsReadings.cend()) {
+            shown = reportsReadings.insert(row.sensorId, sensorRepository.reportsReadings(row.sensorId));
+        }
+        if (!*shown) {
+            reading.point.value = std::nullopt;
+        }
+
+        auto sensorSubscribers = sensorSubscribers_.constFind(row.sensorId);
+        if (sensorSubscribers != sensorSubscribers_.cend()) {
+            for (QWebSocket *socket : *sensorSubscribers) {
+                enqueue(clients_[socket], reading);
+                touched.insert(socket);
+            }
+        }
+
+        if (panelSubscribers_.isEmpty()) {
+            continue;
+        }
+        auto panelSubscribers = panelSubscribers_.constFind(panelOf(row.sensorId));
+        if (panelSubscribers != panelSubscribers_.cend()) {
+            for (QWebSocket *socket : *panelSubscribers) {
+                Client &client = clients_[socket];
+                // Already queued through a sensor subscription
+                if (!client.sensors.contains(row.sensorId)) {
+                    enqueue(client, reading);
+                    touched.insert(socket);
+                }
+            }
+        }
+    }
+
+    for (QWebSocket *socket : std::as_const(touched)) {
+        sendPending(clients_[socket]);
+    }
+}
+
+void LiveStreamServer::enqueue(Client &client, const Reading &reading)
+{
+    client.queue.append(reading);
+    if (client.queue.size() <= settings_.maxQueuedReadings) {
+        return;
+    }
+
+    coalesce(client);
+    if (client.queue.size() > settings_.maxQueuedReadings) {
+        // More distinct sensors than the queue holds; the oldest readings go.
+        qsizetype excess = client.queue.size() - settings_.maxQueuedReadings;
+        client.queue.remove(0, excess);
+        client.coalesced += quint64(excess);
+        stats_.readingsCoalesced += quint64(excess);
+    }
+}
+
+void LiveStreamServer::coalesce(Client &client)
+{
+    QSet<qint64> seen;
+    QList<Reading> newest;
+    newest.reserve(client.queue.size());
+    for (auto it = client.queue.crbegin(); it != client.queue.crend(); ++it) {
+        if (!seen.contains(it->sensorId)) {
+            seen.insert(it->sensorId);
+            newest.append(*it);
+        }
+    }
+    std::reverse(newest.begin(), newest.end());
+
+    quint64 dropped = quint64(client.queue.size() - newest.size());
+    client.coalesced += dropped;
+    stats_.readingsCoalesced += dropped;
+    client.queue = std::move(newest);
+}
+
+void LiveStreamServer::sendPending(Client &client)
+{
+    if (client.queue.isEmpty() || client.bufferedBytes > settings_.maxBufferedBytes) {
+        return;
+    }
+
+    QByteArray frame;
+    frame.reserve(64 + client.queue.size() * 80);
+    frame.append('{');
+    JsonWriter::appendKey(frame, "type", true);
+    JsonWriter::appendString(frame, u"measurements");
+    JsonWriter::appendKey(frame, "coalesced");
+    JsonWriter::appendInt(frame, qint64(client.coalesced));
+    JsonWriter::appendKey(frame, "readings");
+    frame.append('[');
+    for (qsizetype i = 0; i < client.queue.size(); ++i) {
+        const Reading &reading = client.queue.at(i);
+        if (i > 0) {
+            frame.append(',');
+        }
+        frame.append('{');
+        JsonWriter::appendKey(frame, "sensor_id", true);
+        JsonWriter::appendInt(frame, reading.sensorId);
+        JsonWriter::appendKey(frame, "id");
+        JsonWriter::appendInt(frame, reading.point.id);
+        JsonWriter::appendKey(frame, "data");
+        JsonWriter::appendDouble(frame, reading.point.value);
+        JsonWriter::appendKey(frame, "recorded_at");
+        JsonWriter::appendInt(frame, reading.point.recordedAtMs());
+        frame.append('}');
+    }
+    frame.append("]}");
+
+    stats_.readingsSent += quint64(client.queue.size());
+    client.queue.clear();
+    client.coalesced = 0;
+    sendFrame(client, frame);
+}
+
+void LiveStreamServer::sendFrame(Client &client, const QByteArray &frame)
+{
+    qint64 sent = client.socket->sendTextMessage(QString::fromUtf8(frame));
+    client.bufferedBytes += qMax<qint64>(0, sent);
+    ++stats_.framesSent;
+}
+
+void LiveStreamServer::sendError(Client &client, const QString &message)
+{
+    QByteArray frame;
+    frame.append('{');
+    JsonWriter::appendKey(frame, "type", true);
+    JsonWriter::appendString(frame, u"error");
+    JsonWriter::appendKey(frame, "message");
+    JsonWriter::appendString(frame, message);
+    frame.append('}');
+    sendFrame(client, frame);
+}
+
+void LiveStreamServer::sendSubscriptions(Client &client)
+{
+    auto appendIds = [](QByteArray &out, const QSet<qint64> &ids) {
+        QList<qint64> sorted(ids.cbegin(), ids.cend());
+        std::sort(sorted.begin(), sorted.end());
+        out.append('[');
+        for (qsizetype i = 0; i < sorted.size(); ++i) {
+            if (i > 0) {
+                out.append(',');
+            }
+            JsonWriter::appendInt(out, sorted.at(i));
+        }
+        out.append(']');
+    };
+
+    QByteArray frame;
+    frame.append('{');
+    JsonWriter::appendKey(frame, "type", true);
+    JsonWriter::appendString(frame, u"subscribed");
+    JsonWriter::appendKey(frame, "sensors");
+    appendIds(frame, client.sensors);
+    JsonWriter::appendKey(frame, "panels");
+    appendIds(frame, client.panels);
+    frame.append('}');
+    sendFrame(client, frame);
+}
+
+qint64 LiveStreamServer::panelOf(qint64 sensorId)
+{
+    auto it = panelBySensor_.constFind(sensorId);
+    if (it != panelBySensor_.cend()) {
+        return *it;
+    }
+
+    // Served from MetadataCache after the first reading of each sensor
+    SensorRepository sensorRepository;
+    std::optional<Sensor> sensor = sensorRepository.getSensorById(sensorId);
+    qint64 panelId = sensor ? qint64(sensor->solarPanel().id()) : -1;
+    if (sensor) {
+        panelBySensor_.insert(sensorId, panelId);
+    }
+    return panelId;
+}
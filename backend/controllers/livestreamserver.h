@@ -0,0 +1,100 @@
+#ifndef LIVESTREAMSERVER_H
+#define LIVESTREAMSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QWebSocketServer>
+#include "../repositories/measurementrepository.h"
+
+class QWebSocket;
+
+// Pushes committed readings to WebSocket clients subscribed to sensor or panel ids, so
+// dashboards stop polling the REST endpoints. Everything runs on the thread that owns the
+// server, the same one the ingest batcher reports its commits on.
+//
+// Client -> server, one JSON object per text frame:
+//   {"action":"subscribe","sensors":[1,2],"panels":[3]}
+//   {"action":"unsubscribe","sensors":[2]}
+// Server -> client:
+//   {"type":"subscribed","sensors":[...],"panels":[...]}       current subscriptions
+//   {"type":"measurements","coalesced":0,"readings":[{"sensor_id":1,"id":..,"data":..,"recorded_at":..}]}
+//   {"type":"error","message":"..."}
+//
+// Each client has a bounded queue. While the socket has more than maxBufferedBytes unsent,
+// readings wait there; when the queue is full it keeps only the newest reading per sensor and
+// "coalesced" tells the client how many it missed, so a slow consumer never holds more than
+// maxQueuedReadings nor slows down ingest.
+class LiveStreamServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Settings {
+        bool enabled = true;
+        int port = 4926;
+        int maxClients = 1000;
+        int maxSubscriptionsPerClient = 1000;
+        int maxQueuedReadings = 1000;
+        qint64 maxBufferedBytes = 256 * 1024;
+    };
+
+    struct Stats {
+        int clients = 0;
+        quint64 framesSent = 0;
+        quint64 readingsSent = 0;
+        quint64 readingsCoalesced = 0;
+    };
+
+    explicit LiveStreamServer(const Settings &settings, QObject *parent = nullptr);
+    ~LiveStreamServer();
+
+    bool listen();
+
+    Stats stats() const;
+
+public slots:
+    // Connected to MeasurementBatcher::committed.
+    void publish(const QList<InsertedMeasurement> &rows);
+
+private slots:
+    void onNewConnection();
+
+private:
+    struct Reading {
+        qint64 sensorId;
+        MeasurementPoint point;
+    };
+
+    struct Client {
+        QWebSocket *socket = nullptr;
+        QSet<qint64> sensors;
+        QSet<qint64> panels;
+        QList<Reading> queue;
+        quint64 coalesced = 0;
+        qint64 bufferedBytes = 0;   // Sent to the socket but not yet written out
+    };
+
+    void handleMessage(Client &client, const QString &message);
+    void handleDisconnected(QWebSocket *socket);
+    void enqueue(Client &client, const Reading &reading);
+    // Keeps the newest reading of each sensor, in the order those readings arrived.
+    void coalesce(Client &client);
+    void sendPending(Client &client);
+    void sendFrame(Client &client, const QByteArray &frame);
+    void sendError(Client &client, const QString &message);
+    void sendSubscriptions(Client &client);
+    // The panel a sensor sits on, from MetadataCache; -1 for unknown sensors.
+    qint64 panelOf(qint64 sensorId);
+
+    Settings settings_;
+    QWebSocketServer server_;
+    QHash<QWebSocket *, Client> clients_;
+    QHash<qint64, QSet<QWebSocket *>> sensorSubscribers_;
+    QHash<qint64, QSet<QWebSocket *>> panelSubscribers_;
+    QHash<qint64, qint64> panelBySensor_;
+    Stats stats_;
+};
+
+#endif // LIVESTREAMSERVER_H
@@ -0,0 +1,226 @@
+#include "measurementbatcher.h"
+#include "../utils/logger.h"
+#include "../utils/logevent.h"
+#include "../utils/metrics.h"
+#include "../repositories/latestmeasurementtable.h"
+#include "../repositories/hotwindowstore.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+MeasurementBatcher::MeasurementBatcher(const Settings &settings, QObject *parent)
+    : QObject(parent), settings_(settings)
+{
+    settings_.batchSize = qMax(1, settings_.batchSize);
+    settings_.flushIntervalMs = qMax(1, settings_.flushIntervalMs);
+    settings_.maxPending = qMax(settings_.batchSize, settings_.maxPending);
+    pending_.reserve(settings_.batchSize);
+
+    writer_.setMaxThreadCount(1);
+    writer_.setExpiryTimeout(-1);
+
+    flushTimer_.setSingleShot(true);
+    connect(&flushTimer_, &QTimer::timeout, this, &MeasurementBatcher::onFlushTimeout);
+
+    if (settings_.metricsLogIntervalMs > 0) {
+        connect(&metricsTimer_, &QTimer::timeout, this, &MeasurementBatcher::logMetrics);
+        metricsTimer_.start(settings_.metricsLogIntervalMs);
+    }
+}
+
+MeasurementBatcher::~MeasurementBatcher()
+{
+    flushAndWait();
+}
+
+void MeasurementBatcher::enqueue(qint64 sensorId, double value)
+{
+    if (pending_.size() >= settings_.maxPending) {
+        pending_.removeFirst();
+        ++stats_.rowsDropped;
+        static MetricsRegistry::Counter &droppedMessages = stageCounter("dropped");
+        droppedMessages.increment();
+
+        static LogSite droppedSite("ingest.dropped", Logger::LogLevel::Warning, {.maxPerSecond = 1});
+        if (droppedSite.shouldLog()) {
+            LogEvent(droppedSite)
+                .add("pending", pending_.size())
+                .add("dropped_total", stats_.rowsDropped)
+                .write();
+        }
+    }
+
+    pending_.append(PendingMeasurement{sensorId, value, QDateTime::currentDateTime()});
+    ++stats_.enqueued;
+
+    if (pending_.size() >= settings_.batchSize) {
+        flush(FlushReason::Size);
+    } else if (!flushTimer_.isActive()) {
+        // The timer bounds how long the oldest buffered reading waits.
+        flushTimer_.start(settings_.flushIntervalMs);
+    }
+}
+
+void MeasurementBatcher::flush()
+{
+    flush(FlushReason::Manual);
+}
+
+void MeasurementBatcher::flushAndWait()
+{
+    quint64 failedBefore = stats_.failedFlushes;
+    while ((flushing_ || !pending_.isEmpty()) && stats_.failedFlushes == failedBefore) {
+        flush(FlushReason::Manual);
+        writer_.waitForDone();
+        // Delivers the outcome the writer posted, which clears flushing_.
+        QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+    }
+}
+
+MetricsRegistry::Counter &MeasurementBatcher::stageCounter(const char *stage)
+{
+    return MetricsRegistry::instance().counter(
+        "arkanova_mqtt_messages_total",
+        "MQTT readings by ingest stage: received, parsed, stored, rejected (malformed or unknown sensor) and dropped.",
+        {{"stage", stage}});
+}
+
+const MeasurementBatcher::Settings &MeasurementBatcher::settings() const
+{
+    return settings_;
+}
+
+MeasurementBatcher::Stats MeasurementBatcher::stats() const
+{
+    Stats stats = stats_;
+    stats.pending = pending_.size();
+    return stats;
+}
+
+void MeasurementBatcher::onFlushTimeout()
+{
+    flush(FlushReason::Timer);
+}
+
+void MeasurementBatcher::flush(FlushReason reason)
+{
+    if (flushing_) {
+        // onBatchWritten() schedules whatever was buffered in the meantime.
+        return;
+    }
+    flushTimer_.stop();
+    if (pending_.isEmpty()) {
+        return;
+    }
+
+    QList<PendingMeasurement> batch;
+    batch.swap(pending_);
+    pending_.reserve(settings_.batchSize);
+    flushing_ = true;
+
+    // The destructor waits for the writer, so the batcher outlives the task; the outcome is
+    // posted back to this object's thread.
+    writer_.start([this, reason, batch]() {
+        QElapsedTimer timer;
+        timer.start();
+        QList<InsertedMeasurement> insertedRows;
+        int inserted = MeasurementRepository().insertMeasurements(batch, &insertedRows);
+        qint64 elapsedNs = timer.nsecsElapsed();
+        QMetaObject::invokeMethod(this, [this, reason, batch, inserted, insertedRows, elapsedNs]() {
+            onBatchWritten(reason, batch, inserted, insertedRows, elapsedNs);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MeasurementBatcher::onBatchWritten(FlushReason reason, QList<PendingMeasurement> batch, int inserted,
+                                        const QList<InsertedMeasurement> &insertedRows, qint64 elapsedNs)
+{
+    flushing_ = false;
+    qint64 elapsedMs = elapsedNs / 1000000;
+
+    if (inserted < 0) {
+        // Keep the readings for the next attempt; maxPending bounds how much we hold on to.
+        ++stats_.failedFlushes;
+        qsizetype room = settings_.maxPending - pending_.size();
+        if (batch.size() > room) {
+            stats_.rowsDropped += batch.size() - room;
+            stageCounter("dropped").increment(quint64(batch.size() - room));
+            batch.remove(0, batch.size() - room);
+        }
+        pending_ = batch + pending_;
+        Logger::instance().log(QString("Ingest: flush of %1 measurement(s) failed, %2 pending")
+                                   .arg(batch.size()).arg(pending_.size()),
+                               Logger::LogLevel::Error);
+        flushTimer_.start(settings_.flushIntervalMs);
+        return;
+    }
+
+    // Only committed rows become visible to readers of the in-memory tables.
+    LatestMeasurementTable& latestTable = LatestMeasurementTable::instance();
+    HotWindowStore& hotWindow = HotWindowStore::instance();
+    for (const InsertedMeasurement& row : insertedRows) {
+        latestTable.update(row.sensorId, row.point);
+        hotWindow.append(row.sensorId, row.point);
+    }
+    if (!insertedRows.isEmpty()) {
+        emit committed(insertedRows);
+    }
+
+    int rejected = batch.size() - inserted;
+    static MetricsRegistry::Counter &storedMessages = stageCounter("stored");
+    static MetricsRegistry::Counter &rejectedMessages = stageCounter("rejected");
+    static MetricsRegistry::Histogram &flushLatency = MetricsRegistry::instance().histogram(
+        "arkanova_ingest_flush_duration_seconds", "Time to write one ingest batch.");
+    storedMessages.increment(quint64(inserted));
+    rejectedMessages.increment(quint64(rejected));
+    flushLatency.observeNs(elapsedNs);
+
+    ++stats_.flushes;
+    if (reason == FlushReason::Size) {
+        ++stats_.sizeTriggeredFlushes;
+    } else if (reason == FlushReason::Timer) {
+        ++stats_.timerTriggeredFlushes;
+    }
+    stats_.rowsInserted += inserted;
+    stats_.rowsRejected += rejected;
+    stats_.lastFlushMs = elapsedMs;
+    stats_.maxFlushMs = qMax(stats_.maxFlushMs, elapsedMs);
+
+    if (rejected > 0) {
+        Logger::instance().log(QString("Ingest: %1 measurement(s) rejected for unknown sensors").arg(rejected),
+                               Logger::LogLevel::Warning);
+    }
+
+    emit flushed(inserted, rejected);
+
+    if (pending_.size() >= settings_.batchSize) {
+        flush(FlushReason::Size);
+    } else if (!pending_.isEmpty() && !flushTimer_.isActive()) {
+        flushTimer_.start(settings_.flushIntervalMs);
+    }
+}
+
+void MeasurementBatcher::logMetrics()
+{
+    if (stats_.flushes == flushesAtLastLog_ && pending_.isEmpty()) {
+        return;
+    }
+    flushesAtLastLog_ = stats_.flushes;
+
+    Logger::instance().log(QString("Ingest: flushes=%1 (size=%2, timer=%3, failed=%4) inserted=%5 rejected=%6 "
+                                   "dropped=%7 pending=%8 lastFlushMs=%9 maxFlushMs=%10")
+                               .arg(stats_.flushes).arg(stats_.sizeTriggeredFlushes)
+                               .arg(stats_.timerTriggeredFlushes).arg(stats_.failedFlushes)
+                               .arg(stats_.rowsInserted).arg(stats_.rowsRejected)
+                               .arg(stats_.rowsDropped).arg(pending_.size())
+                               .arg(stats_.lastFlushMs).arg(stats_.maxFlushMs),
+                           Logger::LogLevel::Info);
+
+    if (HotWindowStore::instance().isEnabled()) {
+        HotWindowStore::Stats hotWindow = HotWindowStore::instance().stats();
+        Logger::instance().log(QString("Hot window: sensors=%1 samples=%2 bytes=%3/%4 hits=%5 partial=%6 misses=%7")
+                                   .arg(hotWindow.sensors).arg(hotWindow.samples)
+                                   .arg(hotWindow.bytes).arg(hotWindow.maxBytes)
+                                   .arg(hotWindow.fullHits).arg(hotWindow.partialHits).arg(hotWindow.misses),
+                               Logger::LogLevel::Info);
+    }
+}
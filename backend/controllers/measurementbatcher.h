@@ -0,0 +1,87 @@
+#ifndef MEASUREMENTBATCHER_H
+#define MEASUREMENTBATCHER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QThreadPool>
+#include "../repositories/measurementrepository.h"
+#include "../utils/metrics.h"
+
+// Buffers readings parsed from MQTT and writes them with one multi-row INSERT, either when
+// batchSize readings are pending or when the oldest one has waited flushIntervalMs.
+//
+// The INSERT runs on a writer thread of its own, with its own pooled connection, so a slow
+// commit never stalls HTTP accepts or MQTT delivery. Only one batch is in flight at a time;
+// readings arriving meanwhile wait in the buffer. The outcome is handled back on the thread
+// that owns the batcher: the in-memory tables are updated and committed() and flushed() are
+// emitted there, and a failed batch is put back in front of the buffer.
+class MeasurementBatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Settings {
+        int batchSize = 500;
+        int flushIntervalMs = 250;
+        int maxPending = 50000;          // Oldest readings are dropped beyond this while the DB is failing
+        int metricsLogIntervalMs = 60000; // 0 disables the periodic metrics log line
+    };
+
+    struct Stats {
+        quint64 enqueued = 0;
+        quint64 flushes = 0;
+        quint64 sizeTriggeredFlushes = 0;
+        quint64 timerTriggeredFlushes = 0;
+        quint64 failedFlushes = 0;
+        quint64 rowsInserted = 0;
+        quint64 rowsRejected = 0;        // Unknown sensor ids, filtered out by the insert
+        quint64 rowsDropped = 0;         // Lost to the maxPending bound
+        qint64 lastFlushMs = 0;
+        qint64 maxFlushMs = 0;
+        int pending = 0;
+    };
+
+    explicit MeasurementBatcher(const Settings &settings, QObject *parent = nullptr);
+    ~MeasurementBatcher();
+
+    void enqueue(qint64 sensorId, double value);
+    // Hands the buffered readings to the writer thread and returns; a no-op while a batch is
+    // already in flight, since whatever is buffered goes next.
+    void flush();
+    // Flushes and waits until everything buffered is written, or a batch fails.
+    void flushAndWait();
+
+    // arkanova_mqtt_messages_total{stage=...}; callers keep the reference in a static.
+    static MetricsRegistry::Counter &stageCounter(const char *stage);
+
+    const Settings &settings() const;
+    Stats stats() const;
+
+signals:
+    void flushed(int inserted, int rejected);
+    // The rows of a committed batch, as written; emitted before flushed().
+    void committed(const QList<InsertedMeasurement> &rows);
+
+private slots:
+    void onFlushTimeout();
+    void logMetrics();
+
+private:
+    enum class FlushReason { Size, Timer, Manual };
+
+    void flush(FlushReason reason);
+    void onBatchWritten(FlushReason reason, QList<PendingMeasurement> batch, int inserted,
+                        const QList<InsertedMeasurement> &insertedRows, qint64 elapsedNs);
+
+    Settings settings_;
+    QList<PendingMeasurement> pending_;
+    bool flushing_ = false;
+    QTimer flushTimer_;
+    QTimer metricsTimer_;
+    // One thread, kept alive so its pooled connection stays warm.
+    QThreadPool writer_;
+    Stats stats_;
+    quint64 flushesAtLastLog_ = 0;
+};
+
+#endif // MEASUREMENTBATCHER_H
@@ -0,0 +1,189 @@
+#include "partitionmanager.h"
+#include "connectionpool.h"
+#include "dbcontroller.h"
+#include "../utils/logger.h"
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+
+PartitionManager::PartitionManager(const Settings &settings, QObject *parent)
+    : QObject(parent), settings_(settings)
+{
+    settings_.premake = qMax(1, settings_.premake);
+    settings_.retention = qMax(0, settings_.retention);
+    connect(&timer_, &QTimer::timeout, this, &PartitionManager::maintain);
+}
+
+void PartitionManager::start()
+{
+    maintain();
+    timer_.start(qMax(60000, settings_.checkIntervalMs));
+}
+
+bool PartitionManager::maintain()
+{
+    bool ok = true;
+    QDate start = periodStart(QDate::currentDate());
+
+    for (int i = 0; i <= settings_.premake; ++i) {
+        ok = createPartition(start) && ok;
+        start = nextPeriod(start);
+    }
+
+    if (settings_.retention > 0) {
+        QDate oldestKept = periodStart(QDate::currentDate());
+        oldestKept = settings_.interval == Interval::Daily ? oldestKept.addDays(-settings_.retention)
+                                                           : oldestKept.addMonths(-settings_.retention);
+        ok = dropExpiredPartitions(oldestKept) && ok;
+    }
+    return ok;
+}
+
+const PartitionManager::Settings &PartitionManager::settings() const
+{
+    return settings_;
+}
+
+QString PartitionManager::partitionName(const QDate &start, Interval interval)
+{
+    return "measurement_p" + start.toString(interval == Interval::Daily ? "yyyyMMdd" : "yyyyMM");
+}
+
+QDate PartitionManager::periodStart(const QDate &date) const
+{
+    return settings_.interval == Interval::Daily ? date : QDate(date.year(), date.month(), 1);
+}
+
+QDate PartitionManager::nextPeriod(const QDate &start) const
+{
+    return settings_.interval == Interval::Daily ? start.addDays(1) : start.addMonths(1);
+}
+
+bool PartitionManager::createPartition(const QDate &start)
+{
+    // Partition DDL cannot take bind parameters; every interpolated value is generated here.
+    QString name = partitionName(start, settings_.interval);
+    QSqlQuery query(DBController::getDatabase());
+    QString statement = QString("CREATE TABLE IF NOT EXISTS public.%1 PARTITION OF public.measurement "
+                                "FOR VALUES FROM ('%2') TO ('%3')")
+                            .arg(name, start.toString(Qt::ISODate), nextPeriod(start).toString(Qt::ISODate));
+
+    if (query.exec(statement)) {
+        return true;
+    }
+    QString error = query.lastError().text();
+
+    // Rows for this range landed in measurement_default before the partition existed (the
+    // server was down over a period boundary, or premake was too small); move them out.
+    QSqlQuery stranded(DBController::getDatabase());
+    stranded.prepare("SELECT EXISTS (SELECT 1 FROM public.measurement_default "
+                     "WHERE recorded_at >= :start AND recorded_at < :end)");
+    stranded.bindValue(":start", start.startOfDay());
+    stranded.bindValue(":end", nextPeriod(start).startOfDay());
+    if (stranded.exec() && stranded.next() && stranded.value(0).toBool()) {
+        return moveOutOfDefault(name, start);
+    }
+
+    // Otherwise a partition of the other interval overlaps it, which needs an operator.
+    Logger::instance().log("Partitioning: could not create " + name + ": " + error, Logger::LogLevel::Error);
+    return false;
+}
+
+bool PartitionManager::moveOutOfDefault(const QString &name, const QDate &start)
+{
+    QString from = start.toString(Qt::ISODate);
+    QString to = nextPeriod(start).toString(Qt::ISODate);
+    const QStringList statements = {
+        "ALTER TABLE public.measurement DETACH PARTITION public.measurement_default",
+        QString("CREATE TABLE public.%1 PARTITION OF public.measurement FOR VALUES FROM ('%2') TO ('%3')")
+            .arg(name, from, to),
+        QString("INSERT INTO public.%1 (id, value, recorded_at, sensor_id) "
+                "SELECT id, value, recorded_at, sensor_id FROM public.measurement_default "
+                "WHERE recorded_at >= '%2' AND recorded_at < '%3'")
+            .arg(name, from, to),
+        QString("DELETE FROM public.measurement_default WHERE recorded_at >= '%1' AND recorded_at < '%2'")
+            .arg(from, to),
+        "ALTER TABLE public.measurement ATTACH PARTITION public.measurement_default DEFAULT",
+    };
+
+    // Held for the whole transaction; DETACH locks measurement, so ingest waits until COMMIT.
+    ConnectionPool::Lease lease;
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        Logger::instance().log("Partitioning: could not start moving rows into " + name + ": "
+                                   + db.lastError().text(),
+                               Logger::LogLevel::Error);
+        return false;
+    }
+
+    QSqlQuery query(db);
+    qint64 moved = 0;
+    for (const QString &statement : statements) {
+        if (!query.exec(statement)) {
+            Logger::instance().log("Partitioning: moving rows out of measurement_default into " + name
+                                       + " failed, rolled back: " + query.lastError().text(),
+                                   Logger::LogLevel::Error);
+            db.rollback();
+            return false;
+        }
+        if (statement.startsWith("INSERT")) {
+            moved = query.numRowsAffected();
+        }
+    }
+    if (!db.commit()) {
+        Logger::instance().log("Partitioning: could not commit moving rows into " + name + ": "
+                                   + db.lastError().text(),
+                               Logger::LogLevel::Error);
+        db.rollback();
+        return false;
+    }
+
+    Logger::instance().log(QString("Partitioning: created %1 and moved %2 row(s) into it from measurement_default")
+                               .arg(name).arg(moved),
+                           Logger::LogLevel::Warning);
+    return true;
+}
+
+bool PartitionManager::dropExpiredPartitions(const QDate &oldestKept)
+{
+    QSqlQuery query(DBController::getDatabase());
+    query.prepare(R"(
+        SELECT c.relname
+        FROM pg_inherits i
+        JOIN pg_class c ON c.oid = i.inhrelid
+        JOIN pg_class p ON p.oid = i.inhparent
+        WHERE p.relname = 'measurement' AND c.relname LIKE 'measurement\_p%'
+    )");
+    if (!query.exec()) {
+        Logger::instance().log("Partitioning: could not list partitions: " + query.lastError().text(),
+                               Logger::LogLevel::Error);
+        return false;
+    }
+
+    QStringList expired;
+    while (query.next()) {
+        QString name = query.value(0).toString();
+        QString suffix = name.mid(QString("measurement_p").size());
+        QDate start = suffix.size() == 8 ? QDate::fromString(suffix, "yyyyMMdd")
+                                         : QDate::fromString(suffix + "01", "yyyyMMdd");
+        if (!start.isValid()) {
+            continue;
+        }
+        QDate end = suffix.size() == 8 ? start.addDays(1) : start.addMonths(1);
+        if (end <= oldestKept) {
+            expired.append(name);
+        }
+    }
+
+    bool ok = true;
+    for (const QString &name : expired) {
+        QSqlQuery drop(DBController::getDatabase());
+        if (drop.exec(QString("DROP TABLE IF EXISTS public.%1").arg(name))) {
+            Logger::instance().log("Partitioning: dropped expired partition " + name, Logger::LogLevel::Info);
+        } else {
+            Logger::instance().log("Partitioning: could not drop " + name + ": " + drop.lastError().text(),
+                                   Logger::LogLevel::Error);
+            ok = false;
+        }
+    }
+    return ok;
+}
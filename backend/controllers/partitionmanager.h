@@ -0,0 +1,49 @@
+#ifndef PARTITIONMANAGER_H
+#define PARTITIONMANAGER_H
+
+#include <QObject>
+#include <QDate>
+#include <QTimer>
+
+// Keeps the range-partitioned measurement table supplied with partitions: creates the current
+// one plus `premake` future ones on every check, and drops partitions that fall entirely
+// outside the retention window when one is configured.
+class PartitionManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Interval { Daily, Monthly };
+
+    struct Settings {
+        Interval interval = Interval::Monthly;
+        int premake = 3;               // Future partitions kept ready beyond the current one
+        int retention = 0;             // Whole partitions to keep before the current one; 0 keeps everything
+        int checkIntervalMs = 3600000;
+    };
+
+    explicit PartitionManager(const Settings &settings, QObject *parent = nullptr);
+
+    void start();
+    // Returns false if any partition could not be created or dropped.
+    bool maintain();
+
+    const Settings &settings() const;
+
+    static QString partitionName(const QDate &start, Interval interval);
+
+private:
+    QDate periodStart(const QDate &date) const;
+    QDate nextPeriod(const QDate &start) const;
+    bool createPartition(const QDate &start);
+    // Creates the partition for a range that already has rows in measurement_default: detaches
+    // the default partition, creates the new one, moves the rows over and reattaches, all in
+    // one transaction.
+    bool moveOutOfDefault(const QString &name, const QDate &start);
+    bool dropExpiredPartitions(const QDate &oldestKept);
+
+    Settings settings_;
+    QTimer timer_;
+};
+
+#endif // PARTITIONMANAGER_H
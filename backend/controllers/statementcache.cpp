@@ -0,0 +1,96 @@
+#include "statementcache.h"
+
+std::atomic<int> StatementCache::capacity_ {64};
+std::atomic<quint64> StatementCache::hits_ {0};
+std::atomic<quint64> StatementCache::misses_ {0};
+std::atomic<quint64> StatementCache::evictions_ {0};
+std::atomic<quint64> StatementCache::invalidations_ {0};
+std::atomic<qint64> StatementCache::entries_ {0};
+
+StatementCache &StatementCache::local()
+{
+    thread_local StatementCache cache;
+    return cache;
+}
+
+StatementCache::~StatementCache()
+{
+    entries_.fetch_sub(statements_.size(), std::memory_order_relaxed);
+}
+
+void StatementCache::setCapacity(int capacity)
+{
+    capacity_.store(qMax(0, capacity), std::memory_order_relaxed);
+}
+
+StatementCache::Stats StatementCache::stats()
+{
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+    stats.entries = entries_.load(std::memory_order_relaxed);
+    stats.capacity = capacity_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void StatementCache::reset(const QString &connectionName)
+{
+    invalidations_.fetch_add(quint64(statements_.size()), std::memory_order_relaxed);
+    entries_.fetch_sub(statements_.size(), std::memory_order_relaxed);
+    statements_.clear();
+    connectionName_ = connectionName;
+    ++generation_;
+}
+
+bool StatementCache::serves(const QString &connectionName) const
+{
+    return capacity_.load(std::memory_order_relaxed) > 0 && !connectionName_.isEmpty()
+           && connectionName == connectionName_;
+}
+
+std::unique_ptr<QSqlQuery> StatementCache::take(const QString &sql)
+{
+    applyCapacity();
+    std::unique_ptr<QSqlQuery> statement(statements_.take(sql));
+    if (!statement) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    entries_.fetch_sub(1, std::memory_order_relaxed);
+    return statement;
+}
+
+void StatementCache::give(const QString &sql, QSqlQuery &&query, quint64 generation)
+{
+    auto statement = std::make_unique<QSqlQuery>(std::move(query));
+    // Releases a single-row-mode result that was not read to the end.
+    statement->finish();
+
+    // A copy prepared while this one was checked out stays, and this one is deallocated.
+    if (generation != generation_ || capacity_.load(std::memory_order_relaxed) == 0 || statements_.contains(sql)) {
+        return;
+    }
+
+    applyCapacity();
+    qsizetype before = statements_.size();
+    if (before >= statements_.maxCost()) {
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    statements_.insert(sql, statement.release());
+    entries_.fetch_add(statements_.size() - before, std::memory_order_relaxed);
+}
+
+void StatementCache::applyCapacity()
+{
+    qsizetype capacity = qMax(1, capacity_.load(std::memory_order_relaxed));
+    if (statements_.maxCost() == capacity) {
+        return;
+    }
+    qsizetype before = statements_.size();
+    statements_.setMaxCost(capacity);
+    evictions_.fetch_add(quint64(before - statements_.size()), std::memory_order_relaxed);
+    entries_.fetch_sub(before - statements_.size(), std::memory_order_relaxed);
+}
@@ -0,0 +1,72 @@
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <QtSql/QSqlQuery>
+#include <QCache>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+// Prepared statements of the calling thread's pooled connection, keyed by SQL text and evicted
+// least recently used first. With QPSQL every prepare() is a PREPARE round-trip and every
+// destroyed query a DEALLOCATE; a statement taken from the cache is only rebound and executed.
+//
+// A statement is checked out with take() and handed back with give() once its result is done
+// with, so the same SQL running twice at once (a cursor still open while a lookup repeats it)
+// just prepares a second copy. The pool gives each thread a single connection, so the cache is
+// per thread; ConnectionPool calls reset() whenever the connection is (re)opened or dropped,
+// and statements checked out under an earlier connection are discarded when handed back.
+class StatementCache
+{
+public:
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        quint64 invalidations = 0;   // Statements dropped because their connection went away
+        qint64 entries = 0;
+        int capacity = 0;
+    };
+
+    // The calling thread's cache.
+    static StatementCache& local();
+
+    // Statements kept per connection; 0 turns caching off. Applies to every thread.
+    static void setCapacity(int capacity);
+    // Totals over all threads.
+    static Stats stats();
+
+    // Binds the cache to `connectionName`, dropping everything prepared on the previous connection.
+    void reset(const QString& connectionName = QString());
+
+    // Whether statements prepared on `connectionName` belong in this cache.
+    bool serves(const QString& connectionName) const;
+    quint64 generation() const { return generation_; }
+
+    // A prepared statement for `sql` with its previous bindings still set, if one is cached.
+    std::unique_ptr<QSqlQuery> take(const QString& sql);
+    // Returns a statement prepared from `sql` under `generation`; it is finished first.
+    void give(const QString& sql, QSqlQuery&& query, quint64 generation);
+
+private:
+    StatementCache() = default;
+    ~StatementCache();
+
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    void applyCapacity();
+
+    QString connectionName_;
+    quint64 generation_ = 0;
+    QCache<QString, QSqlQuery> statements_;
+
+    static std::atomic<int> capacity_;
+    static std::atomic<quint64> hits_;
+    static std::atomic<quint64> misses_;
+    static std::atomic<quint64> evictions_;
+    static std::atomic<quint64> invalidations_;
+    static std::atomic<qint64> entries_;
+};
+
+#endif // STATEMENTCACHE_H
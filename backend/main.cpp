@@ -1,13 +1,25 @@
 #include <QCoreApplication>
 #include <QSettings>
+#include <QTimer>
 #include <QTranslator>
 #include "./controllers/servercontroller.h"
 #include "./controllers/dbcontroller.h"
+#include "./controllers/statementcache.h"
+#include "./repositories/metadatacache.h"
+#include "./repositories/latestmeasurementtable.h"
+#include "./repositories/hotwindowstore.h"
+#include "./repositories/slowquerylog.h"
 #include "./routes/routefactory.h"
+#include "./routes/measurementhandler.h"
 #include <QtSql/QSqlError>
 #include "./utils/logger.h"
+#include "./utils/httpcompression.h"
+#include "./utils/metrics.h"
 #include <QMqttClient>
 #include "./routes/mqttfactory.h"
+#include "./controllers/measurementbatcher.h"
+#include "./controllers/partitionmanager.h"
+#include "./controllers/livestreamserver.h"
 
 int main(int argc, char *argv[])
 {
@@ -21,6 +33,13 @@ int main(int argc, char *argv[])
     bool enableConsoleOutput = settings.value("Logger/enableConsoleOutput", true).toBool();
     QString logLevel = settings.value("Logger/logLevel", "Debug").toString();
 
+    Logger::Settings loggerSettings;
+    loggerSettings.flushIntervalMs = settings.value("Logger/flushIntervalMs", 200).toInt();
+    loggerSettings.queueCapacity = settings.value("Logger/queueCapacity", 65536).toInt();
+    loggerSettings.overflowPolicy = settings.value("Logger/overflowPolicy", "drop").toString() == "block"
+                                        ? Logger::OverflowPolicy::Block
+                                        : Logger::OverflowPolicy::Drop;
+    Logger::instance().configure(loggerSettings);
     Logger::instance().setLogFile(logFile);
     Logger::instance().enableConsoleOutput(enableConsoleOutput);
 
@@ -28,6 +47,8 @@ int main(int argc, char *argv[])
         Logger::instance().setLogLevel(Logger::LogLevel::Debug);
     } else if (logLevel == "Info") {
         Logger::instance().setLogLevel(Logger::LogLevel::Info);
+    } else if (logLevel == "Warning") {
+        Logger::instance().setLogLevel(Logger::LogLevel::Warning);
     } else if (logLevel == "Error") {
         Logger::instance().setLogLevel(Logger::LogLevel::Error);
     }
@@ -39,25 +60,139 @@ int main(int argc, char *argv[])
 
     ServerController::setServerSettings(protocol, host, port);
 
+    // Response compression
+    HttpCompression::Settings compressionSettings;
+    compressionSettings.enabled = settings.value("Compression/enabled", true).toBool();
+    compressionSettings.minSize = settings.value("Compression/minSize", 1024).toInt();
+    compressionSettings.level = settings.value("Compression/level", 6).toInt();
+    HttpCompression::setSettings(compressionSettings);
+
     std::shared_ptr<QHttpServer> server = std::make_shared<QHttpServer>();
     std::shared_ptr<DBController> dbController = std::make_shared<DBController>();
 
     // Database configuration
-    QString dbHost = settings.value("Database/host", "localhost").toString();
-    QString dbUser = settings.value("Database/user", "user").toString();
-    QString dbPassword = settings.value("Database/password", "password").toString();
-    QString dbName = settings.value("Database/name", "database").toString();
-    int dbPort = settings.value("Database/port", "5432").toInt();
-
-    if (dbController->connect(dbHost, dbUser, dbPassword, dbName, dbPort)) {
+    ConnectionPool::Settings dbSettings;
+    dbSettings.host = settings.value("Database/host", "localhost").toString();
+    dbSettings.userName = settings.value("Database/user", "user").toString();
+    dbSettings.password = settings.value("Database/password", "password").toString();
+    dbSettings.databaseName = settings.value("Database/name", "database").toString();
+    dbSettings.port = settings.value("Database/port", "5432").toInt();
+    dbSettings.minSize = settings.value("Database/poolMinSize", 1).toInt();
+    // Caps connections in service, not sockets: a retired connection stays open until its
+    // thread next borrows or exits (see arkanova_db_pool_connections{state="retired"}).
+    dbSettings.maxSize = settings.value("Database/poolMaxSize", 8).toInt();
+    dbSettings.idleTimeoutMs = settings.value("Database/poolIdleTimeoutMs", 300000).toInt();
+    dbSettings.healthCheckIntervalMs = settings.value("Database/poolHealthCheckIntervalMs", 30000).toInt();
+    dbSettings.acquireTimeoutMs = settings.value("Database/poolAcquireTimeoutMs", 5000).toInt();
+    QString dbName = dbSettings.databaseName;
+
+    SlowQueryLog::Settings slowQuerySettings;
+    slowQuerySettings.thresholdMs = settings.value("Database/slowQueryMs", 250).toInt();
+    slowQuerySettings.capacity = settings.value("Database/slowQueryCapacity", 100).toInt();
+    slowQuerySettings.explain = settings.value("Database/explainSlowQueries", false).toBool();
+    slowQuerySettings.explainIntervalSeconds = settings.value("Database/explainIntervalSeconds", 60).toInt();
+    SlowQueryLog::instance().configure(slowQuerySettings);
+    StatementCache::setCapacity(settings.value("Database/statementCacheSize", 64).toInt());
+
+    if (dbController->connect(dbSettings)) {
         Logger::instance().log(dbName + " database opened from main.cpp", Logger::LogLevel::Info);
     } else {
         Logger::instance().log(dbName + " database opening error in main.cpp: " +
                                    dbController->getDatabase().lastError().text(), Logger::LogLevel::Error);
     }
 
+    MetadataCache::instance().setMaxEntries(settings.value("Cache/metadataMaxEntries", 10000).toInt());
+
+    // Latest reading per sensor, kept current by the ingest batcher from here on
+    {
+        MeasurementRepository measurementRepository;
+        const QList<InsertedMeasurement> latest = measurementRepository.getLatestMeasurements();
+        for (const InsertedMeasurement& row : latest) {
+            LatestMeasurementTable::instance().update(row.sensorId, row.point);
+        }
+        Logger::instance().log(QString("Latest measurement table loaded for %1 sensor(s)").arg(latest.size()),
+                               Logger::LogLevel::Info);
+    }
+
+    // Recent readings per sensor, held from the first batch ingested by this process on. Off by
+    // default: it is only correct while this process is the sole writer of measurements.
+    HotWindowStore::Settings hotWindowSettings;
+    hotWindowSettings.enabled = settings.value("HotWindow/enabled", false).toBool();
+    hotWindowSettings.windowSeconds = settings.value("HotWindow/windowSeconds", 86400).toInt();
+    hotWindowSettings.maxSamplesPerSensor = settings.value("HotWindow/maxSamplesPerSensor", 17280).toInt();
+    hotWindowSettings.maxMemoryMb = settings.value("HotWindow/maxMemoryMb", 128).toInt();
+    HotWindowStore::instance().configure(hotWindowSettings);
+
+    // Gauges read when /metrics is scraped; each source is safe to read from any thread.
+    MetricsRegistry &metrics = MetricsRegistry::instance();
+    metrics.gaugeCallback("arkanova_db_pool_connections", "Pooled database connections by state.", {{"state", "borrowed"}},
+                          []() { return double(DBController::pool().stats().borrowed); });
+    metrics.gaugeCallback("arkanova_db_pool_connections", "Pooled database connections by state.", {{"state", "idle"}},
+                          []() { return double(DBController::pool().stats().idle); });
+    metrics.gaugeCallback("arkanova_db_pool_connections", "Pooled database connections by state.", {{"state", "retired"}},
+                          []() { return double(DBController::pool().stats().retired); });
+    metrics.counterCallback("arkanova_db_pool_acquire_timeouts_total", "Borrows that gave up waiting for a connection.", {},
+                          []() { return double(DBController::pool().stats().acquireTimeouts); });
+    metrics.counterCallback("arkanova_db_statement_cache_lookups_total", "Prepared statement cache lookups by result.",
+                            {{"result", "hit"}}, []() { return double(StatementCache::stats().hits); });
+    metrics.counterCallback("arkanova_db_statement_cache_lookups_total", "Prepared statement cache lookups by result.",
+                            {{"result", "miss"}}, []() { return double(StatementCache::stats().misses); });
+    metrics.counterCallback("arkanova_db_statement_cache_evictions_total", "Prepared statements evicted to stay under capacity.", {},
+                            []() { return double(StatementCache::stats().evictions); });
+    metrics.counterCallback("arkanova_db_statement_cache_invalidations_total", "Prepared statements dropped with their connection.", {},
+                            []() { return double(StatementCache::stats().invalidations); });
+    metrics.gaugeCallback("arkanova_db_statement_cache_entries", "Prepared statements cached over all connections.", {},
+                          []() { return double(StatementCache::stats().entries); });
+    metrics.counterCallback("arkanova_metadata_cache_hits_total", "Metadata cache lookups served from memory.", {},
+                          []() { return double(MetadataCache::instance().stats().hits); });
+    metrics.counterCallback("arkanova_metadata_cache_misses_total", "Metadata cache lookups that went to the database.", {},
+                          []() { return double(MetadataCache::instance().stats().misses); });
+    metrics.counterCallback("arkanova_metadata_cache_stale_inserts_total", "Rows not cached because their entry was invalidated while they were read.", {},
+                          []() { return double(MetadataCache::instance().stats().staleInserts); });
+    metrics.gaugeCallback("arkanova_latest_table_sensors", "Sensors held in the latest-measurement table.", {},
+                          []() { return double(LatestMeasurementTable::instance().stats().sensors); });
+    metrics.gaugeCallback("arkanova_hot_window_samples", "Readings held in the hot-window buffers.", {},
+                          []() { return double(HotWindowStore::instance().stats().samples); });
+    metrics.gaugeCallback("arkanova_hot_window_bytes", "Memory reserved by the hot-window buffers.", {},
+                          []() { return double(HotWindowStore::instance().stats().bytes); });
+
+    // Retire pooled connections that sat idle for longer than poolIdleTimeoutMs; each thread
+    // closes its own on its next query
+    QTimer poolReaper;
+    QObject::connect(&poolReaper, &QTimer::timeout, []() {
+        int reaped = DBController::pool().reapIdle();
+        if (reaped > 0) {
+            Logger::instance().log(QString("Database pool: retired %1 idle connection(s)").arg(reaped),
+                                   Logger::LogLevel::Debug);
+        }
+    });
+    poolReaper.start(qMax(1000, dbSettings.idleTimeoutMs / 2));
+
+    // Measurement partitions
+    PartitionManager::Settings partitionSettings;
+    partitionSettings.interval = settings.value("Partitioning/interval", "monthly").toString() == "daily"
+                                     ? PartitionManager::Interval::Daily
+                                     : PartitionManager::Interval::Monthly;
+    partitionSettings.premake = settings.value("Partitioning/premake", 3).toInt();
+    partitionSettings.retention = settings.value("Partitioning/retention", 0).toInt();
+    partitionSettings.checkIntervalMs = settings.value("Partitioning/checkIntervalMs", 3600000).toInt();
+    PartitionManager partitionManager(partitionSettings);
+    if (settings.value("Partitioning/enabled", true).toBool()) {
+        partitionManager.start();
+    }
+
     // Set up routes
-    RouteFactory routefactory(server, dbController);
+    QString handlerMode = settings.value("Server/handlerMode", "inline").toString();
+    int workerThreads = settings.value("Server/workerThreads", 0).toInt();
+    int streamThreads = settings.value("Server/streamThreads", 2).toInt();
+    RouteFactory::ExecutionMode executionMode = handlerMode == "pool"
+                                                    ? RouteFactory::ExecutionMode::WorkerPool
+                                                    : RouteFactory::ExecutionMode::Inline;
+
+    MeasurementHandler::setPageSizeLimits(settings.value("Server/defaultPageSize", 1000).toInt(),
+                                          settings.value("Server/maxPageSize", 5000).toInt());
+
+    RouteFactory routefactory(server, dbController, executionMode, workerThreads, streamThreads);
     routefactory.registerAllRoutes();
 
     // Start server
@@ -72,8 +207,33 @@ int main(int argc, char *argv[])
         settings.value("MQTT/port", 1883).toInt()
         );
 
+    // Batched measurement ingest
+    MeasurementBatcher::Settings ingestSettings;
+    ingestSettings.batchSize = settings.value("Ingest/batchSize", 500).toInt();
+    ingestSettings.flushIntervalMs = settings.value("Ingest/flushIntervalMs", 250).toInt();
+    ingestSettings.maxPending = settings.value("Ingest/maxPending", 50000).toInt();
+    ingestSettings.metricsLogIntervalMs = settings.value("Ingest/metricsLogIntervalMs", 60000).toInt();
+    auto measurementBatcher = std::make_shared<MeasurementBatcher>(ingestSettings);
+    mqttFactory.setMeasurementBatcher(measurementBatcher);
+
+    // Live readings over WebSocket, fed by the batches ingest commits
+    LiveStreamServer::Settings liveSettings;
+    liveSettings.enabled = settings.value("LiveStream/enabled", true).toBool();
+    liveSettings.port = settings.value("LiveStream/port", 4926).toInt();
+    liveSettings.maxClients = settings.value("LiveStream/maxClients", 1000).toInt();
+    liveSettings.maxSubscriptionsPerClient = settings.value("LiveStream/maxSubscriptionsPerClient", 1000).toInt();
+    liveSettings.maxQueuedReadings = settings.value("LiveStream/maxQueuedReadings", 1000).toInt();
+    liveSettings.maxBufferedBytes = settings.value("LiveStream/maxBufferedBytes", 262144).toLongLong();
+    LiveStreamServer liveStreamServer(liveSettings);
+    if (liveSettings.enabled && liveStreamServer.listen()) {
+        QObject::connect(measurementBatcher.get(), &MeasurementBatcher::committed,
+                         &liveStreamServer, &LiveStreamServer::publish);
+    }
+
     QObject::connect(&mqttFactory, &MqttFactory::messageReceived, [](const QString &topic, const QByteArray &message) {
-        Logger::instance().log(QString("Application: Process MQTT message from topic '%1'").arg(topic), Logger::LogLevel::Info);
+        if (Logger::instance().isEnabled(Logger::LogLevel::Debug)) {
+            Logger::instance().log(QString("Application: Process MQTT message from topic '%1'").arg(topic), Logger::LogLevel::Debug);
+        }
         // Handle message here
     });
 
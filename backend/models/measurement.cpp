@@ -1,23 +1,24 @@
 #include "measurement.h"
+#include "../utils/jsonwriter.h"
 
 
 
 Measurement::Measurement() {}
 
-Measurement::Measurement(quint64 id, QByteArray data, QDateTime recordedAt, Sensor sensor)
-    : id_(id), data_(data), recordedAt_(recordedAt), sensor_(sensor)
+Measurement::Measurement(quint64 id, std::optional<double> value, QDateTime recordedAt, Sensor sensor)
+    : id_(id), value_(value), recordedAt_(recordedAt), sensor_(sensor)
 {
 
 }
 
 Measurement::Measurement(const Measurement &other)
-    : id_(other.id_), data_(other.data_), recordedAt_(other.recordedAt_), sensor_(other.sensor_)
+    : id_(other.id_), value_(other.value_), recordedAt_(other.recordedAt_), sensor_(other.sensor_)
 {
 
 }
 
 Measurement::Measurement(Measurement &&other)
-    : id_(std::move(other.id_)), data_(std::move(other.data_)), recordedAt_(std::move(other.recordedAt_)),
+    : id_(std::move(other.id_)), value_(std::move(other.value_)), recordedAt_(std::move(other.recordedAt_)),
     sensor_(std::move(other.sensor_))
 {
 
@@ -28,9 +29,9 @@ void Measurement::setId(qint64 newId)
     id_ = newId;
 }
 
-void Measurement::setData(const QByteArray &newData)
+void Measurement::setValue(std::optional<double> newValue)
 {
-    data_ = newData;
+    value_ = newValue;
 }
 
 void Measurement::setRecordedAt(const QDateTime &newRecordedAt)
@@ -48,9 +49,14 @@ qint64 Measurement::id() const
     return id_;
 }
 
-const QByteArray &Measurement::data() const
+std::optional<double> Measurement::value() const
 {
-    return data_;
+    return value_;
+}
+
+std::optional<double> Measurement::reportedValue() const
+{
+    return sensor_.type().reportsReadings() ? value_ : std::nullopt;
 }
 
 const QDateTime &Measurement::recordedAt() const
@@ -68,26 +74,21 @@ QJsonObject Measurement::toJson() const
     QJsonObject json;
     json["id"] = id_;
 
-    if (sensor_.type().name() == "temperature") {
-        bool ok;
-        double temperatureData = data_.toDouble(&ok);
-        if (ok) {
-            json["data"] = temperatureData;
-        } else {
-            json["data"] = QJsonValue::Null;
-        }
-    } else if (sensor_.type().name() == "power") {
-        bool ok;
-        double powerData = data_.toDouble(&ok);
-        if (ok) {
-            json["data"] = powerData;
-        } else {
-            json["data"] = QJsonValue::Null;
-        }
-    } else {
-        json["data"] = QJsonValue::Null;
-    }
+    std::optional<double> value = reportedValue();
+    json["data"] = value ? QJsonValue(*value) : QJsonValue(QJsonValue::Null);
 
     json["recorded_at"] = recordedAt_.toUTC().toMSecsSinceEpoch();
     return json;
 }
+
+void Measurement::writeJson(QByteArray &out) const
+{
+    out.append('{');
+    JsonWriter::appendKey(out, "id", true);
+    JsonWriter::appendInt(out, id_);
+    JsonWriter::appendKey(out, "data");
+    JsonWriter::appendDouble(out, reportedValue());
+    JsonWriter::appendKey(out, "recorded_at");
+    JsonWriter::appendInt(out, recordedAt_.toMSecsSinceEpoch());
+    out.append('}');
+}
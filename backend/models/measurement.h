@@ -2,13 +2,14 @@
 #define MEASUREMENT_H
 
 #include <QJsonObject>
+#include <optional>
 #include "../utils/jsonable.h"
 #include "../models/sensor.h"
 
 class Measurement : public Jsonable {
 public:
     Measurement();
-    Measurement(quint64 id, QByteArray data, QDateTime recordedAt, Sensor sensor);
+    Measurement(quint64 id, std::optional<double> value, QDateTime recordedAt, Sensor sensor);
     Measurement(const Measurement& other);
     Measurement(Measurement&& other);
     Measurement &operator=(const Measurement &) = default;
@@ -16,20 +17,23 @@ public:
 
 
     void setId(qint64 newId);
-    void setData(const QByteArray& newData);
+    void setValue(std::optional<double> newValue);
     void setRecordedAt(const QDateTime& newRecordedAt);
     void setSensorId(Sensor newSensor);
 
     qint64 id() const;
-    const QByteArray& data() const;
+    std::optional<double> value() const;
+    // value() when the sensor's type reports readings, empty otherwise; what the API shows.
+    std::optional<double> reportedValue() const;
     const QDateTime& recordedAt() const;
     const Sensor& sensor() const;
 
     QJsonObject toJson() const override;
+    void writeJson(QByteArray &out) const override;
 
 private:
     qint64 id_;
-    QByteArray data_;
+    std::optional<double> value_; // Empty when the stored reading was not numeric
     QDateTime recordedAt_;
     Sensor sensor_;
 };
@@ -0,0 +1,168 @@
+#include "measurementbucket.h"
+#include "../utils/jsonwriter.h"
+
+namespace {
+void putValue(QJsonObject &json, const char *key, std::optional<double> value)
+{
+    json[key] = value ? QJsonValue(*value) : QJsonValue(QJsonValue::Null);
+}
+}
+
+std::optional<MeasurementBucket::Aggregates> MeasurementBucket::parseAggregates(const QString &list)
+{
+    Aggregates aggregates;
+    const QStringList names = list.split(',', Qt::SkipEmptyParts);
+    for (const QString &rawName : names) {
+        QString name = rawName.trimmed().toLower();
+        if (name == "min") {
+            aggregates |= Aggregate::Min;
+        } else if (name == "max") {
+            aggregates |= Aggregate::Max;
+        } else if (name == "avg") {
+            aggregates |= Aggregate::Avg;
+        } else if (name == "count") {
+            aggregates |= Aggregate::Count;
+        } else if (name == "first") {
+            aggregates |= Aggregate::First;
+        } else if (name == "last") {
+            aggregates |= Aggregate::Last;
+        } else {
+            return std::nullopt;
+        }
+    }
+    return aggregates;
+}
+
+MeasurementBucket::MeasurementBucket() {}
+
+MeasurementBucket::MeasurementBucket(const QDateTime &start, Aggregates aggregates)
+    : start_(start), aggregates_(aggregates)
+{
+}
+
+const QDateTime &MeasurementBucket::start() const
+{
+    return start_;
+}
+
+MeasurementBucket::Aggregates MeasurementBucket::aggregates() const
+{
+    return aggregates_;
+}
+
+std::optional<double> MeasurementBucket::min() const
+{
+    return min_;
+}
+
+std::optional<double> MeasurementBucket::max() const
+{
+    return max_;
+}
+
+std::optional<double> MeasurementBucket::avg() const
+{
+    return avg_;
+}
+
+std::optional<qint64> MeasurementBucket::count() const
+{
+    return count_;
+}
+
+std::optional<double> MeasurementBucket::first() const
+{
+    return first_;
+}
+
+std::optional<double> MeasurementBucket::last() const
+{
+    return last_;
+}
+
+void MeasurementBucket::setMin(std::optional<double> value)
+{
+    min_ = value;
+}
+
+void MeasurementBucket::setMax(std::optional<double> value)
+{
+    max_ = value;
+}
+
+void MeasurementBucket::setAvg(std::optional<double> value)
+{
+    avg_ = value;
+}
+
+void MeasurementBucket::setCount(std::optional<qint64> value)
+{
+    count_ = value;
+}
+
+void MeasurementBucket::setFirst(std::optional<double> value)
+{
+    first_ = value;
+}
+
+void MeasurementBucket::setLast(std::optional<double> value)
+{
+    last_ = value;
+}
+
+QJsonObject MeasurementBucket::toJson() const
+{
+    QJsonObject json;
+    json["bucket_start"] = start_.toUTC().toMSecsSinceEpoch();
+    if (aggregates_ & Aggregate::Min) {
+        putValue(json, "min", min_);
+    }
+    if (aggregates_ & Aggregate::Max) {
+        putValue(json, "max", max_);
+    }
+    if (aggregates_ & Aggregate::Avg) {
+        putValue(json, "avg", avg_);
+    }
+    if (aggregates_ & Aggregate::Count) {
+        json["count"] = count_.value_or(0);
+    }
+    if (aggregates_ & Aggregate::First) {
+        putValue(json, "first", first_);
+    }
+    if (aggregates_ & Aggregate::Last) {
+        putValue(json, "last", last_);
+    }
+    return json;
+}
+
+void MeasurementBucket::writeJson(QByteArray &out) const
+{
+    out.append('{');
+    JsonWriter::appendKey(out, "bucket_start", true);
+    JsonWriter::appendInt(out, start_.toMSecsSinceEpoch());
+    if (aggregates_ & Aggregate::Min) {
+        JsonWriter::appendKey(out, "min");
+        JsonWriter::appendDouble(out, min_);
+    }
+    if (aggregates_ & Aggregate::Max) {
+        JsonWriter::appendKey(out, "max");
+        JsonWriter::appendDouble(out, max_);
+    }
+    if (aggregates_ & Aggregate::Avg) {
+        JsonWriter::appendKey(out, "avg");
+        JsonWriter::appendDouble(out, avg_);
+    }
+    if (aggregates_ & Aggregate::Count) {
+        JsonWriter::appendKey(out, "count");
+        JsonWriter::appendInt(out, count_.value_or(0));
+    }
+    if (aggregates_ & Aggregate::First) {
+        JsonWriter::appendKey(out, "first");
+        JsonWriter::appendDouble(out, first_);
+    }
+    if (aggregates_ & Aggregate::Last) {
+        JsonWriter::appendKey(out, "last");
+        JsonWriter::appendDouble(out, last_);
+    }
+    out.append('}');
+}
@@ -0,0 +1,68 @@
+#ifndef MEASUREMENTBUCKET_H
+#define MEASUREMENTBUCKET_H
+
+#include <QDateTime>
+#include <QFlags>
+#include <QJsonObject>
+#include <optional>
+#include "../utils/jsonable.h"
+
+// One time bucket of a sensor's readings, aggregated by the database. toJson() writes the
+// requested aggregates only, as null where the bucket held no numeric value.
+class MeasurementBucket : public Jsonable
+{
+public:
+    enum class Aggregate {
+        Min = 0x01,
+        Max = 0x02,
+        Avg = 0x04,
+        Count = 0x08,
+        First = 0x10,
+        Last = 0x20,
+    };
+    Q_DECLARE_FLAGS(Aggregates, Aggregate)
+
+    static constexpr Aggregates allAggregates() {
+        return Aggregates(Aggregate::Min) | Aggregate::Max | Aggregate::Avg
+               | Aggregate::Count | Aggregate::First | Aggregate::Last;
+    }
+
+    // Parses a comma-separated list such as "min,max,avg"; returns std::nullopt on an unknown name.
+    static std::optional<Aggregates> parseAggregates(const QString &list);
+
+    MeasurementBucket();
+    MeasurementBucket(const QDateTime &start, Aggregates aggregates);
+
+    const QDateTime& start() const;
+    Aggregates aggregates() const;
+    std::optional<double> min() const;
+    std::optional<double> max() const;
+    std::optional<double> avg() const;
+    std::optional<qint64> count() const;
+    std::optional<double> first() const;
+    std::optional<double> last() const;
+
+    void setMin(std::optional<double> value);
+    void setMax(std::optional<double> value);
+    void setAvg(std::optional<double> value);
+    void setCount(std::optional<qint64> value);
+    void setFirst(std::optional<double> value);
+    void setLast(std::optional<double> value);
+
+    QJsonObject toJson() const override;
+    void writeJson(QByteArray &out) const override;
+
+private:
+    QDateTime start_;
+    Aggregates aggregates_;
+    std::optional<double> min_;
+    std::optional<double> max_;
+    std::optional<double> avg_;
+    std::optional<qint64> count_;
+    std::optional<double> first_;
+    std::optional<double> last_;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(MeasurementBucket::Aggregates)
+
+#endif // MEASUREMENTBUCKET_H
@@ -0,0 +1,21 @@
+#include "measurementpoint.h"
+#include <QDateTime>
+#include <QTimeZone>
+#include <limits>
+
+qint64 MeasurementPoint::epochMs(qint64 storedUs)
+{
+    // Zone offsets only change on the hour, so the local-time lookup runs once per stored hour.
+    constexpr qint64 msPerHour = 3600 * 1000;
+    thread_local qint64 cachedHour = std::numeric_limits<qint64>::min();
+    thread_local qint64 cachedOffsetMs = 0;
+
+    qint64 storedMs = storedUs / 1000;
+    qint64 hour = storedMs / msPerHour - (storedMs % msPerHour < 0 ? 1 : 0);
+    if (hour != cachedHour) {
+        QDateTime wallClock = QDateTime::fromMSecsSinceEpoch(hour * msPerHour, QTimeZone::UTC);
+        cachedOffsetMs = hour * msPerHour - QDateTime(wallClock.date(), wallClock.time()).toMSecsSinceEpoch();
+        cachedHour = hour;
+    }
+    return storedMs - cachedOffsetMs;
+}
@@ -0,0 +1,49 @@
+#ifndef MEASUREMENTPOINT_H
+#define MEASUREMENTPOINT_H
+
+#include <QJsonObject>
+#include <QtGlobal>
+#include <optional>
+#include "../utils/jsonwriter.h"
+
+// A reading without its sensor graph, for series that are streamed rather than materialized.
+// Serializes to the same shape as Measurement::toJson().
+//
+// recordedAtUs is in the database's clock domain: the stored local wall-clock time read as if
+// it were UTC, which is what extract(epoch FROM recorded_at) yields for a timestamp without
+// time zone. Keys, cursors and the in-memory tables compare these values as they are; output
+// goes through recordedAtMs() to become real Unix time.
+struct MeasurementPoint {
+    qint64 id = -1;
+    qint64 recordedAtUs = 0;   // Stored wall-clock microseconds, see above
+    std::optional<double> value;
+
+    // Milliseconds since the Unix epoch for a recordedAtUs value, using the server's time zone
+    // (the one the database's TimeZone setting is expected to match).
+    static qint64 epochMs(qint64 storedUs);
+
+    qint64 recordedAtMs() const {
+        return epochMs(recordedAtUs);
+    }
+
+    QJsonObject toJson() const {
+        QJsonObject json;
+        json["id"] = id;
+        json["data"] = value ? QJsonValue(*value) : QJsonValue(QJsonValue::Null);
+        json["recorded_at"] = recordedAtMs();
+        return json;
+    }
+
+    void writeJson(QByteArray &out) const {
+        out.append('{');
+        JsonWriter::appendKey(out, "id", true);
+        JsonWriter::appendInt(out, id);
+        JsonWriter::appendKey(out, "data");
+        JsonWriter::appendDouble(out, value);
+        JsonWriter::appendKey(out, "recorded_at");
+        JsonWriter::appendInt(out, recordedAtMs());
+        out.append('}');
+    }
+};
+
+#endif // MEASUREMENTPOINT_H
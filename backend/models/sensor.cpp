@@ -1,4 +1,5 @@
 #include "sensor.h"
+#include "../utils/jsonwriter.h"
 
 Sensor::Sensor()
     : id_(-1), solarPanel_(), type_()
@@ -59,3 +60,15 @@ QJsonObject Sensor::toJson() const
     json["solar_panel_id"] = solarPanel_.id();
     return json;
 }
+
+void Sensor::writeJson(QByteArray &out) const
+{
+    out.append('{');
+    JsonWriter::appendKey(out, "id", true);
+    JsonWriter::appendInt(out, id_);
+    JsonWriter::appendKey(out, "type");
+    type_.writeJson(out);
+    JsonWriter::appendKey(out, "solar_panel_id");
+    JsonWriter::appendInt(out, solarPanel_.id());
+    out.append('}');
+}
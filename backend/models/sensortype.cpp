@@ -1,4 +1,5 @@
 #include "sensortype.h"
+#include "../utils/jsonwriter.h"
 
 SensorType::SensorType()
     : id_(-1), name_(QString())
@@ -35,6 +36,11 @@ const QString& SensorType::name() const
     return name_;
 }
 
+bool SensorType::reportsReadings() const
+{
+    return name_ == "temperature" || name_ == "power";
+}
+
 void SensorType::setName(const QString &newName)
 {
     name_ = newName;
@@ -47,3 +53,13 @@ QJsonObject SensorType::toJson() const
     json["name"] = name_;
     return json;
 }
+
+void SensorType::writeJson(QByteArray &out) const
+{
+    out.append('{');
+    JsonWriter::appendKey(out, "id", true);
+    JsonWriter::appendInt(out, id_);
+    JsonWriter::appendKey(out, "name");
+    JsonWriter::appendString(out, name_);
+    out.append('}');
+}
@@ -16,6 +16,8 @@ public:
     void setId(qint64 newId);
     const QString& name() const;
     void setName(const QString &newName);
+    // Only temperature and power readings are reported; other types serialize their data as null.
+    bool reportsReadings() const;
 
 private:
     qint64 id_ {-1};
@@ -24,6 +26,7 @@ private:
     // Jsonable interface
 public:
     QJsonObject toJson() const override;
+    void writeJson(QByteArray &out) const override;
 };
 
 #endif // SENSORTYPE_H
@@ -1,5 +1,6 @@
 #include "solarpanel.h"
 #include <utility> // For std::move
+#include "../utils/jsonwriter.h"
 
 SolarPanel::SolarPanel()
     : id_(-1), location_(QString()), user_(User()), createdAt_(QDateTime()), updatedAt_(QDateTime()) {}
@@ -84,3 +85,19 @@ QJsonObject SolarPanel::toJson() const
     json["updated_at"] = updatedAt_.toSecsSinceEpoch(); // QDateTime().toSecsSinceEpoch() returns 0 if invalid
     return json;
 }
+
+void SolarPanel::writeJson(QByteArray &out) const
+{
+    out.append('{');
+    JsonWriter::appendKey(out, "id", true);
+    JsonWriter::appendInt(out, id_);
+    JsonWriter::appendKey(out, "location");
+    JsonWriter::appendString(out, location_);
+    JsonWriter::appendKey(out, "user_id");
+    JsonWriter::appendInt(out, user_.id());
+    JsonWriter::appendKey(out, "created_at");
+    JsonWriter::appendInt(out, createdAt_.toSecsSinceEpoch());
+    JsonWriter::appendKey(out, "updated_at");
+    JsonWriter::appendInt(out, updatedAt_.toSecsSinceEpoch());
+    out.append('}');
+}
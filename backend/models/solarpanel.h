@@ -41,6 +41,7 @@ private:
 public:
     // Jsonable interface
     QJsonObject toJson() const override;
+    void writeJson(QByteArray &out) const override;
 };
 
 #endif // SOLARPANEL_H
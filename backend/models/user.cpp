@@ -1,4 +1,5 @@
 #include "user.h"
+#include "../utils/jsonwriter.h"
 
 User::User()
     : id_(-1), email_(QString()), password_(QString())
@@ -65,3 +66,13 @@ QJsonObject User::toJson() const
     json["email"] = email_;
     return json;
 }
+
+void User::writeJson(QByteArray &out) const
+{
+    out.append('{');
+    JsonWriter::appendKey(out, "id", true);
+    JsonWriter::appendInt(out, id_);
+    JsonWriter::appendKey(out, "email");
+    JsonWriter::appendString(out, email_);
+    out.append('}');
+}
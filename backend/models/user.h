@@ -30,6 +30,7 @@ private:
     // Jsonable interface
 public:
     QJsonObject toJson() const override;
+    void writeJson(QByteArray &out) const override;
 
 };
 
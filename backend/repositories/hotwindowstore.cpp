@@ -0,0 +1,245 @@
+#include "hotwindowstore.h"
+#include <QTimeZone>
+#include <algorithm>
+#include <cmath>
+
+HotWindowStore &HotWindowStore::instance()
+{
+    static HotWindowStore storeInstance;
+    return storeInstance;
+}
+
+void HotWindowStore::configure(const Settings &settings)
+{
+    settings_ = settings;
+    settings_.windowSeconds = qMax(1, settings_.windowSeconds);
+    enabled_ = settings_.enabled;
+    maxSamplesPerSensor_ = size_t(qMax(1, settings_.maxSamplesPerSensor));
+    maxBytes_ = qint64(qMax(0, settings_.maxMemoryMb)) * 1024 * 1024;
+
+    // Bounds are whole seconds; rounding up keeps readings written by an earlier run in the
+    // same second out of the covered part.
+    startedAtUs_ = storedUs(QDateTime::currentDateTime()) + 1000000;
+}
+
+bool HotWindowStore::isEnabled() const
+{
+    return enabled_;
+}
+
+qint64 HotWindowStore::storedUs(const QDateTime &dateTime)
+{
+    // PostgreSQL drops any zone from a literal cast to timestamp, and Qt::ISODate has no
+    // fractional seconds, so only the wall-clock fields down to the second survive.
+    QTime time = dateTime.time();
+    QDateTime wallClock(dateTime.date(), QTime(time.hour(), time.minute(), time.second()), QTimeZone::UTC);
+    return wallClock.toMSecsSinceEpoch() * 1000;
+}
+
+QDateTime HotWindowStore::storedDateTime(qint64 storedUs)
+{
+    QDateTime wallClock = QDateTime::fromMSecsSinceEpoch(storedUs / 1000, QTimeZone::UTC);
+    return QDateTime(wallClock.date(), wallClock.time());
+}
+
+HotWindowStore::Shard &HotWindowStore::shardFor(qint64 sensorId)
+{
+    return shards_[quint64(sensorId) % shardCount];
+}
+
+void HotWindowStore::Ring::linearize()
+{
+    if (head != 0) {
+        std::rotate(samples.begin(), samples.begin() + head, samples.end());
+        head = 0;
+    }
+}
+
+void HotWindowStore::evictOldest(Ring &ring)
+{
+    ring.coveredFromUs = qMax(ring.coveredFromUs, ring.at(0).recordedAtUs + 1);
+    ring.head = (ring.head + 1) % ring.samples.size();
+    --ring.count;
+    samples_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void HotWindowStore::reserveOne(Ring &ring)
+{
+    size_t capacity = ring.samples.size();
+    if (ring.count < capacity) {
+        return;
+    }
+
+    if (capacity < maxSamplesPerSensor_) {
+        size_t grown = std::min(std::max(capacity * 2, initialCapacity), maxSamplesPerSensor_);
+        qint64 extraBytes = qint64((grown - capacity) * sizeof(Sample));
+        if (bytes_.fetch_add(extraBytes, std::memory_order_relaxed) + extraBytes <= maxBytes_) {
+            ring.linearize();
+            ring.samples.reserve(grown);
+            ring.samples.resize(grown);
+            return;
+        }
+        bytes_.fetch_sub(extraBytes, std::memory_order_relaxed);
+    }
+
+    if (ring.count > 0) {
+        evictOldest(ring);
+    }
+}
+
+void HotWindowStore::append(qint64 sensorId, const MeasurementPoint &point)
+{
+    if (!enabled_) {
+        return;
+    }
+
+    Shard &shard = shardFor(sensorId);
+    QWriteLocker locker(&shard.lock);
+    auto it = shard.rings.find(sensorId);
+    if (it == shard.rings.end()) {
+        Ring ring;
+        ring.coveredFromUs = startedAtUs_.load(std::memory_order_relaxed);
+        it = shard.rings.insert(sensorId, std::move(ring));
+    }
+    Ring &ring = *it;
+
+    qint64 newestUs = ring.count > 0 ? qMax(point.recordedAtUs, ring.at(ring.count - 1).recordedAtUs)
+                                     : point.recordedAtUs;
+    qint64 windowStartUs = newestUs - qint64(settings_.windowSeconds) * 1000000;
+    while (ring.count > 0 && ring.at(0).recordedAtUs < windowStartUs) {
+        evictOldest(ring);
+    }
+
+    if (point.recordedAtUs >= ring.coveredFromUs && point.recordedAtUs >= windowStartUs) {
+        reserveOne(ring);
+    }
+    if (point.recordedAtUs < ring.coveredFromUs || point.recordedAtUs < windowStartUs || ring.samples.empty()) {
+        // Not kept, so the covered part has to start after it; the database still has it.
+        ring.coveredFromUs = qMax(ring.coveredFromUs, point.recordedAtUs + 1);
+        return;
+    }
+
+    Sample sample{point.recordedAtUs, point.id, point.value.value_or(std::nan(""))};
+    auto isBefore = [](const Sample &a, const Sample &b) {
+        return a.recordedAtUs < b.recordedAtUs || (a.recordedAtUs == b.recordedAtUs && a.id < b.id);
+    };
+
+    if (ring.count == 0 || !isBefore(sample, ring.at(ring.count - 1))) {
+        ring.samples[(ring.head + ring.count) % ring.samples.size()] = sample;
+    } else {
+        // Late reading, e.g. after the wall clock stepped back; keep the buffer sorted.
+        ring.linearize();
+        auto end = ring.samples.begin() + ring.count;
+        auto position = std::upper_bound(ring.samples.begin(), end, sample, isBefore);
+        std::move_backward(position, end, end + 1);
+        *position = sample;
+    }
+    ++ring.count;
+    samples_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HotWindowStore::remove(qint64 sensorId)
+{
+    Shard &shard = shardFor(sensorId);
+    QWriteLocker locker(&shard.lock);
+    auto it = shard.rings.find(sensorId);
+    if (it == shard.rings.end()) {
+        return;
+    }
+    bytes_.fetch_sub(qint64(it->samples.size() * sizeof(Sample)), std::memory_order_relaxed);
+    samples_.fetch_sub(qint64(it->count), std::memory_order_relaxed);
+    shard.rings.erase(it);
+}
+
+void HotWindowStore::clear()
+{
+    startedAtUs_.store(storedUs(QDateTime::currentDateTime()) + 1000000, std::memory_order_relaxed);
+    for (Shard &shard : shards_) {
+        QWriteLocker locker(&shard.lock);
+        for (const Ring &ring : std::as_const(shard.rings)) {
+            bytes_.fetch_sub(qint64(ring.samples.size() * sizeof(Sample)), std::memory_order_relaxed);
+            samples_.fetch_sub(qint64(ring.count), std::memory_order_relaxed);
+        }
+        shard.rings.clear();
+    }
+}
+
+std::optional<HotWindowStore::Slice> HotWindowStore::read(qint64 sensorId, qint64 fromUs, qint64 toUs, Order order,
+                                                          qsizetype maxPoints, qint64 beforeUs, qint64 beforeId)
+{
+    if (!enabled_) {
+        return std::nullopt;
+    }
+
+    Shard &shard = shardFor(sensorId);
+    QReadLocker locker(&shard.lock);
+    auto it = shard.rings.constFind(sensorId);
+
+    Slice slice;
+    slice.coveredFromUs = it != shard.rings.constEnd() ? it->coveredFromUs : startedAtUs_;
+    if (toUs < slice.coveredFromUs) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return slice;
+    }
+    (fromUs >= slice.coveredFromUs ? fullHits_ : partialHits_).fetch_add(1, std::memory_order_relaxed);
+    if (it == shard.rings.constEnd()) {
+        return slice;
+    }
+
+    const Ring &ring = *it;
+    qint64 lowerUs = qMax(fromUs, slice.coveredFromUs);
+    auto firstNotMatching = [&ring](auto &&matches) {
+        size_t low = 0;
+        size_t high = ring.count;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (matches(ring.at(middle))) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    };
+    size_t first = firstNotMatching([lowerUs](const Sample &sample) {
+        return sample.recordedAtUs < lowerUs;
+    });
+    size_t last = firstNotMatching([toUs, beforeUs, beforeId](const Sample &sample) {
+        return sample.recordedAtUs <= toUs
+               && (sample.recordedAtUs < beforeUs || (sample.recordedAtUs == beforeUs && sample.id < beforeId));
+    });
+    if (first >= last) {
+        return slice;
+    }
+
+    size_t count = last - first;
+    if (maxPoints >= 0) {
+        count = std::min(count, size_t(maxPoints));
+    }
+    slice.points.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Sample &sample = ring.at(order == Order::OldestFirst ? first + i : last - 1 - i);
+        std::optional<double> value;
+        if (!std::isnan(sample.value)) {
+            value = sample.value;
+        }
+        slice.points.append(MeasurementPoint{sample.id, sample.recordedAtUs, value});
+    }
+    return slice;
+}
+
+HotWindowStore::Stats HotWindowStore::stats() const
+{
+    Stats stats;
+    for (const Shard &shard : shards_) {
+        QReadLocker locker(&shard.lock);
+        stats.sensors += shard.rings.size();
+    }
+    stats.samples = samples_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.maxBytes = maxBytes_;
+    stats.fullHits = fullHits_.load(std::memory_order_relaxed);
+    stats.partialHits = partialHits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    return stats;
+}
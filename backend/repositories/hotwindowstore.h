@@ -0,0 +1,127 @@
+#ifndef HOTWINDOWSTORE_H
+#define HOTWINDOWSTORE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <optional>
+#include <vector>
+#include "../models/measurementpoint.h"
+
+// Per-sensor ring buffers of the readings this process committed during the last
+// windowSeconds. Timestamps are in the database's clock domain: microseconds of the stored
+// wall-clock time read as UTC, the same value extract(epoch FROM recorded_at) yields.
+//
+// A sensor's buffer is complete from coveredFromUs on: every reading at or after it is held,
+// because it was ingested here after startup and has not been evicted yet. Readers take that
+// part from memory and only ask the database for what lies before it. This holds only while
+// this process is the sole writer of measurements, so the store is off unless enabled.
+class HotWindowStore
+{
+public:
+    struct Settings {
+        bool enabled = false;
+        int windowSeconds = 86400;
+        int maxSamplesPerSensor = 17280;   // One reading every 5 s over 24 h
+        int maxMemoryMb = 128;             // Shared by all buffers; full buffers evict their oldest reading
+    };
+
+    struct Stats {
+        int sensors = 0;
+        qint64 samples = 0;
+        qint64 bytes = 0;
+        qint64 maxBytes = 0;
+        quint64 fullHits = 0;       // Reads answered from memory alone
+        quint64 partialHits = 0;    // Reads stitched from memory and the database
+        quint64 misses = 0;         // Reads entirely before the covered part
+    };
+
+    enum class Order { OldestFirst, NewestFirst };
+
+    struct Slice {
+        qint64 coveredFromUs = 0;
+        QList<MeasurementPoint> points;
+    };
+
+    static HotWindowStore& instance();
+
+    // Applies the settings and starts coverage now. Call once at startup, before ingest begins.
+    void configure(const Settings& settings);
+    bool isEnabled() const;
+
+    // The timestamp a QDateTime range bound compares against once bound as an ISO string.
+    static qint64 storedUs(const QDateTime& dateTime);
+    // The QDateTime QPSQL returns for a stored timestamp.
+    static QDateTime storedDateTime(qint64 storedUs);
+
+    void append(qint64 sensorId, const MeasurementPoint& point);
+    void remove(qint64 sensorId);
+    // Drops every buffer and restarts coverage now, for when the table was rewritten behind
+    // the store's back.
+    void clear();
+
+    // Readings with max(fromUs, coveredFromUs) <= recorded_at <= toUs and (recorded_at, id)
+    // below (beforeUs, beforeId), at most maxPoints of them taken from the end `order` starts
+    // at. std::nullopt when the store is disabled.
+    std::optional<Slice> read(qint64 sensorId, qint64 fromUs, qint64 toUs, Order order, qsizetype maxPoints = -1,
+                              qint64 beforeUs = std::numeric_limits<qint64>::max(),
+                              qint64 beforeId = std::numeric_limits<qint64>::max());
+
+    Stats stats() const;
+
+private:
+    HotWindowStore() = default;
+
+    HotWindowStore(const HotWindowStore&) = delete;
+    HotWindowStore& operator=(const HotWindowStore&) = delete;
+
+    // 24 bytes per reading; a missing value is stored as NaN.
+    struct Sample {
+        qint64 recordedAtUs;
+        qint64 id;
+        double value;
+    };
+
+    struct Ring {
+        std::vector<Sample> samples;
+        size_t head = 0;      // Index of the oldest sample
+        size_t count = 0;
+        qint64 coveredFromUs = 0;
+
+        const Sample& at(size_t i) const { return samples[(head + i) % samples.size()]; }
+        void linearize();
+    };
+
+    struct Shard {
+        mutable QReadWriteLock lock;
+        QHash<qint64, Ring> rings;
+    };
+
+    static constexpr int shardCount = 16;
+    static constexpr size_t initialCapacity = 64;
+
+    Shard& shardFor(qint64 sensorId);
+    // Makes room for one more sample, growing the buffer while the memory budget allows and
+    // evicting the oldest sample otherwise.
+    void reserveOne(Ring& ring);
+    void evictOldest(Ring& ring);
+
+    Settings settings_;
+    bool enabled_ = false;
+    std::atomic<qint64> startedAtUs_ {0};
+    size_t maxSamplesPerSensor_ = 0;
+    qint64 maxBytes_ = 0;
+
+    std::array<Shard, shardCount> shards_;
+    std::atomic<qint64> bytes_ {0};
+    std::atomic<qint64> samples_ {0};
+    std::atomic<quint64> fullHits_ {0};
+    std::atomic<quint64> partialHits_ {0};
+    std::atomic<quint64> misses_ {0};
+};
+
+#endif // HOTWINDOWSTORE_H
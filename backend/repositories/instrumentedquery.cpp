@@ -0,0 +1,277 @@
+#include "instrumentedquery.h"
+#include "../controllers/dbcontroller.h"
+#include "../controllers/statementcache.h"
+#include "../utils/logevent.h"
+#include "../utils/metrics.h"
+#include "slowquerylog.h"
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+#include <chrono>
+
+namespace {
+
+constexpr int maxRenderedParameters = 32;
+constexpr qsizetype maxRenderedValueLength = 200;
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct SiteMetrics {
+    MetricsRegistry::Histogram *prepare;
+    MetricsRegistry::Histogram *exec;
+    MetricsRegistry::Histogram *fetch;
+    MetricsRegistry::Counter *rows;
+};
+
+// Cached per thread by the address of the literal, like DbQueryTimer.
+SiteMetrics siteMetrics(const char *site)
+{
+    thread_local QHash<const char *, SiteMetrics> cache;
+    auto cached = cache.constFind(site);
+    if (cached != cache.constEnd()) {
+        return *cached;
+    }
+
+    MetricsRegistry &registry = MetricsRegistry::instance();
+    auto phase = [&](const char *name) {
+        return &registry.histogram("arkanova_db_statement_duration_seconds",
+                                   "Time spent preparing, executing and fetching statements, by call site.",
+                                   {{"site", site}, {"phase", name}});
+    };
+    SiteMetrics metrics {phase("prepare"), phase("exec"), phase("fetch"),
+                         &registry.counter("arkanova_db_rows_fetched_total", "Rows fetched, by call site.",
+                                           {{"site", site}})};
+    cache.insert(site, metrics);
+    return metrics;
+}
+
+QString renderValue(const QString &placeholder, const QVariant &value)
+{
+    if (placeholder.contains("password", Qt::CaseInsensitive)) {
+        return "***";
+    }
+    if (value.isNull()) {
+        return "NULL";
+    }
+    QString rendered = value.toString();
+    if (rendered.size() > maxRenderedValueLength) {
+        rendered.truncate(maxRenderedValueLength);
+        rendered += "...";
+    }
+    return rendered;
+}
+
+}
+
+InstrumentedQuery::InstrumentedQuery(const char *site)
+    : InstrumentedQuery(site, DBController::getDatabase())
+{
+}
+
+InstrumentedQuery::InstrumentedQuery(const char *site, const QSqlDatabase &db)
+    : site_(site), db_(db), query_(db)
+{
+}
+
+InstrumentedQuery::~InstrumentedQuery()
+{
+    release();
+}
+
+InstrumentedQuery::InstrumentedQuery(InstrumentedQuery &&other) noexcept
+    : site_(other.site_), db_(std::move(other.db_)), query_(std::move(other.query_)), sql_(std::move(other.sql_)),
+      prepareNs_(other.prepareNs_), execNs_(other.execNs_), fetchNs_(other.fetchNs_), rows_(other.rows_),
+      executed_(other.executed_), finished_(other.finished_), forwardOnly_(other.forwardOnly_),
+      cacheable_(other.cacheable_), cacheGeneration_(other.cacheGeneration_)
+{
+    other.finished_ = true;
+    other.cacheable_ = false;
+}
+
+InstrumentedQuery &InstrumentedQuery::operator=(InstrumentedQuery &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        site_ = other.site_;
+        db_ = std::move(other.db_);
+        query_ = std::move(other.query_);
+        sql_ = std::move(other.sql_);
+        prepareNs_ = other.prepareNs_;
+        execNs_ = other.execNs_;
+        fetchNs_ = other.fetchNs_;
+        rows_ = other.rows_;
+        executed_ = other.executed_;
+        finished_ = other.finished_;
+        forwardOnly_ = other.forwardOnly_;
+        cacheable_ = other.cacheable_;
+        cacheGeneration_ = other.cacheGeneration_;
+        other.finished_ = true;
+        other.cacheable_ = false;
+    }
+    return *this;
+}
+
+void InstrumentedQuery::setForwardOnly(bool forward)
+{
+    forwardOnly_ = forward;
+    query_.setForwardOnly(forward);
+}
+
+bool InstrumentedQuery::prepare(const QString &sql)
+{
+    finish();
+    sql_ = sql;
+    prepareNs_ = 0;
+    executed_ = false;
+
+    StatementCache &cache = StatementCache::local();
+    cacheable_ = cache.serves(db_.connectionName());
+    if (cacheable_) {
+        cacheGeneration_ = cache.generation();
+        // The previous bindings are still set; callers bind every placeholder again.
+        if (std::unique_ptr<QSqlQuery> cached = cache.take(sql)) {
+            query_ = std::move(*cached);
+            query_.setForwardOnly(forwardOnly_);
+            return true;
+        }
+    }
+
+    qint64 start = nowNs();
+    bool prepared = query_.prepare(sql);
+    prepareNs_ = nowNs() - start;
+    siteMetrics(site_).prepare->observeNs(prepareNs_);
+    cacheable_ = cacheable_ && prepared;
+    return prepared;
+}
+
+bool InstrumentedQuery::exec()
+{
+    finish();
+    fetchNs_ = 0;
+    rows_ = 0;
+    finished_ = false;
+
+    qint64 start = nowNs();
+    executed_ = query_.exec();
+    execNs_ = nowNs() - start;
+    siteMetrics(site_).exec->observeNs(execNs_);
+    return executed_;
+}
+
+bool InstrumentedQuery::next()
+{
+    qint64 start = nowNs();
+    bool fetched = query_.next();
+    fetchNs_ += nowNs() - start;
+    if (fetched) {
+        ++rows_;
+    } else {
+        finish();
+    }
+    return fetched;
+}
+
+void InstrumentedQuery::finish()
+{
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+
+    SiteMetrics metrics = siteMetrics(site_);
+    metrics.fetch->observeNs(fetchNs_);
+    metrics.rows->increment(quint64(rows_));
+
+    SlowQueryLog &slowLog = SlowQueryLog::instance();
+    qint64 thresholdNs = slowLog.thresholdNs();
+    qint64 totalNs = prepareNs_ + execNs_ + fetchNs_;
+    if (thresholdNs <= 0 || totalNs < thresholdNs) {
+        return;
+    }
+
+    SlowQueryLog::Entry entry;
+    entry.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    entry.site = site_;
+    entry.sql = sql_.simplified();
+    entry.prepareUs = prepareNs_ / 1000;
+    entry.execUs = execNs_ / 1000;
+    entry.fetchUs = fetchNs_ / 1000;
+    entry.rows = rows_;
+    if (!executed_) {
+        entry.error = query_.lastError().text();
+    }
+
+    // Batched inserts bind thousands of values; the first few identify the statement.
+    QVariantList values = query_.boundValues();
+    QStringList names = query_.boundValueNames();
+    QStringList rendered;
+    for (qsizetype i = 0; i < values.size() && i < maxRenderedParameters; ++i) {
+        QString name = i < names.size() && names.at(i).startsWith(':') ? names.at(i) : QString("$%1").arg(i + 1);
+        entry.parameters.append({name, renderValue(name, values.at(i))});
+        rendered.append(name + '=' + entry.parameters.last().second);
+    }
+    entry.omittedParameters = int(qMax<qsizetype>(0, values.size() - maxRenderedParameters));
+
+    // ANALYZE runs the statement again, so only reads are explained.
+    if (executed_ && sql_.trimmed().startsWith("SELECT", Qt::CaseInsensitive) && slowLog.claimExplain(site_)) {
+        entry.plan = explain();
+    }
+
+    static LogSite site("db.slow_query", Logger::LogLevel::Warning, {.maxPerSecond = 10});
+    if (site.shouldLog()) {
+        LogEvent event(site);
+        event.add("site", QString::fromLatin1(site_))
+            .add("total_ms", double(totalNs) / 1e6)
+            .add("prepare_ms", double(prepareNs_) / 1e6)
+            .add("exec_ms", double(execNs_) / 1e6)
+            .add("fetch_ms", double(fetchNs_) / 1e6)
+            .add("rows", rows_)
+            .add("sql", entry.sql)
+            .add("params", rendered.join(", "))
+            .add("explained", !entry.plan.isEmpty());
+        if (!entry.error.isEmpty()) {
+            event.add("error", entry.error);
+        }
+        event.write();
+    }
+
+    slowLog.record(std::move(entry));
+}
+
+void InstrumentedQuery::release()
+{
+    finish();
+    if (cacheable_ && executed_ && !query_.lastError().isValid()) {
+        StatementCache::local().give(sql_, std::move(query_), cacheGeneration_);
+    }
+    cacheable_ = false;
+}
+
+QString InstrumentedQuery::explain()
+{
+    // A cursor destroyed early may still have rows pending on the connection.
+    QVariantList values = query_.boundValues();
+    query_.finish();
+
+    QSqlQuery explain(db_);
+    explain.setForwardOnly(true);
+    if (!explain.prepare("EXPLAIN (ANALYZE, BUFFERS) " + sql_)) {
+        return "EXPLAIN failed: " + explain.lastError().text();
+    }
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        explain.bindValue(int(i), values.at(i));
+    }
+    if (!explain.exec()) {
+        return "EXPLAIN failed: " + explain.lastError().text();
+    }
+
+    QStringList plan;
+    while (explain.next()) {
+        plan.append(explain.value(0).toString());
+    }
+    return plan.join('\n');
+}
@@ -0,0 +1,77 @@
+#ifndef INSTRUMENTEDQUERY_H
+#define INSTRUMENTEDQUERY_H
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QVariant>
+
+// The QSqlQuery repositories run their statements through. Prepare, exec and fetch are timed
+// separately into arkanova_db_statement_duration_seconds{site,phase} and fetched rows are
+// counted. When the statement is done (its result exhausted, or the query destroyed or
+// reassigned) a total above SlowQueryLog's threshold is logged and recorded there together
+// with the bound values, and, if enabled, the plan of a slow SELECT. A query a RowCursor holds
+// open therefore reports the whole time spent streaming it. `site` names the repository
+// method and must be a string literal.
+//
+// On the thread's pooled connection, prepare() takes the statement from StatementCache when
+// the same SQL ran before and the query hands it back once destroyed, so repeated statements
+// skip the PREPARE and DEALLOCATE round-trips.
+class InstrumentedQuery
+{
+public:
+    InstrumentedQuery() = default;
+    // Runs on the calling thread's connection.
+    explicit InstrumentedQuery(const char* site);
+    InstrumentedQuery(const char* site, const QSqlDatabase& db);
+    ~InstrumentedQuery();
+
+    InstrumentedQuery(InstrumentedQuery&& other) noexcept;
+    InstrumentedQuery& operator=(InstrumentedQuery&& other) noexcept;
+    InstrumentedQuery(const InstrumentedQuery&) = delete;
+    InstrumentedQuery& operator=(const InstrumentedQuery&) = delete;
+
+    void setForwardOnly(bool forward);
+
+    bool prepare(const QString& sql);
+    void bindValue(const QString& placeholder, const QVariant& value) { query_.bindValue(placeholder, value); }
+    void addBindValue(const QVariant& value) { query_.addBindValue(value); }
+    bool exec();
+    bool next();
+
+    QVariant value(int index) const { return query_.value(index); }
+    QVariant value(const QString& name) const { return query_.value(name); }
+    QSqlRecord record() const { return query_.record(); }
+    QSqlError lastError() const { return query_.lastError(); }
+    int numRowsAffected() const { return query_.numRowsAffected(); }
+    QVariant lastInsertId() const { return query_.lastInsertId(); }
+    bool isActive() const { return query_.isActive(); }
+
+    // For row mappers, which read the current row.
+    const QSqlQuery& sqlQuery() const { return query_; }
+
+private:
+    // Records the fetch phase and the slow-query check, once.
+    void finish();
+    // finish(), then returns a reusable statement to the cache; query_ is moved from afterwards.
+    void release();
+    QString explain();
+
+    const char* site_ = nullptr;
+    QSqlDatabase db_;
+    QSqlQuery query_;
+    QString sql_;
+
+    qint64 prepareNs_ = 0;
+    qint64 execNs_ = 0;
+    qint64 fetchNs_ = 0;
+    qint64 rows_ = 0;
+    bool executed_ = false;
+    bool finished_ = true;
+    bool forwardOnly_ = false;
+    bool cacheable_ = false;
+    quint64 cacheGeneration_ = 0;
+};
+
+#endif // INSTRUMENTEDQUERY_H
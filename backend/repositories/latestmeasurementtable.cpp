@@ -0,0 +1,98 @@
+#include "latestmeasurementtable.h"
+
+LatestMeasurementTable &LatestMeasurementTable::instance()
+{
+    static LatestMeasurementTable tableInstance;
+    return tableInstance;
+}
+
+LatestMeasurementTable::Shard &LatestMeasurementTable::shardFor(qint64 sensorId)
+{
+    return shards_[quint64(sensorId) % shardCount];
+}
+
+const LatestMeasurementTable::Shard &LatestMeasurementTable::shardFor(qint64 sensorId) const
+{
+    return shards_[quint64(sensorId) % shardCount];
+}
+
+std::optional<MeasurementPoint> LatestMeasurementTable::latest(qint64 sensorId)
+{
+    Shard &shard = shardFor(sensorId);
+    QReadLocker locker(&shard.lock);
+    auto it = shard.points.constFind(sensorId);
+    if (it == shard.points.constEnd()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return *it;
+}
+
+void LatestMeasurementTable::update(qint64 sensorId, const MeasurementPoint &point)
+{
+    Shard &shard = shardFor(sensorId);
+    QWriteLocker locker(&shard.lock);
+    updateLocked(shard, sensorId, point);
+}
+
+quint64 LatestMeasurementTable::generation(qint64 sensorId) const
+{
+    const Shard &shard = shardFor(sensorId);
+    QReadLocker locker(&shard.lock);
+    return shard.generation;
+}
+
+bool LatestMeasurementTable::fill(qint64 sensorId, const MeasurementPoint &point, quint64 generation)
+{
+    Shard &shard = shardFor(sensorId);
+    QWriteLocker locker(&shard.lock);
+    // Per shard rather than per sensor: a removal elsewhere in the shard only costs this
+    // caller its fill, and the next miss queries again.
+    if (shard.generation != generation) {
+        return false;
+    }
+    updateLocked(shard, sensorId, point);
+    return true;
+}
+
+void LatestMeasurementTable::updateLocked(Shard &shard, qint64 sensorId, const MeasurementPoint &point)
+{
+    auto it = shard.points.find(sensorId);
+    if (it == shard.points.end()) {
+        shard.points.insert(sensorId, point);
+        return;
+    }
+    if (point.recordedAtUs > it->recordedAtUs || (point.recordedAtUs == it->recordedAtUs && point.id > it->id)) {
+        *it = point;
+    }
+}
+
+void LatestMeasurementTable::remove(qint64 sensorId)
+{
+    Shard &shard = shardFor(sensorId);
+    QWriteLocker locker(&shard.lock);
+    shard.points.remove(sensorId);
+    ++shard.generation;
+}
+
+void LatestMeasurementTable::clear()
+{
+    for (Shard &shard : shards_) {
+        QWriteLocker locker(&shard.lock);
+        shard.points.clear();
+        ++shard.generation;
+    }
+}
+
+LatestMeasurementTable::Stats LatestMeasurementTable::stats() const
+{
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    for (const Shard &shard : shards_) {
+        QReadLocker locker(&shard.lock);
+        stats.sensors += shard.points.size();
+    }
+    return stats;
+}
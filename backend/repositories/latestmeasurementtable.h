@@ -0,0 +1,61 @@
+#ifndef LATESTMEASUREMENTTABLE_H
+#define LATESTMEASUREMENTTABLE_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <array>
+#include <atomic>
+#include <optional>
+#include "../models/measurementpoint.h"
+
+// Process-wide table of each sensor's newest reading. Ingest updates it after every committed
+// batch and the latest-measurement endpoint reads it instead of querying. Sensors are spread
+// over independently locked shards so readers on worker threads rarely contend with ingest.
+class LatestMeasurementTable
+{
+public:
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        int sensors = 0;
+    };
+
+    static LatestMeasurementTable& instance();
+
+    std::optional<MeasurementPoint> latest(qint64 sensorId);
+
+    // Keeps whichever of the stored and the given point is newer in (recorded_at, id) order.
+    void update(qint64 sensorId, const MeasurementPoint& point);
+    // For filling the table from a query: take generation() before the query and pass it
+    // here; the point is dropped if the sensor was removed (or the table cleared) meanwhile.
+    quint64 generation(qint64 sensorId) const;
+    bool fill(qint64 sensorId, const MeasurementPoint& point, quint64 generation);
+    void remove(qint64 sensorId);
+    void clear();
+
+    Stats stats() const;
+
+private:
+    LatestMeasurementTable() = default;
+
+    LatestMeasurementTable(const LatestMeasurementTable&) = delete;
+    LatestMeasurementTable& operator=(const LatestMeasurementTable&) = delete;
+
+    static constexpr int shardCount = 16;
+
+    struct Shard {
+        mutable QReadWriteLock lock;
+        QHash<qint64, MeasurementPoint> points;
+        quint64 generation = 0;   // Bumped by every remove() and clear() on this shard
+    };
+
+    Shard& shardFor(qint64 sensorId);
+    const Shard& shardFor(qint64 sensorId) const;
+    void updateLocked(Shard& shard, qint64 sensorId, const MeasurementPoint& point);
+
+    std::array<Shard, shardCount> shards_;
+    std::atomic<quint64> hits_ {0};
+    std::atomic<quint64> misses_ {0};
+};
+
+#endif // LATESTMEASUREMENTTABLE_H
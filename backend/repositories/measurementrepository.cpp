@@ -1,59 +1,162 @@
 #include "measurementrepository.h"
 #include "../controllers/dbcontroller.h"
+#include "../utils/metrics.h"
+#include "instrumentedquery.h"
+#include "hotwindowstore.h"
 #include "sensorrepository.h"
+#include "rowmapper.h"
 #include <qdatetime.h>
 #include <qsqlerror.h>
+#include <memory>
 
 MeasurementRepository::MeasurementRepository() {}
 
 std::optional<Measurement> MeasurementRepository::fetchById(qint64 id) {
-    QSqlQuery query(DBController::getDatabase());
-    QString queryString = R"(
-        SELECT id, data, recorded_at, sensor_id
-        FROM measurement
-        WHERE id = :id
-    )";
-    query.prepare(queryString);
+    DbQueryTimer queryTimer("MeasurementRepository::fetchById");
+    InstrumentedQuery query("MeasurementRepository::fetchById");
+    query.prepare(QString(R"(
+        SELECT %1
+        FROM measurement m
+        JOIN %2 ON s.id = m.sensor_id
+        WHERE m.id = :id
+    )").arg(RowMapper::measurementColumns(), RowMapper::sensorJoins()));
     query.bindValue(":id", id);
 
     if (query.exec() && query.next()) {
-        SensorRepository sensorRepository;
-        qint64 measurementId = query.value("id").toLongLong();
-        QByteArray data = query.value("data").toByteArray();
-        QDateTime recordedAt = query.value("recorded_at").toDateTime();
-        auto sensor = sensorRepository.getSensorById(query.value("sensor_id").toLongLong());
-        if(!sensor) {
-            return std::nullopt;
-        }
-
-        return Measurement(measurementId, data, recordedAt, sensor.value());
+        return RowMapper(query.record()).measurement(query.sqlQuery());
     }
 
     qDebug() << "Database error while fetching Measurement by ID:" << query.lastError().text();
     return std::nullopt;
 }
 
-QList<Measurement> MeasurementRepository::getMeasurementsBySensorAndDate(qint64 sensorId,
-                                                                         const QDateTime& startDate,
-                                                                         const QDateTime& endDate) {
-    QList<Measurement> measurements;
-    QSqlQuery query(DBController::getDatabase());
+QByteArray MeasurementKey::encode() const {
+    return QByteArray::number(recordedAtUs).append(':').append(QByteArray::number(id))
+        .toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+}
 
-    QString queryString = R"(
-        SELECT id, data, recorded_at, sensor_id
-        FROM measurement
-        WHERE sensor_id = :sensor_id
-    )";
+std::optional<MeasurementKey> MeasurementKey::decode(const QByteArray& cursor) {
+    auto decoded = QByteArray::fromBase64Encoding(cursor, QByteArray::Base64UrlEncoding | QByteArray::AbortOnBase64DecodingErrors);
+    if (!decoded) {
+        return std::nullopt;
+    }
+
+    QList<QByteArray> parts = decoded->split(':');
+    if (parts.size() != 2) {
+        return std::nullopt;
+    }
+
+    bool timeOk, idOk;
+    MeasurementKey key{parts.at(0).toLongLong(&timeOk), parts.at(1).toLongLong(&idOk)};
+    if (!timeOk || !idOk) {
+        return std::nullopt;
+    }
+    return key;
+}
+
+namespace {
+
+qint64 lowerBoundUs(const QDateTime& startDate) {
+    return startDate.isNull() ? std::numeric_limits<qint64>::min() : HotWindowStore::storedUs(startDate);
+}
+
+qint64 upperBoundUs(const QDateTime& endDate) {
+    return endDate.isNull() ? std::numeric_limits<qint64>::max() : HotWindowStore::storedUs(endDate);
+}
+
+// Yields the rows held in `rows`, then whatever `rest` yields.
+template <typename T>
+RowCursor<T> chainCursor(QList<T> rows, RowCursor<T> rest, bool restFirst) {
+    auto state = std::make_shared<std::pair<QList<T>, RowCursor<T>>>(std::move(rows), std::move(rest));
+    auto index = std::make_shared<qsizetype>(0);
+    return RowCursor<T>([state, index, restFirst]() -> std::optional<T> {
+        if (restFirst) {
+            if (auto row = state->second.next()) {
+                return row;
+            }
+        }
+        if (*index < state->first.size()) {
+            return state->first.at((*index)++);
+        }
+        return restFirst ? std::nullopt : state->second.next();
+    });
+}
+
+} // namespace
+
+RowCursor<MeasurementRow> MeasurementRepository::openPage(qint64 sensorId,
+                                                         const QDateTime& startDate,
+                                                         const QDateTime& endDate,
+                                                         const std::optional<MeasurementKey>& after,
+                                                         int limit) {
+    DbQueryTimer queryTimer("MeasurementRepository::openPage");
+    qint64 fromUs = lowerBoundUs(startDate);
+    auto slice = HotWindowStore::instance().read(
+        sensorId, fromUs, upperBoundUs(endDate), HotWindowStore::Order::NewestFirst, qsizetype(limit) + 1,
+        after ? after->recordedAtUs : std::numeric_limits<qint64>::max(),
+        after ? after->id : std::numeric_limits<qint64>::max());
+    if (!slice) {
+        return openDatabasePage(sensorId, startDate, endDate, after, limit + 1);
+    }
+
+    // Rows from memory carry the same sensor graph as database rows, which the JSON needs to
+    // decide whether values are shown; resolved once per page from the metadata cache.
+    Sensor sensor = slice->points.isEmpty() ? Sensor() : SensorRepository().getSensorById(sensorId).value_or(Sensor());
+    QList<MeasurementRow> rows;
+    rows.reserve(slice->points.size());
+    for (const MeasurementPoint& point : std::as_const(slice->points)) {
+        rows.append(MeasurementRow{Measurement(point.id, point.value, HotWindowStore::storedDateTime(point.recordedAtUs), sensor),
+                                   MeasurementKey{point.recordedAtUs, point.id}});
+    }
+
+    RowCursor<MeasurementRow> older;
+    if (rows.size() <= limit && fromUs < slice->coveredFromUs) {
+        // The page reaches past the covered part; the database supplies the older rows.
+        MeasurementKey coveredStart{slice->coveredFromUs, std::numeric_limits<qint64>::min()};
+        bool afterIsOlder = after && (after->recordedAtUs < coveredStart.recordedAtUs);
+        older = openDatabasePage(sensorId, startDate, endDate, afterIsOlder ? after : coveredStart,
+                                 limit + 1 - int(rows.size()));
+        if (!older.isValid()) {
+            return {};
+        }
+    }
+    return chainCursor(std::move(rows), std::move(older), false);
+}
+
+RowCursor<MeasurementRow> MeasurementRepository::openDatabasePage(qint64 sensorId,
+                                                                 const QDateTime& startDate,
+                                                                 const QDateTime& endDate,
+                                                                 const std::optional<MeasurementKey>& after,
+                                                                 int rows) {
+    InstrumentedQuery query("MeasurementRepository::openDatabasePage");
+    query.setForwardOnly(true);
 
+    // One round-trip regardless of the row count: the sensor graph comes back on every row
+    // and the mapper only builds it once.
+    QString queryString = QString(R"(
+        SELECT %1, CAST(extract(epoch FROM m.recorded_at) * 1000000 AS bigint) AS m_recorded_at_us
+        FROM measurement m
+        JOIN %2 ON s.id = m.sensor_id
+        WHERE m.sensor_id = :sensor_id
+    )").arg(RowMapper::measurementColumns(), RowMapper::sensorJoins());
+
+    // Bounds compare the bare partition key against typed parameters so partitions outside
+    // the range are pruned.
     if (!startDate.isNull()) {
-        queryString += " AND recorded_at >= :start_date";
+        queryString += " AND m.recorded_at >= CAST(:start_date AS timestamp)";
     }
 
     if (!endDate.isNull()) {
-        queryString += " AND recorded_at <= :end_date";
+        queryString += " AND m.recorded_at <= CAST(:end_date AS timestamp)";
+    }
+
+    // Row comparison on the (sensor_id, recorded_at, id) index: each page is a seek, not an OFFSET scan.
+    if (after) {
+        queryString += R"( AND (m.recorded_at, m.id) <
+                           (TIMESTAMP 'epoch' + CAST(:after_us AS bigint) * interval '1 microsecond', CAST(:after_id AS bigint)))";
     }
 
-    queryString += " ORDER BY recorded_at DESC";
+    queryString += " ORDER BY m.recorded_at DESC, m.id DESC LIMIT :limit";
 
     query.prepare(queryString);
     query.bindValue(":sensor_id", sensorId);
@@ -66,76 +169,403 @@ QList<Measurement> MeasurementRepository::getMeasurementsBySensorAndDate(qint64
         query.bindValue(":end_date", endDate.toString(Qt::ISODate));
     }
 
-    if (query.exec()) {
-        while (query.next()) {
-            SensorRepository sensorRepository;
-            auto sensor = sensorRepository.getSensorById(query.value("sensor_id").toLongLong());
-            if(!sensor) {
-                return {};
-            }
+    if (after) {
+        query.bindValue(":after_us", after->recordedAtUs);
+        query.bindValue(":after_id", after->id);
+    }
+    query.bindValue(":limit", rows);
 
-            measurements.append(Measurement(query.value("id").toLongLong(),
-                                            query.value("data").toByteArray(),
-                                            query.value("recorded_at").toDateTime(),
-                                            sensor.value()));
-        }
-    } else {
+    if (!query.exec()) {
         qDebug() << "Database error while fetching Measurements by Sensor and Date:" << query.lastError().text();
+        return {};
     }
 
-    return measurements;
+    auto mapper = std::make_shared<RowMapper>(query.record());
+    int idColumn = query.record().indexOf("m_id");
+    int recordedAtUsColumn = query.record().indexOf("m_recorded_at_us");
+    return RowCursor<MeasurementRow>(std::move(query), [mapper, idColumn, recordedAtUsColumn](const QSqlQuery& row) {
+        return MeasurementRow{mapper->measurement(row),
+                              MeasurementKey{row.value(recordedAtUsColumn).toLongLong(), row.value(idColumn).toLongLong()}};
+    });
 }
 
-std::optional<Measurement> MeasurementRepository::createMeasurement(const QByteArray& data, qint64 sensorId) {
-    QSqlQuery query(DBController::getDatabase());
-    query.prepare(R"(
-        INSERT INTO measurement (data, sensor_id)
-        VALUES (:data, :sensor_id)
-        RETURNING id, data, recorded_at, sensor_id
-    )");
+RowCursor<MeasurementPoint> MeasurementRepository::openSeries(qint64 sensorId,
+                                                             const QDateTime &startDate,
+                                                             const QDateTime &endDate) {
+    DbQueryTimer queryTimer("MeasurementRepository::openSeries");
+    // Only readings with a value are series points, and a sensor whose readings are not shown
+    // has none to offer.
+    if (!SensorRepository().reportsReadings(sensorId)) {
+        return RowCursor<MeasurementPoint>([]() { return std::optional<MeasurementPoint>(); });
+    }
+    qint64 fromUs = lowerBoundUs(startDate);
+    auto slice = HotWindowStore::instance().read(sensorId, fromUs, upperBoundUs(endDate),
+                                                 HotWindowStore::Order::OldestFirst);
+    if (!slice) {
+        return openDatabaseSeries(sensorId, startDate, endDate, std::nullopt);
+    }
+
+    QList<MeasurementPoint> points;
+    points.reserve(slice->points.size());
+    for (const MeasurementPoint& point : std::as_const(slice->points)) {
+        if (point.value) {
+            points.append(point);
+        }
+    }
+
+    RowCursor<MeasurementPoint> older;
+    if (fromUs < slice->coveredFromUs) {
+        older = openDatabaseSeries(sensorId, startDate, endDate, slice->coveredFromUs);
+        if (!older.isValid()) {
+            return {};
+        }
+    }
+    return chainCursor(std::move(points), std::move(older), true);
+}
+
+RowCursor<MeasurementPoint> MeasurementRepository::openDatabaseSeries(qint64 sensorId,
+                                                                     const QDateTime &startDate,
+                                                                     const QDateTime &endDate,
+                                                                     std::optional<qint64> beforeUs) {
+    InstrumentedQuery query("MeasurementRepository::openDatabaseSeries");
+    query.setForwardOnly(true);
+
+    QString queryString = R"(
+        SELECT m.id, CAST(extract(epoch FROM m.recorded_at) * 1000000 AS bigint) AS recorded_at_us, m.value
+        FROM measurement m
+        WHERE m.sensor_id = :sensor_id AND m.value IS NOT NULL
+    )";
+    if (!startDate.isNull()) {
+        queryString += " AND m.recorded_at >= CAST(:start_date AS timestamp)";
+    }
+    if (!endDate.isNull()) {
+        queryString += " AND m.recorded_at <= CAST(:end_date AS timestamp)";
+    }
+    if (beforeUs) {
+        queryString += " AND m.recorded_at < TIMESTAMP 'epoch' + CAST(:before_us AS bigint) * interval '1 microsecond'";
+    }
+    queryString += " ORDER BY m.recorded_at, m.id";
+
+    query.prepare(queryString);
+    query.bindValue(":sensor_id", sensorId);
+    if (!startDate.isNull()) {
+        query.bindValue(":start_date", startDate.toString(Qt::ISODate));
+    }
+    if (!endDate.isNull()) {
+        query.bindValue(":end_date", endDate.toString(Qt::ISODate));
+    }
+    if (beforeUs) {
+        query.bindValue(":before_us", *beforeUs);
+    }
 
-    query.bindValue(":data", data);
+    if (!query.exec()) {
+        qDebug() << "Database error while opening Measurement series:" << query.lastError().text();
+        return {};
+    }
+    return RowCursor<MeasurementPoint>(std::move(query), [](const QSqlQuery& row) {
+        return MeasurementPoint{row.value(0).toLongLong(), row.value(1).toLongLong(), row.value(2).toDouble()};
+    });
+}
+
+QList<MeasurementBucket> MeasurementRepository::aggregateBySensor(qint64 sensorId,
+                                                                 const QDateTime &startDate,
+                                                                 const QDateTime &endDate,
+                                                                 qint64 bucketSeconds,
+                                                                 MeasurementBucket::Aggregates aggregates) {
+    DbQueryTimer queryTimer("MeasurementRepository::aggregateBySensor");
+    // Buckets of a sensor whose readings are not shown keep their counts but no values.
+    bool reportsReadings = SensorRepository().reportsReadings(sensorId);
+    using Aggregate = MeasurementBucket::Aggregate;
+    QList<MeasurementBucket> buckets;
+
+    // Only the requested aggregates are computed. First/last come from a DISTINCT ON pass per
+    // direction, which keeps one row per bucket instead of collecting every value into an array.
+    QStringList columns;
+    QString outerColumns = "g.bucket_start";
+    auto addGrouped = [&columns, &outerColumns](const QString &expression, const QString &name) {
+        columns << expression + " AS " + name;
+        outerColumns += ", g." + name;
+    };
+    if (aggregates & Aggregate::Min) {
+        addGrouped("min(b.value)", "min_value");
+    }
+    if (aggregates & Aggregate::Max) {
+        addGrouped("max(b.value)", "max_value");
+    }
+    if (aggregates & Aggregate::Avg) {
+        addGrouped("avg(b.value)", "avg_value");
+    }
+    if (aggregates & Aggregate::Count) {
+        addGrouped("count(b.value)", "count_value");
+    }
+    QString joins;
+    if (aggregates & Aggregate::First) {
+        outerColumns += ", f.first_value";
+        joins += R"(
+        LEFT JOIN (
+            SELECT DISTINCT ON (b.bucket_start) b.bucket_start, b.value AS first_value
+            FROM b
+            WHERE b.value IS NOT NULL
+            ORDER BY b.bucket_start, b.recorded_at, b.id
+        ) f ON f.bucket_start = g.bucket_start)";
+    }
+    if (aggregates & Aggregate::Last) {
+        outerColumns += ", l.last_value";
+        joins += R"(
+        LEFT JOIN (
+            SELECT DISTINCT ON (b.bucket_start) b.bucket_start, b.value AS last_value
+            FROM b
+            WHERE b.value IS NOT NULL
+            ORDER BY b.bucket_start, b.recorded_at DESC, b.id DESC
+        ) l ON l.bucket_start = g.bucket_start)";
+    }
+
+    InstrumentedQuery query("MeasurementRepository::aggregateBySensor");
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        WITH b AS (
+            SELECT date_bin(CAST(:bucket_seconds AS bigint) * interval '1 second', m.recorded_at,
+                            TIMESTAMP '2000-01-01') AS bucket_start,
+                   m.id, m.recorded_at, m.value
+            FROM measurement m
+            WHERE m.sensor_id = :sensor_id
+              AND m.recorded_at >= CAST(:start_date AS timestamp)
+              AND m.recorded_at < CAST(:end_date AS timestamp)
+        )
+        SELECT %1
+        FROM (
+            SELECT b.bucket_start%2
+            FROM b
+            GROUP BY b.bucket_start
+        ) g%3
+        ORDER BY g.bucket_start
+    )").arg(outerColumns, columns.isEmpty() ? QString() : ", " + columns.join(", "), joins));
+    query.bindValue(":bucket_seconds", bucketSeconds);
+    query.bindValue(":sensor_id", sensorId);
+    query.bindValue(":start_date", startDate.toString(Qt::ISODate));
+    query.bindValue(":end_date", endDate.toString(Qt::ISODate));
+
+    if (!query.exec()) {
+        qDebug() << "Database error while aggregating Measurements by Sensor:" << query.lastError().text();
+        return buckets;
+    }
+
+    auto optionalDouble = [&query, reportsReadings](const char *column) -> std::optional<double> {
+        QVariant value = query.value(column);
+        return value.isNull() || !reportsReadings ? std::nullopt : std::optional<double>(value.toDouble());
+    };
+
+    while (query.next()) {
+        MeasurementBucket bucket(query.value("bucket_start").toDateTime(), aggregates);
+        if (aggregates & Aggregate::Min) {
+            bucket.setMin(optionalDouble("min_value"));
+        }
+        if (aggregates & Aggregate::Max) {
+            bucket.setMax(optionalDouble("max_value"));
+        }
+        if (aggregates & Aggregate::Avg) {
+            bucket.setAvg(optionalDouble("avg_value"));
+        }
+        if (aggregates & Aggregate::Count) {
+            bucket.setCount(query.value("count_value").toLongLong());
+        }
+        if (aggregates & Aggregate::First) {
+            bucket.setFirst(optionalDouble("first_value"));
+        }
+        if (aggregates & Aggregate::Last) {
+            bucket.setLast(optionalDouble("last_value"));
+        }
+        buckets.append(bucket);
+    }
+
+    return buckets;
+}
+
+std::optional<Measurement> MeasurementRepository::createMeasurement(double value, qint64 sensorId) {
+    DbQueryTimer queryTimer("MeasurementRepository::createMeasurement");
+    InstrumentedQuery query("MeasurementRepository::createMeasurement");
+    query.prepare(QString(R"(
+        WITH m AS (
+            INSERT INTO measurement (value, sensor_id)
+            VALUES (:value, :sensor_id)
+            RETURNING id, value, recorded_at, sensor_id
+        )
+        SELECT %1
+        FROM m
+        JOIN %2 ON s.id = m.sensor_id
+    )").arg(RowMapper::measurementColumns(), RowMapper::sensorJoins()));
+
+    query.bindValue(":value", value);
     query.bindValue(":sensor_id", sensorId);
 
     if (!query.exec() || !query.next()) {
         qDebug() << "Database error while creating measurement:" << query.lastError().text();
         return std::nullopt;
     }
-    SensorRepository sensorRepository;
-    qint64 id = query.value("id").toLongLong();
-    QByteArray storedData = query.value("data").toByteArray();
-    QDateTime recordedAt = query.value("recorded_at").toDateTime();
-    auto retrievedSensor = sensorRepository.getSensorById(query.value("sensor_id").toLongLong());
-    if(!retrievedSensor) {
-        return std::nullopt;
+    return RowMapper(query.record()).measurement(query.sqlQuery());
+}
+
+int MeasurementRepository::insertMeasurements(const QList<PendingMeasurement>& measurements,
+                                              QList<InsertedMeasurement>* inserted) {
+    DbQueryTimer queryTimer("MeasurementRepository::insertMeasurements");
+    if (measurements.isEmpty()) {
+        if (inserted) {
+            inserted->clear();
+        }
+        return 0;
+    }
+
+    // Borrowed for the whole transaction so the pool cannot retire it between statements.
+    ConnectionPool::Lease lease;
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        qDebug() << "Database error while starting measurement batch:" << db.lastError().text();
+        return -1;
+    }
+
+    QList<InsertedMeasurement> rows;
+    if (inserted) {
+        rows.reserve(measurements.size());
+    }
+
+    // The batch goes in as three array parameters, so the SQL text is the same for every batch
+    // size: StatementCache keeps a single prepared statement and the bind parameter limit
+    // never comes into play.
+    QString values;
+    QString sensorIds;
+    QString recordedAts;
+    values.reserve(measurements.size() * 12);
+    sensorIds.reserve(measurements.size() * 6);
+    recordedAts.reserve(measurements.size() * 26);
+    for (const PendingMeasurement& measurement : measurements) {
+        QChar separator = values.isEmpty() ? QChar('{') : QChar(',');
+        values.append(separator).append(QString::number(measurement.value, 'g', 17));
+        sensorIds.append(separator).append(QString::number(measurement.sensorId));
+        recordedAts.append(separator).append('"').append(measurement.recordedAt.toString(Qt::ISODateWithMs)).append('"');
     }
-    return Measurement(id, storedData, recordedAt, retrievedSensor.value());
+    values.append('}');
+    sensorIds.append('}');
+    recordedAts.append('}');
+
+    // The join drops readings for sensors that do not exist instead of failing the whole batch on the FK.
+    InstrumentedQuery query("MeasurementRepository::insertMeasurements", db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        INSERT INTO measurement (value, sensor_id, recorded_at)
+        SELECT v.value, v.sensor_id, v.recorded_at
+        FROM unnest(CAST(? AS double precision[]), CAST(? AS integer[]), CAST(? AS timestamp[]))
+             AS v(value, sensor_id, recorded_at)
+        JOIN sensor s ON s.id = v.sensor_id
+        RETURNING id, sensor_id, CAST(extract(epoch FROM recorded_at) * 1000000 AS bigint), value
+    )");
+    query.addBindValue(values);
+    query.addBindValue(sensorIds);
+    query.addBindValue(recordedAts);
+
+    if (!query.exec()) {
+        qDebug() << "Database error while inserting measurement batch:" << query.lastError().text();
+        db.rollback();
+        return -1;
+    }
+    int insertedCount = 0;
+    while (query.next()) {
+        ++insertedCount;
+        if (inserted) {
+            rows.append(InsertedMeasurement{query.value(1).toLongLong(),
+                                            MeasurementPoint{query.value(0).toLongLong(), query.value(2).toLongLong(),
+                                                             query.value(3).toDouble()}});
+        }
+    }
+
+    if (!db.commit()) {
+        qDebug() << "Database error while committing measurement batch:" << db.lastError().text();
+        db.rollback();
+        return -1;
+    }
+    if (inserted) {
+        *inserted = std::move(rows);
+    }
+    return insertedCount;
 }
 
 std::optional<Measurement> MeasurementRepository::getLatestMeasurementBySensorId(qint64 sensorId) {
-    QSqlQuery query(DBController::getDatabase());
-    QString queryString = R"(
-        SELECT id, data, recorded_at, sensor_id
-        FROM measurement
-        WHERE sensor_id = :sensor_id
-        ORDER BY recorded_at DESC
+    DbQueryTimer queryTimer("MeasurementRepository::getLatestMeasurementBySensorId");
+    InstrumentedQuery query("MeasurementRepository::getLatestMeasurementBySensorId");
+    query.prepare(QString(R"(
+        SELECT %1
+        FROM measurement m
+        JOIN %2 ON s.id = m.sensor_id
+        WHERE m.sensor_id = :sensor_id
+        ORDER BY m.recorded_at DESC, m.id DESC
         LIMIT 1
-    )";
-    query.prepare(queryString);
+    )").arg(RowMapper::measurementColumns(), RowMapper::sensorJoins()));
     query.bindValue(":sensor_id", sensorId);
 
     if (query.exec() && query.next()) {
-        SensorRepository sensorRepository;
-        qint64 measurementId = query.value("id").toLongLong();
-        QByteArray data = query.value("data").toByteArray();
-        QDateTime recordedAt = query.value("recorded_at").toDateTime();
-        auto sensor = sensorRepository.getSensorById(query.value("sensor_id").toLongLong());
-        if (!sensor) {
-            return std::nullopt;
-        }
-        return Measurement(measurementId, data, recordedAt, sensor.value());
+        return RowMapper(query.record()).measurement(query.sqlQuery());
     }
 
     qDebug() << "Database error while fetching the latest measurement by Sensor ID:" << query.lastError().text();
     return std::nullopt;
 }
+
+std::optional<MeasurementPoint> MeasurementRepository::getLatestPointBySensorId(qint64 sensorId) {
+    DbQueryTimer queryTimer("MeasurementRepository::getLatestPointBySensorId");
+    InstrumentedQuery query("MeasurementRepository::getLatestPointBySensorId");
+    query.prepare(R"(
+        SELECT m.id, CAST(extract(epoch FROM m.recorded_at) * 1000000 AS bigint), m.value
+        FROM measurement m
+        WHERE m.sensor_id = :sensor_id
+        ORDER BY m.recorded_at DESC, m.id DESC
+        LIMIT 1
+    )");
+    query.bindValue(":sensor_id", sensorId);
+
+    if (!query.exec()) {
+        qDebug() << "Database error while fetching the latest measurement point by Sensor ID:" << query.lastError().text();
+        return std::nullopt;
+    }
+    if (!query.next()) {
+        return std::nullopt;
+    }
+
+    std::optional<double> value;
+    if (!query.value(2).isNull()) {
+        value = query.value(2).toDouble();
+    }
+    return MeasurementPoint{query.value(0).toLongLong(), query.value(1).toLongLong(), value};
+}
+
+QList<InsertedMeasurement> MeasurementRepository::getLatestMeasurements() {
+    DbQueryTimer queryTimer("MeasurementRepository::getLatestMeasurements");
+    QList<InsertedMeasurement> latest;
+
+    // One index probe per sensor instead of DISTINCT ON over the whole partitioned table.
+    InstrumentedQuery query("MeasurementRepository::getLatestMeasurements");
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT s.id, l.id, l.recorded_at_us, l.value
+        FROM sensor s
+        CROSS JOIN LATERAL (
+            SELECT m.id, CAST(extract(epoch FROM m.recorded_at) * 1000000 AS bigint) AS recorded_at_us, m.value
+            FROM measurement m
+            WHERE m.sensor_id = s.id
+            ORDER BY m.recorded_at DESC, m.id DESC
+            LIMIT 1
+        ) l
+    )");
+
+    if (!query.exec()) {
+        qDebug() << "Database error while fetching the latest measurements:" << query.lastError().text();
+        return latest;
+    }
+    while (query.next()) {
+        std::optional<double> value;
+        if (!query.value(3).isNull()) {
+            value = query.value(3).toDouble();
+        }
+        latest.append(InsertedMeasurement{query.value(0).toLongLong(),
+                                          MeasurementPoint{query.value(1).toLongLong(), query.value(2).toLongLong(), value}});
+    }
+    return latest;
+}
@@ -1,16 +1,74 @@
 #ifndef MEASUREMENTREPOSITORY_H
 #define MEASUREMENTREPOSITORY_H
 #include "../models/measurement.h"
+#include "../models/measurementbucket.h"
+#include "../models/measurementpoint.h"
+#include "rowcursor.h"
+
+// A reading waiting to be written by MeasurementBatcher.
+struct PendingMeasurement {
+    qint64 sensorId;
+    double value;
+    QDateTime recordedAt;
+};
+
+// Position of a row in (recorded_at, id) order; the opaque next_cursor of a measurement page.
+struct MeasurementKey {
+    qint64 recordedAtUs;
+    qint64 id;
+
+    QByteArray encode() const;
+    static std::optional<MeasurementKey> decode(const QByteArray& cursor);
+};
+
+// A row written by insertMeasurements(), as read back from the database.
+struct InsertedMeasurement {
+    qint64 sensorId;
+    MeasurementPoint point;
+};
+
+struct MeasurementRow {
+    Measurement measurement;
+    MeasurementKey key;
+};
 
 class MeasurementRepository
 {
 public:
     MeasurementRepository();
     std::optional<Measurement> fetchById(qint64 id);
-    QList<Measurement> getMeasurementsBySensorAndDate(qint64 sensorId, const QDateTime &startDate, const QDateTime &endDate);
-    std::optional<Measurement> createMeasurement(const QByteArray& data, qint64 sensorId);
+    // Newest first, rows strictly older than `after` in (recorded_at, id) order. The cursor
+    // yields up to limit + 1 rows; the extra one only tells that another page follows.
+    RowCursor<MeasurementRow> openPage(qint64 sensorId, const QDateTime &startDate, const QDateTime &endDate,
+                                       const std::optional<MeasurementKey> &after, int limit);
+    // Opens a forward-only cursor over the sensor's numeric readings in [startDate, endDate],
+    // oldest first. A null startDate leaves the range open at the beginning.
+    RowCursor<MeasurementPoint> openSeries(qint64 sensorId, const QDateTime &startDate, const QDateTime &endDate);
+    // Aggregates a sensor's readings in [startDate, endDate) into buckets of bucketSeconds,
+    // oldest first. Empty buckets are not returned.
+    QList<MeasurementBucket> aggregateBySensor(qint64 sensorId, const QDateTime &startDate, const QDateTime &endDate,
+                                               qint64 bucketSeconds, MeasurementBucket::Aggregates aggregates);
+    std::optional<Measurement> createMeasurement(double value, qint64 sensorId);
+    // Inserts the batch in one transaction; rows for unknown sensors are skipped.
+    // Returns the number of rows written, or -1 if the batch was rolled back. When `inserted`
+    // is given it receives the committed rows.
+    int insertMeasurements(const QList<PendingMeasurement>& measurements,
+                           QList<InsertedMeasurement>* inserted = nullptr);
     void saveMeasurementToDatabase(const QByteArray& message);
     std::optional<Measurement> getLatestMeasurementBySensorId(qint64 sensorId); // New method
+    // The row getLatestMeasurementBySensorId() would return, without its sensor.
+    std::optional<MeasurementPoint> getLatestPointBySensorId(qint64 sensorId);
+    // Newest reading of every sensor that has one, for filling LatestMeasurementTable.
+    QList<InsertedMeasurement> getLatestMeasurements();
+
+private:
+    // openPage() and openSeries() take the part of the range HotWindowStore covers from
+    // memory and read only the rest here.
+    RowCursor<MeasurementRow> openDatabasePage(qint64 sensorId, const QDateTime &startDate, const QDateTime &endDate,
+                                               const std::optional<MeasurementKey> &after, int rows);
+    // With beforeUs, only readings recorded strictly before it.
+    RowCursor<MeasurementPoint> openDatabaseSeries(qint64 sensorId, const QDateTime &startDate, const QDateTime &endDate,
+                                                   std::optional<qint64> beforeUs);
 };
 
 #endif // MEASUREMENTREPOSITORY_H
@@ -0,0 +1,207 @@
+#include "metadatacache.h"
+
+MetadataCache::MetadataCache()
+{
+    setMaxEntries(10000);
+}
+
+MetadataCache &MetadataCache::instance()
+{
+    static MetadataCache cacheInstance;
+    return cacheInstance;
+}
+
+void MetadataCache::setMaxEntries(int maxEntries)
+{
+    QMutexLocker locker(&mutex_);
+    maxEntries = qMax(1, maxEntries);
+    sensors_.setMaxCost(maxEntries);
+    solarPanels_.setMaxCost(maxEntries);
+    users_.setMaxCost(maxEntries);
+    sensorTypes_.setMaxCost(maxEntries);
+}
+
+template <typename T>
+std::optional<T> MetadataCache::lookup(QCache<qint64, T> &cache, qint64 id)
+{
+    QMutexLocker locker(&mutex_);
+    if (const T *entry = cache.object(id)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return *entry;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+}
+
+std::optional<Sensor> MetadataCache::sensor(qint64 id)
+{
+    return lookup(sensors_, id);
+}
+
+std::optional<SolarPanel> MetadataCache::solarPanel(qint64 id)
+{
+    return lookup(solarPanels_, id);
+}
+
+std::optional<User> MetadataCache::user(qint64 id)
+{
+    return lookup(users_, id);
+}
+
+std::optional<SensorType> MetadataCache::sensorType(qint64 id)
+{
+    return lookup(sensorTypes_, id);
+}
+
+quint64 MetadataCache::generation() const
+{
+    QMutexLocker locker(&mutex_);
+    return generation_;
+}
+
+void MetadataCache::insertSensor(const Sensor &sensor, quint64 generation)
+{
+    QMutexLocker locker(&mutex_);
+    const SolarPanel &solarPanel = sensor.solarPanel();
+    if (!acceptLocked(isCurrentLocked(sensorStripes_, sensor.id(), generation)
+                      && isCurrentLocked(panelStripes_, solarPanel.id(), generation)
+                      && isCurrentLocked(userStripes_, solarPanel.user().id(), generation)
+                      && isCurrentLocked(sensorTypeStripes_, sensor.type().id(), generation))) {
+        return;
+    }
+    sensors_.insert(sensor.id(), new Sensor(sensor));
+    if (!sensorsByPanel_.contains(solarPanel.id(), sensor.id())) {
+        sensorsByPanel_.insert(solarPanel.id(), sensor.id());
+    }
+    pruneEdgesLocked();
+}
+
+void MetadataCache::insertSolarPanel(const SolarPanel &solarPanel, quint64 generation)
+{
+    QMutexLocker locker(&mutex_);
+    if (!acceptLocked(isCurrentLocked(panelStripes_, solarPanel.id(), generation)
+                      && isCurrentLocked(userStripes_, solarPanel.user().id(), generation))) {
+        return;
+    }
+    solarPanels_.insert(solarPanel.id(), new SolarPanel(solarPanel));
+    if (!panelsByUser_.contains(solarPanel.user().id(), solarPanel.id())) {
+        panelsByUser_.insert(solarPanel.user().id(), solarPanel.id());
+    }
+    pruneEdgesLocked();
+}
+
+void MetadataCache::insertUser(const User &user, quint64 generation)
+{
+    QMutexLocker locker(&mutex_);
+    if (!acceptLocked(isCurrentLocked(userStripes_, user.id(), generation))) {
+        return;
+    }
+    users_.insert(user.id(), new User(user));
+}
+
+void MetadataCache::insertSensorType(const SensorType &sensorType, quint64 generation)
+{
+    QMutexLocker locker(&mutex_);
+    if (!acceptLocked(isCurrentLocked(sensorTypeStripes_, sensorType.id(), generation))) {
+        return;
+    }
+    sensorTypes_.insert(sensorType.id(), new SensorType(sensorType));
+}
+
+void MetadataCache::invalidateSensor(qint64 id)
+{
+    QMutexLocker locker(&mutex_);
+    sensors_.remove(id);
+    bumpLocked(sensorStripes_, id);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetadataCache::invalidateSolarPanel(qint64 id)
+{
+    QMutexLocker locker(&mutex_);
+    invalidateSolarPanelLocked(id);
+}
+
+void MetadataCache::invalidateUser(qint64 id)
+{
+    QMutexLocker locker(&mutex_);
+    users_.remove(id);
+    bumpLocked(userStripes_, id);
+    for (qint64 panelId : panelsByUser_.values(id)) {
+        invalidateSolarPanelLocked(panelId);
+    }
+    panelsByUser_.remove(id);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetadataCache::clear()
+{
+    QMutexLocker locker(&mutex_);
+    sensors_.clear();
+    solarPanels_.clear();
+    users_.clear();
+    sensorTypes_.clear();
+    sensorsByPanel_.clear();
+    panelsByUser_.clear();
+    clearedAt_ = ++generation_;
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+MetadataCache::Stats MetadataCache::stats() const
+{
+    QMutexLocker locker(&mutex_);
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+    stats.staleInserts = staleInserts_.load(std::memory_order_relaxed);
+    stats.sensors = sensors_.size();
+    stats.solarPanels = solarPanels_.size();
+    stats.users = users_.size();
+    stats.sensorTypes = sensorTypes_.size();
+    stats.maxEntries = sensors_.maxCost();
+    return stats;
+}
+
+void MetadataCache::invalidateSolarPanelLocked(qint64 id)
+{
+    solarPanels_.remove(id);
+    bumpLocked(panelStripes_, id);
+    for (qint64 sensorId : sensorsByPanel_.values(id)) {
+        sensors_.remove(sensorId);
+    }
+    sensorsByPanel_.remove(id);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetadataCache::bumpLocked(Stripes &stripes, qint64 id)
+{
+    stripes[quint64(id) % stripeCount] = ++generation_;
+}
+
+bool MetadataCache::isCurrentLocked(const Stripes &stripes, qint64 id, quint64 generation) const
+{
+    return clearedAt_ <= generation && stripes[quint64(id) % stripeCount] <= generation;
+}
+
+bool MetadataCache::acceptLocked(bool current)
+{
+    if (!current) {
+        staleInserts_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return current;
+}
+
+void MetadataCache::pruneEdgesLocked()
+{
+    // QCache evicts without telling us, so sweep once the edges outnumber what can be cached;
+    // each sweep brings them back under that, which keeps the cost amortized per insert.
+    // contains() rather than object(), which would reorder the LRU.
+    qsizetype limit = 2 * qsizetype(sensors_.maxCost());
+    if (sensorsByPanel_.size() > limit) {
+        sensorsByPanel_.removeIf([this](const auto &edge) { return !sensors_.contains(edge.value()); });
+    }
+    if (panelsByUser_.size() > limit) {
+        panelsByUser_.removeIf([this](const auto &edge) { return !solarPanels_.contains(edge.value()); });
+    }
+}
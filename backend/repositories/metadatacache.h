@@ -0,0 +1,101 @@
+#ifndef METADATACACHE_H
+#define METADATACACHE_H
+
+#include <QCache>
+#include <QMultiHash>
+#include <QMutex>
+#include <array>
+#include <atomic>
+#include <optional>
+#include "../models/sensor.h"
+
+// Process-wide cache of the Sensor -> SolarPanel -> User and SensorType graph.
+// Repositories consult it before querying and invalidate it on every write path.
+//
+// A reader takes generation() before its query and passes it to insert*(). The insert is
+// skipped when the key, or a panel, user or type embedded in the value, was invalidated after
+// that, so a row read before a concurrent write cannot be cached after the write's invalidation.
+class MetadataCache
+{
+public:
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 invalidations = 0;
+        quint64 staleInserts = 0;        // Skipped because the entry was invalidated mid-read
+        int sensors = 0;
+        int solarPanels = 0;
+        int users = 0;
+        int sensorTypes = 0;
+        int maxEntries = 0;
+    };
+
+    static MetadataCache& instance();
+
+    // Upper bound for each of the four entity caches; least recently used entries go first.
+    void setMaxEntries(int maxEntries);
+
+    std::optional<Sensor> sensor(qint64 id);
+    std::optional<SolarPanel> solarPanel(qint64 id);
+    std::optional<User> user(qint64 id);
+    std::optional<SensorType> sensorType(qint64 id);
+
+    quint64 generation() const;
+
+    void insertSensor(const Sensor& sensor, quint64 generation);
+    void insertSolarPanel(const SolarPanel& solarPanel, quint64 generation);
+    void insertUser(const User& user, quint64 generation);
+    void insertSensorType(const SensorType& sensorType, quint64 generation);
+
+    void invalidateSensor(qint64 id);
+    // Also drops the cached sensors that embed this panel.
+    void invalidateSolarPanel(qint64 id);
+    // Also drops the user's panels and the sensors on them.
+    void invalidateUser(qint64 id);
+    void clear();
+
+    Stats stats() const;
+
+private:
+    MetadataCache();
+
+    MetadataCache(const MetadataCache&) = delete;
+    MetadataCache& operator=(const MetadataCache&) = delete;
+
+    // Invalidations are remembered per stripe of keys rather than per key, so the bookkeeping
+    // stays bounded; keys sharing a stripe only cost each other an occasional skipped insert.
+    static constexpr int stripeCount = 256;
+    using Stripes = std::array<quint64, stripeCount>;
+
+    template <typename T>
+    std::optional<T> lookup(QCache<qint64, T>& cache, qint64 id);
+    void invalidateSolarPanelLocked(qint64 id);
+    void bumpLocked(Stripes& stripes, qint64 id);
+    bool isCurrentLocked(const Stripes& stripes, qint64 id, quint64 generation) const;
+    bool acceptLocked(bool current);
+    // Drops reverse edges whose child has left the cache.
+    void pruneEdgesLocked();
+
+    mutable QMutex mutex_;
+    QCache<qint64, Sensor> sensors_;
+    QCache<qint64, SolarPanel> solarPanels_;
+    QCache<qint64, User> users_;
+    QCache<qint64, SensorType> sensorTypes_;
+    // Reverse edges used to cascade invalidation up the graph.
+    QMultiHash<qint64, qint64> sensorsByPanel_;
+    QMultiHash<qint64, qint64> panelsByUser_;
+
+    quint64 generation_ = 0;
+    quint64 clearedAt_ = 0;
+    Stripes sensorStripes_ {};
+    Stripes panelStripes_ {};
+    Stripes userStripes_ {};
+    Stripes sensorTypeStripes_ {};
+
+    std::atomic<quint64> hits_ {0};
+    std::atomic<quint64> misses_ {0};
+    std::atomic<quint64> invalidations_ {0};
+    std::atomic<quint64> staleInserts_ {0};
+};
+
+#endif // METADATACACHE_H
@@ -0,0 +1,54 @@
+#ifndef ROWCURSOR_H
+#define ROWCURSOR_H
+
+#include <functional>
+#include <optional>
+#include "instrumentedquery.h"
+
+// Walks a forward-only result one mapped row at a time, so a result of any size can be
+// consumed without materializing it. With QPSQL a forward-only query runs in single-row mode;
+// starting another query on the same connection before the cursor is exhausted makes the
+// driver buffer the remaining rows. Must stay on the thread that created it, like the
+// connection behind it. A cursor can also pull from any other source, such as rows held in
+// memory or several cursors chained together.
+template <typename T>
+class RowCursor
+{
+public:
+    using Mapper = std::function<T(const QSqlQuery&)>;
+    using Source = std::function<std::optional<T>()>;
+
+    RowCursor() = default;
+    RowCursor(InstrumentedQuery&& query, Mapper mapper)
+        : query_(std::move(query)), mapper_(std::move(mapper)), valid_(query_.isActive())
+    {
+    }
+    explicit RowCursor(Source source)
+        : source_(std::move(source)), valid_(true)
+    {
+    }
+
+    bool isValid() const { return valid_; }
+
+    std::optional<T> next()
+    {
+        if (!valid_) {
+            return std::nullopt;
+        }
+        if (source_) {
+            return source_();
+        }
+        if (!query_.next()) {
+            return std::nullopt;
+        }
+        return mapper_(query_.sqlQuery());
+    }
+
+private:
+    InstrumentedQuery query_;
+    Mapper mapper_;
+    Source source_;
+    bool valid_ = false;
+};
+
+#endif // ROWCURSOR_H
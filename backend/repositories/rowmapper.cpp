@@ -0,0 +1,92 @@
+#include "rowmapper.h"
+
+RowMapper::RowMapper(const QSqlRecord &record)
+    : userId_(record.indexOf("u_id")), userEmail_(record.indexOf("u_email")),
+    userPassword_(record.indexOf("u_password")),
+    panelId_(record.indexOf("sp_id")), panelLocation_(record.indexOf("sp_location")),
+    panelCreatedAt_(record.indexOf("sp_created_at")), panelUpdatedAt_(record.indexOf("sp_updated_at")),
+    typeId_(record.indexOf("st_id")), typeName_(record.indexOf("st_name")),
+    sensorId_(record.indexOf("s_id")),
+    measurementId_(record.indexOf("m_id")), measurementValue_(record.indexOf("m_value")),
+    measurementRecordedAt_(record.indexOf("m_recorded_at"))
+{
+}
+
+QString RowMapper::userColumns()
+{
+    return R"(u.id AS u_id, u.email AS u_email, u.password AS u_password)";
+}
+
+QString RowMapper::solarPanelColumns()
+{
+    return R"(sp.id AS sp_id, sp.location AS sp_location, sp.created_at AS sp_created_at,
+              sp.updated_at AS sp_updated_at, )" + userColumns();
+}
+
+QString RowMapper::sensorTypeColumns()
+{
+    return R"(st.id AS st_id, st.name AS st_name)";
+}
+
+QString RowMapper::sensorColumns()
+{
+    return "s.id AS s_id, " + sensorTypeColumns() + ", " + solarPanelColumns();
+}
+
+QString RowMapper::measurementColumns()
+{
+    return "m.id AS m_id, m.value AS m_value, m.recorded_at AS m_recorded_at, " + sensorColumns();
+}
+
+QString RowMapper::sensorJoins()
+{
+    return R"(sensor s
+              JOIN sensor_type st ON st.id = s.sensor_type_id
+              JOIN solar_panel sp ON sp.id = s.solar_panel_id
+              JOIN "user" u ON u.id = sp.user_id)";
+}
+
+QString RowMapper::solarPanelJoins()
+{
+    return R"(solar_panel sp
+              JOIN "user" u ON u.id = sp.user_id)";
+}
+
+User RowMapper::user(const QSqlQuery &query) const
+{
+    return User(query.value(userId_).toLongLong(),
+                query.value(userEmail_).toString(),
+                query.value(userPassword_).toString());
+}
+
+SolarPanel RowMapper::solarPanel(const QSqlQuery &query) const
+{
+    return SolarPanel(query.value(panelId_).toLongLong(),
+                      query.value(panelLocation_).toString(),
+                      user(query),
+                      query.value(panelCreatedAt_).toDateTime(),
+                      query.value(panelUpdatedAt_).toDateTime());
+}
+
+SensorType RowMapper::sensorType(const QSqlQuery &query) const
+{
+    return SensorType(query.value(typeId_).toLongLong(), query.value(typeName_).toString());
+}
+
+Sensor RowMapper::sensor(const QSqlQuery &query) const
+{
+    qint64 id = query.value(sensorId_).toLongLong();
+    if (lastSensor_.id() != id) {
+        lastSensor_ = Sensor(id, solarPanel(query), sensorType(query));
+    }
+    return lastSensor_;
+}
+
+Measurement RowMapper::measurement(const QSqlQuery &query) const
+{
+    QVariant value = query.value(measurementValue_);
+    return Measurement(query.value(measurementId_).toLongLong(),
+                       value.isNull() ? std::nullopt : std::optional<double>(value.toDouble()),
+                       query.value(measurementRecordedAt_).toDateTime(),
+                       sensor(query));
+}
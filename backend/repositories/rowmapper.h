@@ -0,0 +1,44 @@
+#ifndef ROWMAPPER_H
+#define ROWMAPPER_H
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include "../models/measurement.h"
+
+// Maps rows of the joined measurement -> sensor -> (sensor_type, solar_panel -> user) query
+// into models. Column positions are resolved once per result set, not once per row.
+class RowMapper
+{
+public:
+    explicit RowMapper(const QSqlRecord& record);
+
+    // SELECT-list fragments using the aliases the mapper expects.
+    static QString userColumns();        // u.*
+    static QString solarPanelColumns();  // sp.* plus userColumns()
+    static QString sensorTypeColumns();  // st.*
+    static QString sensorColumns();      // s.* plus sensorTypeColumns() and solarPanelColumns()
+    static QString measurementColumns(); // m.* plus sensorColumns()
+
+    // FROM-clause joins starting at "sensor s" and "solar_panel sp" respectively.
+    static QString sensorJoins();
+    static QString solarPanelJoins();
+
+    User user(const QSqlQuery& query) const;
+    SolarPanel solarPanel(const QSqlQuery& query) const;
+    SensorType sensorType(const QSqlQuery& query) const;
+    // Consecutive rows of the same sensor reuse the previously built Sensor.
+    Sensor sensor(const QSqlQuery& query) const;
+    Measurement measurement(const QSqlQuery& query) const;
+
+private:
+    int userId_, userEmail_, userPassword_;
+    int panelId_, panelLocation_, panelCreatedAt_, panelUpdatedAt_;
+    int typeId_, typeName_;
+    int sensorId_;
+    int measurementId_, measurementValue_, measurementRecordedAt_;
+
+    mutable Sensor lastSensor_;
+};
+
+#endif // ROWMAPPER_H
@@ -1,63 +1,85 @@
 #include "sensorrepository.h"
-#include "solarpanelrepository.h"
 #include "../controllers/dbcontroller.h"
+#include "../utils/metrics.h"
+#include "instrumentedquery.h"
+#include "metadatacache.h"
+#include "latestmeasurementtable.h"
+#include "hotwindowstore.h"
+#include "rowmapper.h"
 #include <qsqlerror.h>
 
 std::optional<Sensor> SensorRepository::getSensorById(qint64 id) {
-    QSqlQuery query(DBController::getDatabase());
-    query.prepare("SELECT id, solar_panel_id, sensor_type_id AS type FROM sensor WHERE id = :id");
+    DbQueryTimer queryTimer("SensorRepository::getSensorById");
+    if (auto cached = MetadataCache::instance().sensor(id)) {
+        return cached;
+    }
+    quint64 cacheGeneration = MetadataCache::instance().generation();
+
+    InstrumentedQuery query("SensorRepository::getSensorById");
+    query.prepare(QString("SELECT %1 FROM %2 WHERE s.id = :id")
+                      .arg(RowMapper::sensorColumns(), RowMapper::sensorJoins()));
     query.bindValue(":id", id);
 
     if (query.exec() && query.next()) {
-        SensorTypeRepository sensorTypeRepository;
-        SolarPanelRepository solarPanelRepository;
-
-        auto solarPanelId = solarPanelRepository.fetchById(query.value("solar_panel_id").toInt());
-        auto sensorTypeId = sensorTypeRepository.fetchById(query.value("type").toInt());
-        if (!solarPanelId || !sensorTypeId) {
-            return std::nullopt;
-        }
-
-        return Sensor(query.value("id").toLongLong(),
-                      solarPanelId.value(),sensorTypeId.value());
-
+        Sensor sensor = RowMapper(query.record()).sensor(query.sqlQuery());
+        MetadataCache::instance().insertSensor(sensor, cacheGeneration);
+        return sensor;
     }
     return std::nullopt;
 }
 
-QList<Sensor> SensorRepository::getSensorsByPanelId(qint64 id) {
-    QList<Sensor> sensors;
-    QSqlQuery query(DBController::getDatabase());
-    query.prepare("SELECT id, solar_panel_id, sensor_type_id AS type FROM sensor WHERE solar_panel_id = :solarPanelId;");
+bool SensorRepository::reportsReadings(qint64 id) {
+    std::optional<Sensor> sensor = getSensorById(id);
+    return sensor && sensor->type().reportsReadings();
+}
+
+RowCursor<Sensor> SensorRepository::openSensorsByPanelId(qint64 id) {
+    DbQueryTimer queryTimer("SensorRepository::openSensorsByPanelId");
+    quint64 cacheGeneration = MetadataCache::instance().generation();
+    InstrumentedQuery query("SensorRepository::openSensorsByPanelId");
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT %1 FROM %2 WHERE s.solar_panel_id = :solarPanelId ORDER BY s.id")
+                      .arg(RowMapper::sensorColumns(), RowMapper::sensorJoins()));
     query.bindValue(":solarPanelId", id);
-    if (query.exec()) {
-        SensorTypeRepository sensorTypeRepository;
-        SolarPanelRepository solarPanelRepository;
-        while (query.next()) {
-
-            auto solarPanelId = solarPanelRepository.fetchById(query.value("solar_panel_id").toInt());
-            auto sensorTypeId = sensorTypeRepository.fetchById(query.value("type").toInt());
-            if (!solarPanelId || !sensorTypeId) {
-                return {};
-            }
-            sensors.append(Sensor(query.value("id").toLongLong(),
-                                  solarPanelId.value(),
-                                  sensorTypeId.value()));
-        }
+    if (!query.exec()) {
+        qDebug() << "Database error while fetching Sensors by SolarPanel ID:" << query.lastError().text();
+        return {};
     }
-    return sensors;
+
+    auto mapper = std::make_shared<RowMapper>(query.record());
+    return RowCursor<Sensor>(std::move(query), [mapper, cacheGeneration](const QSqlQuery& row) {
+        Sensor sensor = mapper->sensor(row);
+        MetadataCache::instance().insertSensor(sensor, cacheGeneration);
+        return sensor;
+    });
 }
 
 
 bool SensorRepository::deleteSensor(qint64 id) {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("SensorRepository::deleteSensor");
+    InstrumentedQuery query("SensorRepository::deleteSensor");
     query.prepare("DELETE FROM sensor WHERE id = :id");
     query.bindValue(":id", id);
-    return query.exec() && query.numRowsAffected() > 0;
+    if (!query.exec()) {
+        qDebug() << "Database error while deleting Sensor by ID (" << id << "):" << query.lastError().text();
+        return false;
+    }
+    if (query.numRowsAffected() == 0) {
+        return false;
+    }
+    forgetDeletedSensor(id);
+    return true;
+}
+
+void SensorRepository::forgetDeletedSensor(qint64 id) {
+    MetadataCache::instance().invalidateSensor(id);
+    LatestMeasurementTable::instance().remove(id);
+    HotWindowStore::instance().remove(id);
 }
 
 std::optional<Sensor> SensorRepository::createSensor(const Sensor& sensor) {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("SensorRepository::createSensor");
+    InstrumentedQuery query("SensorRepository::createSensor");
     query.prepare(R"(INSERT INTO sensor (solar_panel_id, sensor_type_id)
                     VALUES (:solar_panel_id, :type_id);)");
     query.bindValue(":solar_panel_id", sensor.solarPanel().id());
@@ -72,3 +94,23 @@ std::optional<Sensor> SensorRepository::createSensor(const Sensor& sensor) {
     qDebug() << "Database error while creating Sensor:" << query.lastError().text();
     return std::nullopt;
 }
+
+std::optional<QByteArray> SensorRepository::getSensorsVersionByPanelId(qint64 id) {
+    DbQueryTimer queryTimer("SensorRepository::getSensorsVersionByPanelId");
+    InstrumentedQuery query("SensorRepository::getSensorsVersionByPanelId");
+    query.prepare(R"(
+        SELECT COUNT(*), COALESCE(MAX(id), 0),
+               COALESCE(CAST(EXTRACT(EPOCH FROM MAX(COALESCE(updated_at, created_at))) * 1000000 AS bigint), 0)
+        FROM sensor
+        WHERE solar_panel_id = :panel_id
+    )");
+    query.bindValue(":panel_id", id);
+
+    if (query.exec() && query.next()) {
+        return QByteArray::number(query.value(0).toLongLong()) + '-' + QByteArray::number(query.value(1).toLongLong())
+               + '-' + QByteArray::number(query.value(2).toLongLong());
+    }
+
+    qDebug() << "Database error (getSensorsVersionByPanelId):" << query.lastError().text();
+    return std::nullopt;
+}
@@ -2,14 +2,24 @@
 #define SENSORREPOSITORY_H
 #include "../models/sensor.h"
 #include "sensortyperepository.h"
+#include "rowcursor.h"
 #include <qsqldatabase.h>
 #include <qsqlquery.h>
 
 class SensorRepository {
 public:
     std::optional<Sensor> getSensorById(qint64 id);
-    QList<Sensor> getSensorsByPanelId(qint64 id);
+    // Whether the API shows this sensor's readings (SensorType::reportsReadings()); false for
+    // unknown sensors. Outputs that carry values without the sensor graph (series, buckets,
+    // the latest reading, live frames) check it by id; served from MetadataCache.
+    bool reportsReadings(qint64 id);
+    RowCursor<Sensor> openSensorsByPanelId(qint64 id);
+    // Changes whenever a sensor of the panel is added, removed or updated; std::nullopt on error.
+    std::optional<QByteArray> getSensorsVersionByPanelId(qint64 id);
     bool deleteSensor(qint64 id);
+    // Drops what the in-memory tables hold for a sensor the database no longer has, whether it
+    // was deleted directly or by the cascade from its panel or user.
+    static void forgetDeletedSensor(qint64 id);
     std::optional<Sensor> createSensor(const Sensor& sensor);
 };
 
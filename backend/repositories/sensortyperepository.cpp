@@ -1,22 +1,26 @@
 #include "sensortyperepository.h"
 #include "../controllers/dbcontroller.h"
+#include "../utils/metrics.h"
+#include "instrumentedquery.h"
+#include "metadatacache.h"
+#include "rowmapper.h"
 #include <qsqlerror.h>
 
 std::optional<SensorType> SensorTypeRepository::fetchById(qint64 id) {
-    QSqlQuery query(DBController::getDatabase());
-    QString queryString = R"(
-        SELECT id, name
-        FROM sensor_type
-        WHERE id = :id
-    )";
-    query.prepare(queryString);
+    DbQueryTimer queryTimer("SensorTypeRepository::fetchById");
+    if (auto cached = MetadataCache::instance().sensorType(id)) {
+        return cached;
+    }
+    quint64 cacheGeneration = MetadataCache::instance().generation();
+
+    InstrumentedQuery query("SensorTypeRepository::fetchById");
+    query.prepare(QString("SELECT %1 FROM sensor_type st WHERE st.id = :id").arg(RowMapper::sensorTypeColumns()));
     query.bindValue(":id", id);
 
     if (query.exec() && query.next()) {
-        qint64 sensorTypeId = query.value("id").toLongLong();
-        QString name = query.value("name").toString();
-
-        return SensorType(sensorTypeId, name);
+        SensorType sensorType = RowMapper(query.record()).sensorType(query.sqlQuery());
+        MetadataCache::instance().insertSensorType(sensorType, cacheGeneration);
+        return sensorType;
     }
 
     qDebug() << "Database error while fetching SensorType by ID:" << query.lastError().text();
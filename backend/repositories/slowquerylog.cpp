@@ -0,0 +1,125 @@
+#include "slowquerylog.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimeZone>
+
+SlowQueryLog &SlowQueryLog::instance()
+{
+    static SlowQueryLog logInstance;
+    return logInstance;
+}
+
+void SlowQueryLog::configure(const Settings &settings)
+{
+    QMutexLocker locker(&mutex_);
+    settings_ = settings;
+    settings_.thresholdMs = qMax(0, settings_.thresholdMs);
+    settings_.capacity = qMax(1, settings_.capacity);
+    settings_.explainIntervalSeconds = qMax(0, settings_.explainIntervalSeconds);
+    thresholdNs_.store(qint64(settings_.thresholdMs) * 1000000, std::memory_order_relaxed);
+
+    // Lay the ring out oldest first again, keeping the newest entries when it shrinks.
+    QList<Entry> ordered;
+    qsizetype keep = qMin(ring_.size(), qsizetype(settings_.capacity));
+    ordered.reserve(keep);
+    for (qsizetype i = ring_.size() - keep; i < ring_.size(); ++i) {
+        ordered.append(ring_.at((next_ + i) % ring_.size()));
+    }
+    ring_ = std::move(ordered);
+    next_ = 0;
+}
+
+SlowQueryLog::Settings SlowQueryLog::settings() const
+{
+    QMutexLocker locker(&mutex_);
+    return settings_;
+}
+
+bool SlowQueryLog::claimExplain(const QByteArray &site)
+{
+    QMutexLocker locker(&mutex_);
+    if (!settings_.explain) {
+        return false;
+    }
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    auto last = lastExplainMs_.find(site);
+    if (last != lastExplainMs_.end() && now - *last < qint64(settings_.explainIntervalSeconds) * 1000) {
+        return false;
+    }
+    lastExplainMs_.insert(site, now);
+    return true;
+}
+
+void SlowQueryLog::record(Entry entry)
+{
+    QMutexLocker locker(&mutex_);
+    if (ring_.size() < settings_.capacity) {
+        ring_.append(std::move(entry));
+        return;
+    }
+    ring_[next_] = std::move(entry);
+    next_ = (next_ + 1) % ring_.size();
+}
+
+QList<SlowQueryLog::Entry> SlowQueryLog::entries() const
+{
+    QMutexLocker locker(&mutex_);
+    QList<Entry> newestFirst;
+    newestFirst.reserve(ring_.size());
+    // Until the ring wraps next_ stays 0 and the newest entry is the last one appended.
+    qsizetype newest = ring_.size() < settings_.capacity ? ring_.size() - 1 : next_ - 1 + ring_.size();
+    for (qsizetype i = 0; i < ring_.size(); ++i) {
+        newestFirst.append(ring_.at((newest - i) % ring_.size()));
+    }
+    return newestFirst;
+}
+
+void SlowQueryLog::clear()
+{
+    QMutexLocker locker(&mutex_);
+    ring_.clear();
+    next_ = 0;
+    lastExplainMs_.clear();
+}
+
+QByteArray SlowQueryLog::toJson() const
+{
+    Settings current = settings();
+    QJsonArray queries;
+    for (const Entry &entry : entries()) {
+        QJsonObject parameters;
+        for (const auto &parameter : entry.parameters) {
+            parameters.insert(parameter.first, parameter.second);
+        }
+
+        QJsonObject query;
+        query["recordedAt"] = QDateTime::fromMSecsSinceEpoch(entry.timestampMs, QTimeZone::UTC).toString(Qt::ISODateWithMs);
+        query["site"] = QString::fromLatin1(entry.site);
+        query["sql"] = entry.sql;
+        query["parameters"] = parameters;
+        if (entry.omittedParameters > 0) {
+            query["omittedParameters"] = entry.omittedParameters;
+        }
+        query["prepareMs"] = double(entry.prepareUs) / 1000;
+        query["execMs"] = double(entry.execUs) / 1000;
+        query["fetchMs"] = double(entry.fetchUs) / 1000;
+        query["totalMs"] = double(entry.prepareUs + entry.execUs + entry.fetchUs) / 1000;
+        query["rows"] = entry.rows;
+        if (!entry.error.isEmpty()) {
+            query["error"] = entry.error;
+        }
+        if (!entry.plan.isEmpty()) {
+            query["plan"] = entry.plan;
+        }
+        queries.append(query);
+    }
+
+    QJsonObject root;
+    root["thresholdMs"] = current.thresholdMs;
+    root["explain"] = current.explain;
+    root["capacity"] = current.capacity;
+    root["queries"] = queries;
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,74 @@
+#ifndef SLOWQUERYLOG_H
+#define SLOWQUERYLOG_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <atomic>
+
+// Process-wide ring of the most recent statements that took longer than the threshold, with
+// their bound values and, when explain is on, the plan PostgreSQL ran them with. Filled by
+// InstrumentedQuery and served by GET /api/admin/slow-queries; the oldest entry makes room.
+class SlowQueryLog
+{
+public:
+    struct Settings {
+        int thresholdMs = 250;              // 0 disables the log
+        int capacity = 100;
+        // Re-runs slow SELECTs under EXPLAIN (ANALYZE, BUFFERS) on the same connection, so the
+        // statement executes twice. At most once per call site per explainIntervalSeconds.
+        bool explain = false;
+        int explainIntervalSeconds = 60;
+    };
+
+    struct Entry {
+        qint64 timestampMs = 0;
+        QByteArray site;
+        QString sql;
+        QList<QPair<QString, QString>> parameters;   // Placeholder and rendered value
+        int omittedParameters = 0;
+        qint64 prepareUs = 0;
+        qint64 execUs = 0;
+        qint64 fetchUs = 0;
+        qint64 rows = 0;
+        QString error;
+        QString plan;
+    };
+
+    static SlowQueryLog& instance();
+
+    void configure(const Settings& settings);
+    Settings settings() const;
+
+    // 0 when disabled; read on every statement, so it never locks.
+    qint64 thresholdNs() const { return thresholdNs_.load(std::memory_order_relaxed); }
+
+    // True when `site` may be explained now, and starts its interval.
+    bool claimExplain(const QByteArray& site);
+
+    void record(Entry entry);
+    // Newest first.
+    QList<Entry> entries() const;
+    void clear();
+
+    QByteArray toJson() const;
+
+private:
+    SlowQueryLog() = default;
+
+    SlowQueryLog(const SlowQueryLog&) = delete;
+    SlowQueryLog& operator=(const SlowQueryLog&) = delete;
+
+    std::atomic<qint64> thresholdNs_ {qint64(Settings().thresholdMs) * 1000000};
+
+    mutable QMutex mutex_;
+    Settings settings_;
+    QList<Entry> ring_;
+    qsizetype next_ = 0;   // Slot the next entry overwrites once the ring is full
+    QHash<QByteArray, qint64> lastExplainMs_;
+};
+
+#endif // SLOWQUERYLOG_H
@@ -1,6 +1,11 @@
 #include "solarpanelrepository.h"
 #include "../controllers/dbcontroller.h" // Ensure this path is correct
+#include "../utils/metrics.h"
+#include "instrumentedquery.h"
 #include "userrepository.h"             // Ensure this path is correct
+#include "metadatacache.h"
+#include "sensorrepository.h"
+#include "rowmapper.h"
 #include <QSqlError>
 #include <QDebug>
 #include <QDateTime>
@@ -9,31 +14,21 @@ SolarPanelRepository::SolarPanelRepository() {}
 
 std::optional<SolarPanel> SolarPanelRepository::fetchById(qint64 id)
 {
-    QSqlQuery query(DBController::getDatabase());
-    QString queryString = R"(
-        SELECT id, location, user_id, created_at, updated_at
-        FROM solar_panel
-        WHERE id = :id
-    )";
-    query.prepare(queryString);
+    DbQueryTimer queryTimer("SolarPanelRepository::fetchById");
+    if (auto cached = MetadataCache::instance().solarPanel(id)) {
+        return cached;
+    }
+    quint64 cacheGeneration = MetadataCache::instance().generation();
+
+    InstrumentedQuery query("SolarPanelRepository::fetchById");
+    query.prepare(QString("SELECT %1 FROM %2 WHERE sp.id = :id")
+                      .arg(RowMapper::solarPanelColumns(), RowMapper::solarPanelJoins()));
     query.bindValue(":id", id);
 
     if (query.exec() && query.next()) {
-        UserRepository userRepository;
-        qint64 solarPanelId = query.value("id").toLongLong();
-        QString location = query.value("location").toString();
-
-        auto optionalUser = userRepository.findUserById(query.value("user_id").toInt());
-        if (!optionalUser) { // Use .has_value() or implicit bool conversion
-            qDebug() << "User not found for user_id:" << query.value("user_id").toInt() << "for SolarPanel ID:" << id;
-            return std::nullopt;
-        }
-        User user = optionalUser.value();
-
-        QDateTime createdAt = query.value("created_at").toDateTime();
-        QDateTime updatedAt = query.value("updated_at").toDateTime();
-
-        return SolarPanel(solarPanelId, location, user, createdAt, updatedAt);
+        SolarPanel solarPanel = RowMapper(query.record()).solarPanel(query.sqlQuery());
+        MetadataCache::instance().insertSolarPanel(solarPanel, cacheGeneration);
+        return solarPanel;
     }
 
     qDebug() << "Database error while fetching SolarPanel by ID (" << id << "):" << query.lastError().text();
@@ -41,11 +36,12 @@ std::optional<SolarPanel> SolarPanelRepository::fetchById(qint64 id)
 }
 
 QList<SolarPanel> SolarPanelRepository::getPanelsByUser(qint64 userId, qint32 page, qint32 limit) {
+    DbQueryTimer queryTimer("SolarPanelRepository::getPanelsByUser");
     QList<SolarPanel> solarPanels;
     int offset = (page - 1) * limit;
 
-    QSqlQuery query(DBController::getDatabase());
-    query.prepare("SELECT id, location, user_id, created_at, updated_at FROM solar_panel WHERE user_id = :user_id LIMIT :limit OFFSET :offset");
+    InstrumentedQuery query("SolarPanelRepository::getPanelsByUser");
+    query.prepare("SELECT id, location, user_id, created_at, updated_at FROM solar_panel WHERE user_id = :user_id ORDER BY id LIMIT :limit OFFSET :offset");
     query.bindValue(":user_id", userId);
     query.bindValue(":limit", limit);
     query.bindValue(":offset", offset);
@@ -77,18 +73,37 @@ QList<SolarPanel> SolarPanelRepository::getPanelsByUser(qint64 userId, qint32 pa
 }
 
 bool SolarPanelRepository::deleteSolarPanel(qint64 id) {
-    QSqlQuery query(DBController::getDatabase());
-    query.prepare("DELETE FROM solar_panel WHERE id = :id");
+    DbQueryTimer queryTimer("SolarPanelRepository::deleteSolarPanel");
+    InstrumentedQuery query("SolarPanelRepository::deleteSolarPanel");
+    // The panel's sensors go with it (ON DELETE CASCADE); the SELECT still sees them, since
+    // every part of the statement reads the snapshot from before the delete. One row per
+    // sensor, or a single row with a NULL sensor id for an empty panel.
+    query.prepare(R"(
+        WITH deleted AS (DELETE FROM solar_panel WHERE id = :id RETURNING id)
+        SELECT d.id, s.id
+        FROM deleted d
+        LEFT JOIN sensor s ON s.solar_panel_id = d.id
+    )");
     query.bindValue(":id", id);
-    if(!query.exec()){
+    bool executed = query.exec();
+    MetadataCache::instance().invalidateSolarPanel(id);
+    if(!executed){
         qDebug() << "Database error while deleting SolarPanel by ID (" << id << "):" << query.lastError().text();
         return false;
     }
-    return query.numRowsAffected() > 0;
+    bool deleted = false;
+    while (query.next()) {
+        deleted = true;
+        if (!query.value(1).isNull()) {
+            SensorRepository::forgetDeletedSensor(query.value(1).toLongLong());
+        }
+    }
+    return deleted;
 }
 
 std::optional<SolarPanel> SolarPanelRepository::createSolarPanel(const SolarPanel& solarPanel) {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("SolarPanelRepository::createSolarPanel");
+    InstrumentedQuery query("SolarPanelRepository::createSolarPanel");
     // Database triggers (trg_solar_panel_insert and set_timestamps) will handle created_at and updated_at
     query.prepare(R"(INSERT INTO solar_panel (location, user_id)
                     VALUES (:location, :user_id))");
@@ -110,7 +125,8 @@ std::optional<SolarPanel> SolarPanelRepository::createSolarPanel(const SolarPane
 }
 
 bool SolarPanelRepository::updateSolarPanel(const SolarPanel& solarPanel) {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("SolarPanelRepository::updateSolarPanel");
+    InstrumentedQuery query("SolarPanelRepository::updateSolarPanel");
     // The trigger trg_solar_panel_update and its procedure set_timestamps() will handle updated_at.
     // Explicitly setting it in the query is also fine and common (as in your original code).
     query.prepare(R"(UPDATE solar_panel
@@ -122,9 +138,31 @@ bool SolarPanelRepository::updateSolarPanel(const SolarPanel& solarPanel) {
     query.bindValue(":user_id", solarPanel.user().id());
     query.bindValue(":id", solarPanel.id());
 
-    if(!query.exec()){
+    bool executed = query.exec();
+    MetadataCache::instance().invalidateSolarPanel(solarPanel.id());
+    if(!executed){
         qDebug() << "Database error while updating SolarPanel by ID (" << solarPanel.id() << "):" << query.lastError().text();
         return false;
     }
     return query.numRowsAffected() > 0;
 }
+
+std::optional<QByteArray> SolarPanelRepository::getPanelsVersionByUser(qint64 userId) {
+    DbQueryTimer queryTimer("SolarPanelRepository::getPanelsVersionByUser");
+    InstrumentedQuery query("SolarPanelRepository::getPanelsVersionByUser");
+    query.prepare(R"(
+        SELECT COUNT(*), COALESCE(MAX(id), 0),
+               COALESCE(CAST(EXTRACT(EPOCH FROM MAX(COALESCE(updated_at, created_at))) * 1000000 AS bigint), 0)
+        FROM solar_panel
+        WHERE user_id = :user_id
+    )");
+    query.bindValue(":user_id", userId);
+
+    if (query.exec() && query.next()) {
+        return QByteArray::number(query.value(0).toLongLong()) + '-' + QByteArray::number(query.value(1).toLongLong())
+               + '-' + QByteArray::number(query.value(2).toLongLong());
+    }
+
+    qDebug() << "Database error (getPanelsVersionByUser):" << query.lastError().text();
+    return std::nullopt;
+}
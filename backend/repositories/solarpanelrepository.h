@@ -16,6 +16,8 @@ public:
     std::optional<SolarPanel> createSolarPanel(const SolarPanel &solarPanel); // Argument type is const ref
     bool deleteSolarPanel(qint64 id);
     QList<SolarPanel> getPanelsByUser(qint64 userId, qint32 page, qint32 limit);
+    // Changes whenever a panel of the user is added, removed or updated; std::nullopt on error.
+    std::optional<QByteArray> getPanelsVersionByUser(qint64 userId);
 };
 
 #endif // SOLARPANELREPOSITORY_H
@@ -1,5 +1,9 @@
 #include "userrepository.h"
 #include "../controllers/dbcontroller.h" // Ensure this path is correct
+#include "../utils/metrics.h"
+#include "instrumentedquery.h"
+#include "metadatacache.h"
+#include "sensorrepository.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
@@ -8,7 +12,13 @@
 // #include <QCryptographicHash> // Commented out as per request
 
 std::optional<User> UserRepository::getUserById(qint64 id) {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("UserRepository::getUserById");
+    if (auto cached = MetadataCache::instance().user(id)) {
+        return cached;
+    }
+    quint64 cacheGeneration = MetadataCache::instance().generation();
+
+    InstrumentedQuery query("UserRepository::getUserById");
     QString queryString = R"(
         SELECT id, email, password FROM "user"
         WHERE id = :id;
@@ -16,9 +26,11 @@ std::optional<User> UserRepository::getUserById(qint64 id) {
     query.prepare(queryString);
     query.bindValue(":id", id);
     if (query.exec() && query.next()) {
-        return User(query.value("id").toLongLong(),
-                    query.value("email").toString(),
-                    query.value("password").toString()); // Use 'password' column
+        User user(query.value("id").toLongLong(),
+                  query.value("email").toString(),
+                  query.value("password").toString()); // Use 'password' column
+        MetadataCache::instance().insertUser(user, cacheGeneration);
+        return user;
     } else {
         if(query.lastError().isValid())
             qDebug() << "Database error (getUserById):" << query.lastError().text();
@@ -27,7 +39,8 @@ std::optional<User> UserRepository::getUserById(qint64 id) {
 }
 
 bool UserRepository::updateUser(const User& user) {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("UserRepository::updateUser");
+    InstrumentedQuery query("UserRepository::updateUser");
     // Note: This update logic assumes you might want to update email and/or password.
     // If password is provided in the User object, it will be updated.
     // If only email is being updated, the password in the User object should be the existing one or empty.
@@ -46,7 +59,9 @@ bool UserRepository::updateUser(const User& user) {
     }
     query.bindValue(":id", user.id());
 
-    if (!query.exec()) {
+    bool executed = query.exec();
+    MetadataCache::instance().invalidateUser(user.id());
+    if (!executed) {
         qWarning() << "Failed to update user:" << query.lastError().text();
         return false;
     }
@@ -54,7 +69,8 @@ bool UserRepository::updateUser(const User& user) {
 }
 
 std::optional<User> UserRepository::createUser(const User& user) {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("UserRepository::createUser");
+    InstrumentedQuery query("UserRepository::createUser");
     QString queryString = R"(
         INSERT INTO "user" (email, password)
         VALUES (:email, :password) RETURNING id;
@@ -86,21 +102,38 @@ std::optional<User> UserRepository::createUser(const User& user) {
 }
 
 bool UserRepository::deleteUser(qint64 userId) {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("UserRepository::deleteUser");
+    InstrumentedQuery query("UserRepository::deleteUser");
+    // Panels and their sensors cascade with the user; the SELECT reads the snapshot from before
+    // the delete, so it still lists the sensors that went (one NULL row when there were none).
     QString queryString = R"(
-        DELETE FROM "user" WHERE id = :id
+        WITH deleted AS (DELETE FROM "user" WHERE id = :id RETURNING id)
+        SELECT d.id, s.id
+        FROM deleted d
+        LEFT JOIN solar_panel p ON p.user_id = d.id
+        LEFT JOIN sensor s ON s.solar_panel_id = p.id
     )";
     query.prepare(queryString);
     query.bindValue(":id", userId);
-    if (!query.exec()) {
+    bool executed = query.exec();
+    MetadataCache::instance().invalidateUser(userId);
+    if (!executed) {
         qDebug() << "Database error (deleteUser):" << query.lastError().text();
         return false;
     }
-    return query.numRowsAffected() > 0;
+    bool deleted = false;
+    while (query.next()) {
+        deleted = true;
+        if (!query.value(1).isNull()) {
+            SensorRepository::forgetDeletedSensor(query.value(1).toLongLong());
+        }
+    }
+    return deleted;
 }
 
 std::optional<User> UserRepository::findUserByEmail(const QString& email) {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("UserRepository::findUserByEmail");
+    InstrumentedQuery query("UserRepository::findUserByEmail");
     QString queryString = R"(
         SELECT id, email, password FROM "user" WHERE email = :email
     )"; // Use 'password' column
@@ -118,25 +151,34 @@ std::optional<User> UserRepository::findUserByEmail(const QString& email) {
 
 std::optional<User> UserRepository::findUserById(qint64 id)
 {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("UserRepository::findUserById");
+    if (auto cached = MetadataCache::instance().user(id)) {
+        return cached;
+    }
+    quint64 cacheGeneration = MetadataCache::instance().generation();
+
+    InstrumentedQuery query("UserRepository::findUserById");
     QString queryString = R"(
         SELECT id, email, password FROM "user" WHERE id = :id
     )"; // Use 'password' column
     query.prepare(queryString);
     query.bindValue(":id", id);
     if (query.exec() && query.next()) {
-        return User(query.value("id").toLongLong(),
-                    query.value("email").toString(),
-                    query.value("password").toString()); // Use 'password' column
+        User user(query.value("id").toLongLong(),
+                  query.value("email").toString(),
+                  query.value("password").toString()); // Use 'password' column
+        MetadataCache::instance().insertUser(user, cacheGeneration);
+        return user;
     }
     if(query.lastError().isValid())
         qDebug() << "Database error (findUserById):" << query.lastError().text();
     return std::nullopt;
 }
 
-QList<User> UserRepository::getUsers(int page, int limit) {
-    QList<User> users;
-    QSqlQuery query(DBController::getDatabase());
+RowCursor<User> UserRepository::openUsers(int page, int limit) {
+    DbQueryTimer queryTimer("UserRepository::openUsers");
+    InstrumentedQuery query("UserRepository::openUsers");
+    query.setForwardOnly(true);
     QString queryString = R"(
         SELECT id, email, password FROM "user"
         ORDER BY id ASC
@@ -146,20 +188,18 @@ QList<User> UserRepository::getUsers(int page, int limit) {
     query.bindValue(":limit", limit);
     query.bindValue(":offset", (page - 1) * limit);
 
-    if (query.exec()) {
-        while (query.next()) {
-            users.append(User(query.value("id").toLongLong(),
-                              query.value("email").toString(),
-                              query.value("password").toString())); // Use 'password' column
-        }
-    } else {
-        qDebug() << "Database error (getUsers):" << query.lastError().text();
+    if (!query.exec()) {
+        qDebug() << "Database error (openUsers):" << query.lastError().text();
+        return {};
     }
-    return users;
+    return RowCursor<User>(std::move(query), [](const QSqlQuery& row) {
+        return User(row.value(0).toLongLong(), row.value(1).toString(), row.value(2).toString());
+    });
 }
 
 int UserRepository::getTotalUserCount() {
-    QSqlQuery query(DBController::getDatabase());
+    DbQueryTimer queryTimer("UserRepository::getTotalUserCount");
+    InstrumentedQuery query("UserRepository::getTotalUserCount");
     QString queryString = R"(SELECT COUNT(*) FROM "user";)";
     query.prepare(queryString);
 
@@ -172,6 +212,7 @@ int UserRepository::getTotalUserCount() {
 }
 
 bool UserRepository::verifyPassword(const QString& email, const QString& plainPassword) {
+    DbQueryTimer queryTimer("UserRepository::verifyPassword");
     auto userOptional = findUserByEmail(email);
     if (userOptional) {
         QString storedPassword = userOptional->password(); // This is the stored plain password
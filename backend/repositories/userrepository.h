@@ -4,6 +4,7 @@
 #include "../models/user.h"
 #include <QList>      // Required for QList
 #include <optional>   // Required for std::optional
+#include "rowcursor.h"
 
 class UserRepository
 {
@@ -17,7 +18,7 @@ public:
     std::optional<User> findUserById(qint64 id);
 
     // New methods for listing users with pagination
-    QList<User> getUsers(int page, int limit);
+    RowCursor<User> openUsers(int page, int limit);
     int getTotalUserCount();
     bool verifyPassword(const QString& email, const QString& password); // Added declaration
 };
@@ -1,6 +1,10 @@
 #include "backuphandler.h"
 #include "../utils/responsefactory.h"
 #include "../controllers/dbcontroller.h" // For DB connection parameters
+#include "../repositories/metadatacache.h"
+#include "../repositories/latestmeasurementtable.h"
+#include "../repositories/hotwindowstore.h"
+#include "../utils/metrics.h"
 
 #include <QProcess>
 #include <QTemporaryFile>
@@ -23,24 +27,37 @@ BackupHandler::BackupHandler(std::shared_ptr<DBController> dbController)
 
 // Example helper implementations (these should ideally pull from DBController's actual config)
 QString BackupHandler::getDbName() const {
-    return DBController::getDatabase().databaseName();
+    return DBController::pool().settings().databaseName;
 }
 QString BackupHandler::getUserName() const {
-    return DBController::getDatabase().userName();
+    return DBController::pool().settings().userName;
 }
 QString BackupHandler::getPassword() const {
-    return DBController::getDatabase().password();
+    return DBController::pool().settings().password;
 }
 QString BackupHandler::getHostName() const {
-    return DBController::getDatabase().hostName().isEmpty() ? "localhost" : DBController::getDatabase().hostName();
+    return DBController::pool().settings().host.isEmpty() ? "localhost" : DBController::pool().settings().host;
 }
 int BackupHandler::getPort() const {
-    return DBController::getDatabase().port() == -1 ? 5432 : DBController::getDatabase().port() ;
+    return DBController::pool().settings().port <= 0 ? 5432 : DBController::pool().settings().port;
 }
 
 
-QHttpServerResponse BackupHandler::exportDatabase(const QHttpServerRequest& request) {
+namespace {
+// Outcomes are counted per status by the route metrics of the backup endpoints.
+MetricsRegistry::Histogram &backupDuration(const char *operation)
+{
+    static const std::vector<double> bounds {1, 5, 15, 30, 60, 120, 300, 600, 1800, 3600};
+    return MetricsRegistry::instance().histogram("arkanova_backup_duration_seconds",
+                                                 "Time taken by a database export or import.",
+                                                 {{"operation", operation}}, bounds);
+}
+}
+
+QHttpServerResponse BackupHandler::exportDatabase(const HttpRequest& request) {
     (void)request;
+    static MetricsRegistry::Histogram &duration = backupDuration("export");
+    MetricsRegistry::ScopedTimer timer(duration);
 
     if (!dbController_) {
         return ResponseFactory::createErrorResponse("Database controller not available.", QHttpServerResponse::StatusCode::InternalServerError);
@@ -137,7 +154,10 @@ QHttpServerResponse BackupHandler::exportDatabase(const QHttpServerRequest& requ
     }
 }
 
-QHttpServerResponse BackupHandler::importDatabase(const QHttpServerRequest& request) {
+QHttpServerResponse BackupHandler::importDatabase(const HttpRequest& request) {
+    static MetricsRegistry::Histogram &duration = backupDuration("import");
+    MetricsRegistry::ScopedTimer timer(duration);
+
     if (!dbController_) {
         return ResponseFactory::createErrorResponse("Database controller not available.", QHttpServerResponse::StatusCode::InternalServerError);
     }
@@ -218,6 +238,9 @@ QHttpServerResponse BackupHandler::importDatabase(const QHttpServerRequest& requ
 
         if (psqlProcess.exitStatus() == QProcess::NormalExit && psqlProcess.exitCode() == 0) {
             qInfo() << "Database import successful.";
+            MetadataCache::instance().clear(); // Every cached row may have been replaced
+            LatestMeasurementTable::instance().clear();
+            HotWindowStore::instance().clear();
             if (!errorData.isEmpty()){
                 qWarning().noquote() << "psql stderr (import success):\n" << QString::fromUtf8(errorData);
             }
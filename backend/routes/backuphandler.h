@@ -2,7 +2,7 @@
 #define BACKUPHANDLER_H
 
 #include <QHttpServerResponse>
-#include <QHttpServerRequest>
+#include "../utils/httprequest.h"
 #include <memory>
 
 // Forward declare DBController
@@ -14,8 +14,8 @@ public:
     // Constructor now takes DBController to get connection parameters
     BackupHandler(std::shared_ptr<DBController> dbController);
 
-    QHttpServerResponse exportDatabase(const QHttpServerRequest& request);
-    QHttpServerResponse importDatabase(const QHttpServerRequest& request);
+    QHttpServerResponse exportDatabase(const HttpRequest& request);
+    QHttpServerResponse importDatabase(const HttpRequest& request);
 
 private:
     std::shared_ptr<DBController> dbController_;
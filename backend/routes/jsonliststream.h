@@ -0,0 +1,52 @@
+#ifndef JSONLISTSTREAM_H
+#define JSONLISTSTREAM_H
+
+#include <QByteArray>
+#include <functional>
+#include <memory>
+#include "../repositories/rowcursor.h"
+#include "../utils/jsonstreamdevice.h"
+
+// Builds a JsonStreamDevice producer that writes {"<key>":[row,row,...]<trailer>} from a
+// cursor, one row per call. At most maxRows rows are written; the trailer is told whether
+// the cursor had more and appends any further members, each starting with a comma.
+template <typename T>
+JsonStreamDevice::Producer makeJsonListProducer(const QByteArray &key,
+                                                std::shared_ptr<RowCursor<T>> cursor,
+                                                qint64 maxRows,
+                                                std::function<void(QByteArray&, const T&)> writeRow,
+                                                std::function<void(QByteArray&, qint64 rows, bool hasMore)> writeTrailer)
+{
+    struct State {
+        bool started = false;
+        qint64 rows = 0;
+    };
+    auto state = std::make_shared<State>();
+
+    return [key, cursor, maxRows, writeRow, writeTrailer, state](QByteArray &out) {
+        if (!state->started) {
+            state->started = true;
+            out.append("{\"").append(key).append("\":[");
+            return true;
+        }
+
+        if (state->rows < maxRows) {
+            if (auto row = cursor->next()) {
+                if (state->rows > 0) {
+                    out.append(',');
+                }
+                writeRow(out, *row);
+                ++state->rows;
+                return true;
+            }
+        }
+
+        bool hasMore = state->rows >= maxRows && cursor->next().has_value();
+        out.append(']');
+        writeTrailer(out, state->rows, hasMore);
+        out.append('}');
+        return false;
+    };
+}
+
+#endif // JSONLISTSTREAM_H
@@ -1,14 +1,30 @@
 #include "measurementhandler.h"
 #include <qjsonobject.h>
 #include "../utils/responsefactory.h"
+#include "../utils/lttb.h"
+#include "../utils/jsonwriter.h"
+#include "../repositories/hotwindowstore.h"
+#include "../repositories/latestmeasurementtable.h"
+#include "jsonliststream.h"
+#include "packedseriesstream.h"
 #include <QJsonArray>
+#include <QRegularExpression>
+
+int MeasurementHandler::defaultPageSize_ = 1000;
+int MeasurementHandler::maxPageSize_ = 5000;
 
 MeasurementHandler::MeasurementHandler() {
     // It's good practice to initialize shared_ptr in the constructor
     measurementRepository_ = std::make_shared<MeasurementRepository>();
+    sensorRepository_ = std::make_shared<SensorRepository>();
+}
+
+void MeasurementHandler::setPageSizeLimits(int defaultPageSize, int maxPageSize) {
+    maxPageSize_ = qMax(1, maxPageSize);
+    defaultPageSize_ = qBound(1, defaultPageSize, maxPageSize_);
 }
 
-QHttpServerResponse MeasurementHandler::getMeasurementById(const QHttpServerRequest& request) {
+QHttpServerResponse MeasurementHandler::getMeasurementById(const HttpRequest& request) {
     bool ok;
     qint64 measurementId = request.query().queryItemValue("id").toLongLong(&ok);
 
@@ -25,13 +41,14 @@ QHttpServerResponse MeasurementHandler::getMeasurementById(const QHttpServerRequ
     return ResponseFactory::createResponse("Measurement not found.", QHttpServerResponse::StatusCode::NotFound);
 }
 
-QHttpServerResponse MeasurementHandler::getMeasurementsBySensor(const QHttpServerRequest& request) {
+void MeasurementHandler::getMeasurementsBySensor(const HttpRequest& request, StreamResponder& responder) {
     bool ok;
     qint64 sensorId = request.query().queryItemValue("sensor_id").toLongLong(&ok);
 
     if (!ok) {
-        return ResponseFactory::createResponse("Sensor ID is missing or invalid.",
-                                               QHttpServerResponse::StatusCode::BadRequest);
+        responder.sendResponse(ResponseFactory::createResponse("Sensor ID is missing or invalid.",
+                                                               QHttpServerResponse::StatusCode::BadRequest));
+        return;
     }
 
     auto startDateStr = request.query().queryItemValue("start_date");
@@ -43,21 +60,203 @@ QHttpServerResponse MeasurementHandler::getMeasurementsBySensor(const QHttpServe
     QDateTime endDate = endDateStr.isEmpty() ? QDateTime::currentDateTime()
                                              : QDateTime::fromString(endDateStr, Qt::ISODate);
 
-    auto measurements = measurementRepository_->getMeasurementsBySensorAndDate(sensorId, startDate, endDate);
-    QJsonArray jsonMeasurements;
-    for (const auto& measurement : measurements) {
-        jsonMeasurements.append(measurement.toJson());
+    bool packed = PackedSeriesWriter::isAccepted(request.value("Accept"));
+
+    auto pointsStr = request.query().queryItemValue("points");
+    if (!pointsStr.isEmpty()) {
+        int points = pointsStr.toInt(&ok);
+        if (!ok || points < 3 || points > maxDownsamplePoints) {
+            responder.sendResponse(ResponseFactory::createResponse(QString("Points must be between 3 and %1.").arg(maxDownsamplePoints),
+                                                                   QHttpServerResponse::StatusCode::BadRequest));
+            return;
+        }
+        streamDownsampledMeasurements(sensorId, startDate, endDate, points, packed, responder);
+        return;
+    }
+
+    int limit = defaultPageSize_;
+    auto limitStr = request.query().queryItemValue("limit");
+    if (!limitStr.isEmpty()) {
+        limit = limitStr.toInt(&ok);
+        if (!ok || limit < 1) {
+            responder.sendResponse(ResponseFactory::createResponse("Limit must be a positive number.",
+                                                                   QHttpServerResponse::StatusCode::BadRequest));
+            return;
+        }
+    }
+    limit = qMin(limit, maxPageSize_);
+
+    std::optional<MeasurementKey> after;
+    auto cursorStr = request.query().queryItemValue("cursor");
+    if (!cursorStr.isEmpty()) {
+        after = MeasurementKey::decode(cursorStr.toLatin1());
+        if (!after) {
+            responder.sendResponse(ResponseFactory::createResponse("Cursor is invalid.", QHttpServerResponse::StatusCode::BadRequest));
+            return;
+        }
+    }
+
+    auto cursor = std::make_shared<RowCursor<MeasurementRow>>(
+        measurementRepository_->openPage(sensorId, startDate, endDate, after, limit));
+    if (!cursor->isValid()) {
+        responder.sendResponse(ResponseFactory::createErrorResponse("Failed to read measurements.",
+                                                                    QHttpServerResponse::StatusCode::InternalServerError));
+        return;
+    }
+
+    // The key of the last written row becomes next_cursor when the cursor had more rows.
+    auto lastKey = std::make_shared<MeasurementKey>();
+    // Rows on this page; follow next_cursor until it is null for the rest of the range.
+    auto writePageInfo = [lastKey, limit](QByteArray& out, qint64 rows, bool hasMore) {
+        out.append("\"total_count\":").append(QByteArray::number(rows))
+            .append(",\"limit\":").append(QByteArray::number(limit))
+            .append(",\"next_cursor\":");
+        if (hasMore) {
+            out.append('"').append(lastKey->encode()).append('"');
+        } else {
+            out.append("null");
+        }
+    };
+
+    if (packed) {
+        ResponseFactory::streamResponse(
+            responder, PackedSeriesWriter::contentType,
+            makePackedSeriesProducer<MeasurementRow>(std::make_shared<PackedSeriesWriter>(seriesColumns()), cursor, limit,
+                                                     [lastKey](PackedSeriesWriter& writer, const MeasurementRow& row) {
+                                                         appendSeriesRow(writer, row.measurement.id(),
+                                                                         row.key.recordedAtUs,
+                                                                         row.measurement.reportedValue());
+                                                         *lastKey = row.key;
+                                                     },
+                                                     [writePageInfo](QByteArray& out, qint64 rows, bool hasMore) {
+                                                         out.append('{');
+                                                         writePageInfo(out, rows, hasMore);
+                                                         out.append('}');
+                                                     }),
+            QHttpServerResponse::StatusCode::Ok);
+        return;
+    }
+
+    ResponseFactory::streamJsonResponse(
+        responder,
+        makeJsonListProducer<MeasurementRow>("measurements", cursor, limit,
+                                             [lastKey](QByteArray& out, const MeasurementRow& row) {
+                                                 row.measurement.writeJson(out);
+                                                 *lastKey = row.key;
+                                             },
+                                             [writePageInfo](QByteArray& out, qint64 rows, bool hasMore) {
+                                                 out.append(',');
+                                                 writePageInfo(out, rows, hasMore);
+                                             }),
+        QHttpServerResponse::StatusCode::Ok);
+}
+
+QList<PackedSeriesWriter::Column> MeasurementHandler::seriesColumns() {
+    return {{"recorded_at", PackedSeriesWriter::ColumnType::Int64},
+            {"value", PackedSeriesWriter::ColumnType::Float64},
+            {"id", PackedSeriesWriter::ColumnType::Int64}};
+}
+
+void MeasurementHandler::appendSeriesRow(PackedSeriesWriter& writer, qint64 id, qint64 recordedAtUs,
+                                         std::optional<double> value) {
+    writer.appendInt64(0, MeasurementPoint::epochMs(recordedAtUs));
+    writer.appendFloat64(1, value);
+    writer.appendInt64(2, id);
+}
+
+void MeasurementHandler::streamDownsampledMeasurements(qint64 sensorId, const QDateTime& startDate,
+                                                       const QDateTime& endDate, int points, bool packed,
+                                                       StreamResponder& responder) {
+    auto cursor = std::make_shared<RowCursor<MeasurementPoint>>(measurementRepository_->openSeries(sensorId, startDate, endDate));
+    if (!cursor->isValid()) {
+        responder.sendResponse(ResponseFactory::createErrorResponse("Failed to read measurements.",
+                                                                    QHttpServerResponse::StatusCode::InternalServerError));
+        return;
+    }
+
+    struct State {
+        State(int points, qint64 endUs) : downsampler(points, endUs) {}
+        LttbDownsampler downsampler;
+        std::optional<PackedSeriesWriter> writer;
+        QList<MeasurementPoint> selected;
+        qsizetype remaining = 0;
+        bool started = false;
+        bool inputDone = false;
+    };
+    QDateTime rangeEnd = endDate.isValid() ? endDate : QDateTime::currentDateTime();
+    // The downsampler works on stored timestamps, so the range end is converted the same way.
+    auto state = std::make_shared<State>(points, HotWindowStore::storedUs(rangeEnd));
+    if (packed) {
+        state->writer.emplace(seriesColumns());
     }
-    QJsonObject response;
-    response["measurements"] = jsonMeasurements;
-    // The total_count seems to be hardcoded, you might want to adjust this
-    response["total_count"] = measurements.count(); // Or actual count if paginating
 
-    return ResponseFactory::createJsonResponse(QJsonDocument(response).toJson(),
-                                               QHttpServerResponse::StatusCode::Ok);
+    // LTTB needs the input oldest first while the list endpoint answers newest first, so the
+    // selection (at most `points` rows) is written once the input is exhausted, in reverse.
+    // Each call reads a bounded slice of input.
+    auto producer = [cursor, state](QByteArray& out) {
+        constexpr int inputRowsPerCall = 4096;
+
+        if (!state->started) {
+            state->started = true;
+            if (state->writer) {
+                state->writer->writeHeader(out);
+            } else {
+                out.append("{\"measurements\":[");
+            }
+            return true;
+        }
+
+        if (!state->inputDone) {
+            for (int i = 0; i < inputRowsPerCall; ++i) {
+                auto point = cursor->next();
+                if (!point) {
+                    state->inputDone = true;
+                    state->selected.append(state->downsampler.finish());
+                    state->remaining = state->selected.size();
+                    return true;
+                }
+                state->downsampler.add(*point);
+            }
+            state->selected.append(state->downsampler.takeSelected());
+            return true;
+        }
+
+        if (state->remaining > 0) {
+            if (state->writer) {
+                // The whole selection goes out as one batch.
+                for (; state->remaining > 0; --state->remaining) {
+                    const MeasurementPoint& point = state->selected.at(state->remaining - 1);
+                    appendSeriesRow(*state->writer, point.id, point.recordedAtUs, point.value);
+                }
+                state->writer->writeBatch(out);
+                return true;
+            }
+            if (state->remaining < state->selected.size()) {
+                out.append(',');
+            }
+            state->selected.at(--state->remaining).writeJson(out);
+            return true;
+        }
+
+        QByteArray counts = QByteArray("\"total_count\":").append(QByteArray::number(state->selected.size()))
+                                .append(",\"source_count\":").append(QByteArray::number(state->downsampler.inputCount()));
+        if (state->writer) {
+            state->writer->writeEnd(out, '{' + counts + '}');
+        } else {
+            out.append("],").append(counts).append('}');
+        }
+        return false;
+    };
+
+    if (packed) {
+        ResponseFactory::streamResponse(responder, PackedSeriesWriter::contentType, producer,
+                                        QHttpServerResponse::StatusCode::Ok);
+    } else {
+        ResponseFactory::streamJsonResponse(responder, producer, QHttpServerResponse::StatusCode::Ok);
+    }
 }
 
-QHttpServerResponse MeasurementHandler::getLatestMeasurementBySensor(const QHttpServerRequest& request) {
+QHttpServerResponse MeasurementHandler::getLatestMeasurementBySensor(const HttpRequest& request) {
     bool ok;
     qint64 sensorId = request.query().queryItemValue("sensor_id").toLongLong(&ok);
 
@@ -66,10 +265,182 @@ QHttpServerResponse MeasurementHandler::getLatestMeasurementBySensor(const QHttp
                                                QHttpServerResponse::StatusCode::BadRequest);
     }
 
-    auto measurement = measurementRepository_->getLatestMeasurementBySensorId(sensorId);
-    if (measurement) {
-        QByteArray responseData = QJsonDocument(measurement->toJson()).toJson(QJsonDocument::Compact);
-        return ResponseFactory::createJsonResponse(responseData, QHttpServerResponse::StatusCode::Ok);
+    // Ingest keeps the table current; a miss (sensor not seen since startup) falls back to one
+    // index probe and fills the table for the next poll, unless the sensor was deleted while
+    // the probe ran.
+    LatestMeasurementTable& latestTable = LatestMeasurementTable::instance();
+    quint64 latestGeneration = latestTable.generation(sensorId);
+    std::optional<MeasurementPoint> latest = latestTable.latest(sensorId);
+    if (!latest) {
+        latest = measurementRepository_->getLatestPointBySensorId(sensorId);
+        if (latest) {
+            latestTable.fill(sensorId, *latest, latestGeneration);
+        }
+    }
+
+    if (latest) {
+        if (latest->value && !sensorRepository_->reportsReadings(sensorId)) {
+            latest->value = std::nullopt;
+        }
+
+        QByteArray etag = ResponseFactory::entityTag("m" + QByteArray::number(latest->id));
+        if (ResponseFactory::isNotModified(request, etag)) {
+            return ResponseFactory::createNotModifiedResponse(etag);
+        }
+
+        QByteArray responseData;
+        latest->writeJson(responseData);
+        auto response = ResponseFactory::createJsonResponse(responseData, QHttpServerResponse::StatusCode::Ok);
+        ResponseFactory::setEntityTag(response, etag);
+        return response;
     }
     return ResponseFactory::createResponse("Latest measurement not found for this sensor or sensor does not exist.", QHttpServerResponse::StatusCode::NotFound);
 }
+
+QHttpServerResponse MeasurementHandler::getAggregatedMeasurementsBySensor(const HttpRequest& request) {
+    bool ok;
+    qint64 sensorId = request.query().queryItemValue("sensor_id").toLongLong(&ok);
+
+    if (!ok) {
+        return ResponseFactory::createResponse("Sensor ID is missing or invalid.",
+                                               QHttpServerResponse::StatusCode::BadRequest);
+    }
+
+    QString bucket = request.query().queryItemValue("bucket");
+    qint64 bucketSeconds = parseBucketSeconds(bucket);
+    if (bucketSeconds <= 0) {
+        return ResponseFactory::createResponse("Bucket is missing or invalid; use e.g. 1m, 15m, 1h or 1d.",
+                                               QHttpServerResponse::StatusCode::BadRequest);
+    }
+
+    auto aggregatesStr = request.query().queryItemValue("aggregates");
+    auto aggregates = aggregatesStr.isEmpty() ? std::optional(MeasurementBucket::allAggregates())
+                                              : MeasurementBucket::parseAggregates(aggregatesStr);
+    if (!aggregates || *aggregates == MeasurementBucket::Aggregates()) {
+        return ResponseFactory::createResponse("Aggregates must be a comma-separated list of min, max, avg, count, first, last.",
+                                               QHttpServerResponse::StatusCode::BadRequest);
+    }
+
+    auto startDateStr = request.query().queryItemValue("start_date");
+    auto endDateStr = request.query().queryItemValue("end_date");
+
+    QDateTime endDate = endDateStr.isEmpty() ? QDateTime::currentDateTime()
+                                             : QDateTime::fromString(endDateStr, Qt::ISODate);
+    QDateTime startDate = startDateStr.isEmpty() ? endDate.addDays(-1)
+                                                 : QDateTime::fromString(startDateStr, Qt::ISODate);
+
+    if (!startDate.isValid() || !endDate.isValid() || startDate >= endDate) {
+        return ResponseFactory::createResponse("Start and end dates are invalid.",
+                                               QHttpServerResponse::StatusCode::BadRequest);
+    }
+
+    if (startDate.secsTo(endDate) / bucketSeconds > maxAggregateBuckets) {
+        return ResponseFactory::createResponse(QString("The range needs more than %1 buckets; use a larger bucket.")
+                                                   .arg(maxAggregateBuckets),
+                                               QHttpServerResponse::StatusCode::BadRequest);
+    }
+
+    auto buckets = measurementRepository_->aggregateBySensor(sensorId, startDate, endDate, bucketSeconds, *aggregates);
+    if (PackedSeriesWriter::isAccepted(request.value("Accept"))) {
+        return packedBucketsResponse(sensorId, bucket, *aggregates, buckets);
+    }
+
+    QByteArray response;
+    response.reserve(64 + buckets.size() * 128);
+    response.append('{');
+    JsonWriter::appendKey(response, "sensor_id", true);
+    JsonWriter::appendInt(response, sensorId);
+    JsonWriter::appendKey(response, "bucket");
+    JsonWriter::appendString(response, bucket);
+    JsonWriter::appendKey(response, "buckets");
+    response.append('[');
+    for (qsizetype i = 0; i < buckets.size(); ++i) {
+        if (i > 0) {
+            response.append(',');
+        }
+        buckets.at(i).writeJson(response);
+    }
+    response.append(']');
+    JsonWriter::appendKey(response, "total_count");
+    JsonWriter::appendInt(response, buckets.size());
+    response.append('}');
+
+    return ResponseFactory::createJsonResponse(response, QHttpServerResponse::StatusCode::Ok);
+}
+
+QHttpServerResponse MeasurementHandler::packedBucketsResponse(qint64 sensorId, const QString& bucket,
+                                                              MeasurementBucket::Aggregates aggregates,
+                                                              const QList<MeasurementBucket>& buckets) {
+    using Aggregate = MeasurementBucket::Aggregate;
+    using ColumnType = PackedSeriesWriter::ColumnType;
+
+    // Columns follow the JSON key order: bucket_start, then the requested aggregates.
+    struct AggregateColumn {
+        Aggregate aggregate;
+        const char* name;
+        std::optional<double> (MeasurementBucket::*value)() const;
+    };
+    static const AggregateColumn aggregateColumns[] = {
+        {Aggregate::Min, "min", &MeasurementBucket::min},
+        {Aggregate::Max, "max", &MeasurementBucket::max},
+        {Aggregate::Avg, "avg", &MeasurementBucket::avg},
+        {Aggregate::Count, "count", nullptr},
+        {Aggregate::First, "first", &MeasurementBucket::first},
+        {Aggregate::Last, "last", &MeasurementBucket::last},
+    };
+
+    QList<PackedSeriesWriter::Column> columns{{"bucket_start", ColumnType::Int64}};
+    QList<const AggregateColumn*> selected;
+    for (const AggregateColumn& column : aggregateColumns) {
+        if (aggregates & column.aggregate) {
+            columns.append({column.name, column.value ? ColumnType::Float64 : ColumnType::Int64});
+            selected.append(&column);
+        }
+    }
+
+    PackedSeriesWriter writer(columns);
+    for (const MeasurementBucket& measurementBucket : buckets) {
+        writer.appendInt64(0, measurementBucket.start().toMSecsSinceEpoch());
+        for (qsizetype i = 0; i < selected.size(); ++i) {
+            if (selected.at(i)->value) {
+                writer.appendFloat64(int(i + 1), (measurementBucket.*(selected.at(i)->value))());
+            } else {
+                writer.appendInt64(int(i + 1), measurementBucket.count().value_or(0));
+            }
+        }
+    }
+
+    QByteArray trailer("{");
+    JsonWriter::appendKey(trailer, "sensor_id", true);
+    JsonWriter::appendInt(trailer, sensorId);
+    JsonWriter::appendKey(trailer, "bucket");
+    JsonWriter::appendString(trailer, bucket);
+    JsonWriter::appendKey(trailer, "total_count");
+    JsonWriter::appendInt(trailer, buckets.size());
+    trailer.append('}');
+
+    QByteArray body;
+    body.reserve(64 + buckets.size() * columns.size() * 8 + trailer.size());
+    writer.writeHeader(body);
+    writer.writeEnd(body, trailer);
+    return ResponseFactory::createBinaryResponse(body, PackedSeriesWriter::contentType, QHttpServerResponse::StatusCode::Ok);
+}
+
+qint64 MeasurementHandler::parseBucketSeconds(const QString& bucket) {
+    static const QRegularExpression pattern("^(\\d{1,6})([smhd])$");
+    QRegularExpressionMatch match = pattern.match(bucket);
+    if (!match.hasMatch()) {
+        return 0;
+    }
+
+    qint64 amount = match.captured(1).toLongLong();
+    QChar unit = match.captured(2).at(0);
+    if (unit == 'm') {
+        amount *= 60;
+    } else if (unit == 'h') {
+        amount *= 3600;
+    } else if (unit == 'd') {
+        amount *= 86400;
+    }
+    return amount;
+}
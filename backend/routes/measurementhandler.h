@@ -1,18 +1,50 @@
 #ifndef MEASUREMENTHANDLER_H
 #define MEASUREMENTHANDLER_H
 #include <qhttpserverresponse.h>
-#include <qhttpserverrequest.h>
+#include "../utils/streamresponder.h"
+#include "../utils/httprequest.h"
 #include "../repositories/measurementrepository.h"
+#include "../repositories/sensorrepository.h"
+#include "../utils/packedseries.h"
 
 class MeasurementHandler
 {
 public:
     MeasurementHandler();
-    QHttpServerResponse getMeasurementsBySensor(const QHttpServerRequest &request);
-    QHttpServerResponse getMeasurementById(const QHttpServerRequest &request);
-    QHttpServerResponse getLatestMeasurementBySensor(const QHttpServerRequest& request); // New method
+
+    // Page size used when a list request has no limit, and the cap applied to any limit.
+    static void setPageSizeLimits(int defaultPageSize, int maxPageSize);
+
+    void getMeasurementsBySensor(const HttpRequest& request, StreamResponder& responder);
+    QHttpServerResponse getMeasurementById(const HttpRequest& request);
+    QHttpServerResponse getLatestMeasurementBySensor(const HttpRequest& request); // New method
+    QHttpServerResponse getAggregatedMeasurementsBySensor(const HttpRequest& request);
 private:
+    static int defaultPageSize_;
+    static int maxPageSize_;
+
+    // Upper bound on buckets per aggregate request, so a tiny bucket over a long range is refused.
+    static constexpr qint64 maxAggregateBuckets = 10000;
+    // Upper bound on points=N for LTTB-downsampled lists.
+    static constexpr int maxDownsamplePoints = 10000;
+
+    // The list endpoints answer with PackedSeriesWriter::contentType instead of JSON when the
+    // Accept header asks for it; the JSON trailer fields travel in the packed trailer.
+    void streamDownsampledMeasurements(qint64 sensorId, const QDateTime& startDate, const QDateTime& endDate,
+                                       int points, bool packed, StreamResponder& responder);
+    static QHttpServerResponse packedBucketsResponse(qint64 sensorId, const QString& bucket,
+                                                     MeasurementBucket::Aggregates aggregates,
+                                                     const QList<MeasurementBucket>& buckets);
+
+    // recorded_at (ms, int64), value (float64, NaN when not numeric), id (int64).
+    static QList<PackedSeriesWriter::Column> seriesColumns();
+    static void appendSeriesRow(PackedSeriesWriter& writer, qint64 id, qint64 recordedAtUs, std::optional<double> value);
+
+    // Parses "30s", "15m", "1h", "1d" into seconds; returns 0 when invalid.
+    static qint64 parseBucketSeconds(const QString& bucket);
+
     std::shared_ptr<MeasurementRepository> measurementRepository_;
+    std::shared_ptr<SensorRepository> sensorRepository_;
 };
 
 #endif // MEASUREMENTHANDLER_H
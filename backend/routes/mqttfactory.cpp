@@ -1,5 +1,7 @@
 #include "mqttfactory.h"
 #include "mqttmeasurementhandler.h"
+#include "../utils/logevent.h"
+#include "../utils/metrics.h"
 
 MqttFactory::MqttFactory(const QString &broker, int port, const QString &username, const QString &password, QObject *parent)
     : QObject(parent), broker_(broker), port_(port), username_(username), password_(password)
@@ -10,10 +12,6 @@ MqttFactory::MqttFactory(const QString &broker, int port, const QString &usernam
     mqttClient_->setUsername(username_);
     mqttClient_->setPassword(password_);
 
-
-
-
-
     connect(mqttClient_, &QMqttClient::stateChanged, this, &MqttFactory::handleStateChange);
     connect(mqttClient_, &QMqttClient::errorChanged, this, &MqttFactory::handleError);
     connect(mqttClient_, &QMqttClient::messageReceived, this, &MqttFactory::handleMessage);
@@ -57,6 +55,11 @@ void MqttFactory::setupAllTopics()
     subscribeToTopic("mqtt/api/measure");
 }
 
+void MqttFactory::setMeasurementBatcher(std::shared_ptr<MeasurementBatcher> batcher)
+{
+    measurementHandler_ = std::make_shared<MqttMeasurementHandler>(batcher);
+}
+
 void MqttFactory::handleStateChange(QMqttClient::ClientState state)
 {
     switch (state) {
@@ -80,11 +83,21 @@ void MqttFactory::handleError(QMqttClient::ClientError error)
 
 void MqttFactory::handleMessage(const QByteArray &message, const QMqttTopicName &topic)
 {
-    Logger::instance().log(QString("MQTT: Message received. Topic = %1, Message = %2")
-                               .arg(topic.name(), QString(message)),
-                               Logger::LogLevel::Info);
+    static MetricsRegistry::Counter &receivedMessages = MeasurementBatcher::stageCounter("received");
+    receivedMessages.increment();
 
-    MqttMeasurementHandler mqttMeasurementHandler;
-    mqttMeasurementHandler.saveMeasurementToDatabase(message);
+    // Every reading passes through here; a sample is enough to see traffic flowing.
+    static LogSite messageSite("mqtt.message", Logger::LogLevel::Debug, {.sampleEvery = 100, .maxPerSecond = 10});
+    if (messageSite.shouldLog()) {
+        LogEvent(messageSite)
+            .add("topic", topic.name())
+            .add("bytes", message.size())
+            .add("payload", QString::fromUtf8(message.left(200)))
+            .write();
+    }
+
+    if (measurementHandler_) {
+        measurementHandler_->saveMeasurementToDatabase(message);
+    }
     emit messageReceived(topic.name(), message);
 }
@@ -3,8 +3,12 @@
 
 #include <QObject>
 #include <QMqttClient>
+#include <memory>
 #include "../utils/logger.h"
 
+class MeasurementBatcher;
+class MqttMeasurementHandler;
+
 class MqttFactory : public QObject
 {
     Q_OBJECT
@@ -20,6 +24,8 @@ public:
 
     void setupAllTopics();
 
+    void setMeasurementBatcher(std::shared_ptr<MeasurementBatcher> batcher);
+
 signals:
     void messageReceived(const QString &topic, const QByteArray &message);
 
@@ -34,6 +40,7 @@ private:
     int port_;
     QString username_;
     QString password_;
+    std::shared_ptr<MqttMeasurementHandler> measurementHandler_;
 };
 
 #endif // MQTTFACTORY_H
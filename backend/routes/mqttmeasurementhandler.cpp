@@ -1,43 +1,120 @@
 #include "mqttmeasurementhandler.h"
-#include "../repositories/measurementrepository.h"
-#include "../utils/logger.h"
+#include "../utils/logevent.h"
+#include "../utils/metrics.h"
 #include <qjsondocument.h>
 #include <qjsonobject.h>
-#include "../repositories/sensorrepository.h"
+#include <cmath>
+#include <limits>
+#include <optional>
 
+namespace {
 
-MqttMeasurementHandler::MqttMeasurementHandler() {}
+// sensor.id is an integer column; one id outside its range would fail the whole batch insert.
+std::optional<qint64> parseSensorId(const QJsonValue& value)
+{
+    qint64 id = 0;
+    if (value.isDouble()) {
+        double number = value.toDouble();
+        if (number != std::floor(number) || number < 1 || number > std::numeric_limits<qint32>::max()) {
+            return std::nullopt;
+        }
+        id = qint64(number);
+    } else if (value.isString()) {
+        bool ok;
+        id = value.toString().toLongLong(&ok);
+        if (!ok) {
+            return std::nullopt;
+        }
+    } else {
+        return std::nullopt;
+    }
+    if (id < 1 || id > std::numeric_limits<qint32>::max()) {
+        return std::nullopt;
+    }
+    return id;
+}
+
+std::optional<double> parseReading(const QJsonValue& value)
+{
+    double reading = 0;
+    if (value.isDouble()) {
+        reading = value.toDouble();
+    } else if (value.isString()) {
+        bool ok;
+        reading = value.toString().toDouble(&ok);
+        if (!ok) {
+            return std::nullopt;
+        }
+    } else {
+        return std::nullopt;
+    }
+    if (!std::isfinite(reading)) {
+        return std::nullopt;
+    }
+    return reading;
+}
+
+}
+
+
+MqttMeasurementHandler::MqttMeasurementHandler(std::shared_ptr<MeasurementBatcher> batcher)
+    : batcher_(batcher)
+{
+}
 
 
 void MqttMeasurementHandler::saveMeasurementToDatabase(const QByteArray& message)
 {
+    static MetricsRegistry::Counter &parsedMessages = MeasurementBatcher::stageCounter("parsed");
+    static MetricsRegistry::Counter &rejectedMessages = MeasurementBatcher::stageCounter("rejected");
+
     QJsonParseError parseError;
     QJsonDocument jsonDoc = QJsonDocument::fromJson(message, &parseError);
 
+    // A misbehaving device repeats the same mistake on every reading; a few lines a second say
+    // as much as all of them.
     if (parseError.error != QJsonParseError::NoError) {
-        Logger::instance().log("MQTT: Failed to parse JSON message: " + parseError.errorString(), Logger::LogLevel::Error);
+        rejectedMessages.increment();
+        static LogSite invalidJsonSite("mqtt.invalid_json", Logger::LogLevel::Error, {.maxPerSecond = 5});
+        if (invalidJsonSite.shouldLog()) {
+            LogEvent(invalidJsonSite)
+                .add("error", parseError.errorString())
+                .add("bytes", message.size())
+                .add("payload", QString::fromUtf8(message.left(200)))
+                .write();
+        }
         return;
     }
 
     QJsonObject jsonObj = jsonDoc.object();
 
     if (!jsonObj.contains("data") || !jsonObj.contains("sensor_id")) {
-        Logger::instance().log("MQTT: JSON message missing required fields (data, sensor_id).", Logger::LogLevel::Error);
+        rejectedMessages.increment();
+        static LogSite missingFieldsSite("mqtt.missing_fields", Logger::LogLevel::Error, {.maxPerSecond = 5});
+        if (missingFieldsSite.shouldLog()) {
+            LogEvent(missingFieldsSite)
+                .add("bytes", message.size())
+                .add("payload", QString::fromUtf8(message.left(200)))
+                .write();
+        }
         return;
     }
-    SensorRepository sensorRepository;
-    QByteArray data = QByteArray::number(jsonObj.value("data").toDouble());
-    qDebug() << data;
-    auto sensor = sensorRepository.getSensorById(jsonObj.value("sensor_id").toVariant().toLongLong());
 
-    if(!sensor) {
+    // Numbers or numeric strings, as devices have sent them so far.
+    std::optional<qint64> sensorId = parseSensorId(jsonObj.value("sensor_id"));
+    std::optional<double> value = parseReading(jsonObj.value("data"));
+    if (!sensorId || !value) {
+        rejectedMessages.increment();
+        static LogSite invalidFieldsSite("mqtt.invalid_fields", Logger::LogLevel::Error, {.maxPerSecond = 5});
+        if (invalidFieldsSite.shouldLog()) {
+            LogEvent(invalidFieldsSite)
+                .add("field", sensorId ? QStringView(u"data") : QStringView(u"sensor_id"))
+                .add("payload", QString::fromUtf8(message.left(200)))
+                .write();
+        }
         return;
     }
 
-    Measurement measurement (-1, data, QDateTime(), sensor.value());
-    if (measurementRepository_.createMeasurement(measurement.data(), sensor->id())) {
-        Logger::instance().log("MQTT: Measurement saved successfully.", Logger::LogLevel::Info);
-    } else {
-        Logger::instance().log("MQTT: Failed to save measurement to database.", Logger::LogLevel::Error);
-    }
+    parsedMessages.increment();
+    batcher_->enqueue(*sensorId, *value);
 }
@@ -3,16 +3,18 @@
 #include <qsqldatabase.h>
 #include <qsqlquery.h>
 #include <qmqtttopicname.h>
-#include "../repositories/measurementrepository.h"
+#include <memory>
+#include "../controllers/measurementbatcher.h"
 
 class MqttMeasurementHandler
 {
 public:
-    MqttMeasurementHandler();
+    explicit MqttMeasurementHandler(std::shared_ptr<MeasurementBatcher> batcher);
+    // Parses the payload and queues the reading; MeasurementBatcher writes it to the database.
     void saveMeasurementToDatabase(const QByteArray &message);
     // void handleMessage(const QByteArray &message, const QMqttTopicName &topic);
 private:
-    MeasurementRepository measurementRepository_;
+    std::shared_ptr<MeasurementBatcher> batcher_;
 };
 
 #endif // MQTTMEASUREMENTHANDLER_H
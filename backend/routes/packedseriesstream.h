@@ -0,0 +1,60 @@
+#ifndef PACKEDSERIESSTREAM_H
+#define PACKEDSERIESSTREAM_H
+
+#include <QByteArray>
+#include <functional>
+#include <memory>
+#include "../repositories/rowcursor.h"
+#include "../utils/jsonstreamdevice.h"
+#include "../utils/packedseries.h"
+
+// Packed counterpart of makeJsonListProducer: writes the header, then one batch of up to
+// batchRows rows per call, then the end marker. The trailer callback writes the complete
+// JSON trailer object and is told whether the cursor had more than maxRows rows.
+template <typename T>
+JsonStreamDevice::Producer makePackedSeriesProducer(std::shared_ptr<PackedSeriesWriter> writer,
+                                                    std::shared_ptr<RowCursor<T>> cursor,
+                                                    qint64 maxRows,
+                                                    std::function<void(PackedSeriesWriter&, const T&)> appendRow,
+                                                    std::function<void(QByteArray&, qint64 rows, bool hasMore)> writeTrailer)
+{
+    constexpr int batchRows = 1024;
+
+    struct State {
+        bool started = false;
+        qint64 rows = 0;
+    };
+    auto state = std::make_shared<State>();
+
+    return [writer, cursor, maxRows, appendRow, writeTrailer, state](QByteArray &out) {
+        if (!state->started) {
+            state->started = true;
+            writer->writeHeader(out);
+            return true;
+        }
+
+        bool cursorDone = false;
+        for (int i = 0; i < batchRows && state->rows < maxRows; ++i) {
+            auto row = cursor->next();
+            if (!row) {
+                cursorDone = true;
+                break;
+            }
+            appendRow(*writer, *row);
+            ++state->rows;
+        }
+
+        if (!cursorDone && state->rows < maxRows) {
+            writer->writeBatch(out);
+            return true;
+        }
+
+        bool hasMore = !cursorDone && cursor->next().has_value();
+        QByteArray trailer;
+        writeTrailer(trailer, state->rows, hasMore);
+        writer->writeEnd(out, trailer);
+        return false;
+    };
+}
+
+#endif // PACKEDSERIESSTREAM_H
@@ -7,9 +7,149 @@
 #include "userhandler.h"
 #include "backuphandler.h" // Include the new backup handler
 #include "../controllers/dbcontroller.h" // For passing to BackupHandler
+#include "../utils/logger.h"
+#include "../utils/metrics.h"
+#include "../repositories/slowquerylog.h"
+#include <QtConcurrent/QtConcurrentRun>
+#include <QElapsedTimer>
+#include <QThread>
 
-RouteFactory::RouteFactory(std::shared_ptr<QHttpServer> server, std::shared_ptr<DBController> dbcontroller)
-    : server_(server), dbcontroller_(dbcontroller) {}
+namespace {
+
+QByteArray methodName(QHttpServerRequest::Method method)
+{
+    switch (method) {
+    case QHttpServerRequest::Method::Get: return "GET";
+    case QHttpServerRequest::Method::Post: return "POST";
+    case QHttpServerRequest::Method::Put: return "PUT";
+    case QHttpServerRequest::Method::Patch: return "PATCH";
+    case QHttpServerRequest::Method::Delete: return "DELETE";
+    case QHttpServerRequest::Method::Head: return "HEAD";
+    case QHttpServerRequest::Method::Options: return "OPTIONS";
+    default: return "OTHER";
+    }
+}
+
+// Latency and per-status counts of one registered route. Status series are registered the
+// first time a code is seen and cached here, so recording never takes the registry lock twice.
+class RouteMetrics
+{
+public:
+    RouteMetrics(const QString &path, QHttpServerRequest::Method method)
+        : route_(path.toUtf8()), method_(methodName(method)),
+          latency_(MetricsRegistry::instance().histogram("arkanova_http_request_duration_seconds",
+                                                         "Time from routing a request to its response, by route.",
+                                                         {{"route", route_}, {"method", method_}}))
+    {
+        for (auto &counter : statusCounters_) {
+            counter.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    void record(qint64 elapsedNs, int statusCode)
+    {
+        latency_.observeNs(elapsedNs);
+        if (statusCode < 100 || statusCode >= int(statusCounters_.size())) {
+            return;
+        }
+        MetricsRegistry::Counter *counter = statusCounters_[statusCode].load(std::memory_order_acquire);
+        if (!counter) {
+            counter = &MetricsRegistry::instance().counter("arkanova_http_requests_total",
+                                                           "Requests answered, by route and status code.",
+                                                           {{"route", route_}, {"method", method_},
+                                                            {"code", QByteArray::number(statusCode)}});
+            statusCounters_[statusCode].store(counter, std::memory_order_release);
+        }
+        counter->increment();
+    }
+
+private:
+    QByteArray route_;
+    QByteArray method_;
+    MetricsRegistry::Histogram &latency_;
+    std::array<std::atomic<MetricsRegistry::Counter *>, 600> statusCounters_;
+};
+
+}
+
+RouteFactory::RouteFactory(std::shared_ptr<QHttpServer> server, std::shared_ptr<DBController> dbcontroller,
+                           ExecutionMode mode, int workerThreads, int streamThreads)
+    : dbcontroller_(dbcontroller), server_(server), mode_(mode)
+{
+    int dbPoolMax = DBController::pool().settings().maxSize;
+
+    // A stream holds its thread while the client reads, so streams get their own threads and
+    // cannot starve ordinary handlers; more concurrent streams queue here.
+    streamPool_ = std::make_shared<QThreadPool>();
+    streamPool_->setMaxThreadCount(streamThreads > 0 ? streamThreads : 2);
+    streamPool_->setExpiryTimeout(-1);
+
+    if (mode_ == ExecutionMode::WorkerPool) {
+        workerPool_ = std::make_shared<QThreadPool>();
+        workerPool_->setMaxThreadCount(workerThreads > 0 ? workerThreads : QThread::idealThreadCount());
+        // Keep workers alive so their pooled DB connections stay warm; the DB pool reaps idle ones.
+        workerPool_->setExpiryTimeout(-1);
+    }
+
+    int routeThreads = streamPool_->maxThreadCount() + (workerPool_ ? workerPool_->maxThreadCount() : 0);
+    if (dbPoolMax <= routeThreads) {
+        Logger::instance().log(QString("Route workers and stream workers (%1) >= database pool size (%2); handlers will wait for connections")
+                                   .arg(routeThreads).arg(dbPoolMax),
+                               Logger::LogLevel::Warning);
+    }
+}
+
+void RouteFactory::addRoute(const QString &path, QHttpServerRequest::Method method, Handler handler)
+{
+    auto metrics = std::make_shared<RouteMetrics>(path, method);
+
+    if (mode_ == ExecutionMode::Inline) {
+        server_->route(path, method, [handler, metrics](const QHttpServerRequest& request) {
+            QElapsedTimer timer;
+            timer.start();
+            HttpRequest snapshot(request);
+            ResponseFactory::RequestScope scope(snapshot);
+            QHttpServerResponse response = handler(snapshot);
+            metrics->record(timer.nsecsElapsed(), int(response.statusCode()));
+            return response;
+        });
+        return;
+    }
+
+    // The request is snapshotted on the main thread; the worker borrows its own DB connection.
+    // Latency includes the time spent waiting for a worker.
+    server_->route(path, method, [pool = workerPool_, handler, metrics](const QHttpServerRequest& request) {
+        QElapsedTimer timer;
+        timer.start();
+        return QtConcurrent::run(pool.get(), [handler, metrics, timer, snapshot = HttpRequest(request)]() {
+            ConnectionPool::Lease lease;
+            ResponseFactory::RequestScope scope(snapshot);
+            QHttpServerResponse response = handler(snapshot);
+            metrics->record(timer.nsecsElapsed(), int(response.statusCode()));
+            return response;
+        });
+    });
+}
+
+void RouteFactory::addStreamingRoute(const QString &path, QHttpServerRequest::Method method, StreamingHandler handler)
+{
+    auto metrics = std::make_shared<RouteMetrics>(path, method);
+
+    // The handler returns once the body is written, so latency covers the whole stream,
+    // including the time spent waiting for a stream worker.
+    server_->route(path, method, [pool = streamPool_, handler, metrics](const QHttpServerRequest& request,
+                                                                         QHttpServerResponder&& responder) {
+        QElapsedTimer timer;
+        timer.start();
+        auto streamResponder = std::make_shared<StreamResponder>(std::move(responder));
+        pool->start([handler, metrics, timer, streamResponder, snapshot = HttpRequest(request)]() {
+            ConnectionPool::Lease lease;
+            ResponseFactory::RequestScope scope(snapshot);
+            handler(snapshot, *streamResponder);
+            metrics->record(timer.nsecsElapsed(), scope.statusCode());
+        });
+    });
+}
 
 void RouteFactory::registerAllRoutes()
 {
@@ -19,6 +159,7 @@ void RouteFactory::registerAllRoutes()
     setupSolarPanelRoutes();
     setupMeasurementRoutes();
     setupBackupRoutes();
+    setupMetricsRoutes();
 }
 
 void RouteFactory::setupUserRoutes() {
@@ -29,97 +170,101 @@ void RouteFactory::setupUserRoutes() {
     // std::make_shared or member variable is safer.
     auto userHandler = std::make_shared<UserHandler>(); // Manage lifetime
 
-    server_->route("/api/users/list", QHttpServerRequest::Method::Get,
-                   [userHandler](const QHttpServerRequest& request) {
-                       return userHandler->getUserList(request);
-                   });
-
-    server_->route("/api/users", QHttpServerRequest::Method::Get,
-                   [userHandler](const QHttpServerRequest& request) { // Changed from /api/user to /api/users
-                       return userHandler->getUser(request);
-                   });
-    server_->route("/api/users", QHttpServerRequest::Method::Patch, // Changed from /api/user
-                   [userHandler](const QHttpServerRequest& request){
-                       return userHandler->updateUser(request);
-                   });
-    server_->route("/api/users", QHttpServerRequest::Method::Delete, // Changed from /api/user
-                   [userHandler](const QHttpServerRequest& request){
-                       return userHandler->deleteUser(request);
-                   });
-    server_->route("/api/users/register", QHttpServerRequest::Method::Post,
-                   [userHandler](const QHttpServerRequest& request){
-                       return userHandler->registerUser(request);
-                   });
-    server_->route("/api/users/login", QHttpServerRequest::Method::Post,
-                   [userHandler](const QHttpServerRequest& request){
-                       return userHandler->loginUser(request);
-                   });
+    addStreamingRoute("/api/users/list", QHttpServerRequest::Method::Get,
+                      [userHandler](const HttpRequest& request, StreamResponder& responder) {
+                          userHandler->getUserList(request, responder);
+                      });
+
+    addRoute("/api/users", QHttpServerRequest::Method::Get,
+             [userHandler](const HttpRequest& request) { // Changed from /api/user to /api/users
+                 return userHandler->getUser(request);
+             });
+    addRoute("/api/users", QHttpServerRequest::Method::Patch, // Changed from /api/user
+             [userHandler](const HttpRequest& request){
+                 return userHandler->updateUser(request);
+             });
+    addRoute("/api/users", QHttpServerRequest::Method::Delete, // Changed from /api/user
+             [userHandler](const HttpRequest& request){
+                 return userHandler->deleteUser(request);
+             });
+    addRoute("/api/users/register", QHttpServerRequest::Method::Post,
+             [userHandler](const HttpRequest& request){
+                 return userHandler->registerUser(request);
+             });
+    addRoute("/api/users/login", QHttpServerRequest::Method::Post,
+             [userHandler](const HttpRequest& request){
+                 return userHandler->loginUser(request);
+             });
 }
 
 void RouteFactory::setupSensorRoutes() {
     if (!server_) return;
     auto sensorHandler = std::make_shared<SensorHandler>();
 
-    server_->route("/api/sensor", QHttpServerRequest::Method::Get,
-                   [sensorHandler](const QHttpServerRequest& request) {
-                       return sensorHandler->getSensor(request);
-                   });
-    server_->route("/api/sensor/list/solarpanel", QHttpServerRequest::Method::Get,
-                   [sensorHandler](const QHttpServerRequest& request) {
-                       return sensorHandler->getSensorList(request);
-                   });
-    server_->route("/api/sensor", QHttpServerRequest::Method::Delete,
-                   [sensorHandler](const QHttpServerRequest& request) {
-                       return sensorHandler->deleteSensor(request);
-                   });
-    server_->route("/api/sensor", QHttpServerRequest::Method::Post,
-                   [sensorHandler](const QHttpServerRequest& request) {
-                       return sensorHandler->createSensor(request);
-                   });
+    addRoute("/api/sensor", QHttpServerRequest::Method::Get,
+             [sensorHandler](const HttpRequest& request) {
+                 return sensorHandler->getSensor(request);
+             });
+    addStreamingRoute("/api/sensor/list/solarpanel", QHttpServerRequest::Method::Get,
+                      [sensorHandler](const HttpRequest& request, StreamResponder& responder) {
+                          sensorHandler->getSensorList(request, responder);
+                      });
+    addRoute("/api/sensor", QHttpServerRequest::Method::Delete,
+             [sensorHandler](const HttpRequest& request) {
+                 return sensorHandler->deleteSensor(request);
+             });
+    addRoute("/api/sensor", QHttpServerRequest::Method::Post,
+             [sensorHandler](const HttpRequest& request) {
+                 return sensorHandler->createSensor(request);
+             });
 }
 
 void RouteFactory::setupSolarPanelRoutes() {
     if (!server_) return;
     auto solarPanelHandler = std::make_shared<SolarPanelHandler>();
 
-    server_->route("/api/solarpanel", QHttpServerRequest::Method::Get,
-                   [solarPanelHandler](const QHttpServerRequest& request) {
-                       return solarPanelHandler->getSolarPanel(request);
-                   });
-    server_->route("/api/solarpanel/list/user", QHttpServerRequest::Method::Get,
-                   [solarPanelHandler](const QHttpServerRequest& request) {
-                       return solarPanelHandler->getSolarPanelListByUser(request);
-                   });
-    server_->route("/api/solarpanel", QHttpServerRequest::Method::Patch,
-                   [solarPanelHandler](const QHttpServerRequest& request) {
-                       return solarPanelHandler->updateSolarPanel(request);
-                   });
-    server_->route("/api/solarpanel", QHttpServerRequest::Method::Delete,
-                   [solarPanelHandler](const QHttpServerRequest& request) {
-                       return solarPanelHandler->deleteSolarPanel(request);
-                   });
-    server_->route("/api/solarpanel", QHttpServerRequest::Method::Post,
-                   [solarPanelHandler](const QHttpServerRequest& request) {
-                       return solarPanelHandler->createSolarPanel(request);
-                   });
+    addRoute("/api/solarpanel", QHttpServerRequest::Method::Get,
+             [solarPanelHandler](const HttpRequest& request) {
+                 return solarPanelHandler->getSolarPanel(request);
+             });
+    addRoute("/api/solarpanel/list/user", QHttpServerRequest::Method::Get,
+             [solarPanelHandler](const HttpRequest& request) {
+                 return solarPanelHandler->getSolarPanelListByUser(request);
+             });
+    addRoute("/api/solarpanel", QHttpServerRequest::Method::Patch,
+             [solarPanelHandler](const HttpRequest& request) {
+                 return solarPanelHandler->updateSolarPanel(request);
+             });
+    addRoute("/api/solarpanel", QHttpServerRequest::Method::Delete,
+             [solarPanelHandler](const HttpRequest& request) {
+                 return solarPanelHandler->deleteSolarPanel(request);
+             });
+    addRoute("/api/solarpanel", QHttpServerRequest::Method::Post,
+             [solarPanelHandler](const HttpRequest& request) {
+                 return solarPanelHandler->createSolarPanel(request);
+             });
 }
 
 void RouteFactory::setupMeasurementRoutes() {
     if (!server_) return;
     auto measurementHandler = std::make_shared<MeasurementHandler>();
 
-    server_->route("/api/measurement", QHttpServerRequest::Method::Get,
-                   [measurementHandler](const QHttpServerRequest& request) {
-                       return measurementHandler->getMeasurementById(request);
-                   });
-    server_->route("/api/measurement/list/sensor", QHttpServerRequest::Method::Get,
-                   [measurementHandler](const QHttpServerRequest& request) {
-                       return measurementHandler->getMeasurementsBySensor(request);
-                   });
-    server_->route("/api/measurement/latest/sensor", QHttpServerRequest::Method::Get,
-                   [measurementHandler](const QHttpServerRequest& request) {
-                       return measurementHandler->getLatestMeasurementBySensor(request);
-                   });
+    addRoute("/api/measurement", QHttpServerRequest::Method::Get,
+             [measurementHandler](const HttpRequest& request) {
+                 return measurementHandler->getMeasurementById(request);
+             });
+    addStreamingRoute("/api/measurement/list/sensor", QHttpServerRequest::Method::Get,
+                      [measurementHandler](const HttpRequest& request, StreamResponder& responder) {
+                          measurementHandler->getMeasurementsBySensor(request, responder);
+                      });
+    addRoute("/api/measurement/latest/sensor", QHttpServerRequest::Method::Get,
+             [measurementHandler](const HttpRequest& request) {
+                 return measurementHandler->getLatestMeasurementBySensor(request);
+             });
+    addRoute("/api/measurement/aggregate/sensor", QHttpServerRequest::Method::Get,
+             [measurementHandler](const HttpRequest& request) {
+                 return measurementHandler->getAggregatedMeasurementsBySensor(request);
+             });
 }
 
 
@@ -131,15 +276,39 @@ void RouteFactory::setupBackupRoutes() {
     // BackupHandler needs the DBController for transactions
     auto backupHandler = std::make_shared<BackupHandler>(dbcontroller_);
 
-    server_->route("/api/admin/backup/export", QHttpServerRequest::Method::Get,
-                   [backupHandler](const QHttpServerRequest& request) {
-                       return backupHandler->exportDatabase(request);
-                   });
+    addRoute("/api/admin/backup/export", QHttpServerRequest::Method::Get,
+             [backupHandler](const HttpRequest& request) {
+                 return backupHandler->exportDatabase(request);
+             });
+
+    addRoute("/api/admin/backup/import", QHttpServerRequest::Method::Post,
+             [backupHandler](const HttpRequest& request) {
+                 return backupHandler->importDatabase(request);
+             });
+}
+
+void RouteFactory::setupMetricsRoutes() {
+    if (!server_) return;
+
+    addRoute("/metrics", QHttpServerRequest::Method::Get,
+             [](const HttpRequest&) {
+                 return ResponseFactory::createBinaryResponse(MetricsRegistry::instance().scrape(),
+                                                              "text/plain; version=0.0.4; charset=utf-8",
+                                                              QHttpServerResponse::StatusCode::Ok);
+             });
+
+    addRoute("/api/admin/slow-queries", QHttpServerRequest::Method::Get,
+             [](const HttpRequest&) {
+                 return ResponseFactory::createJsonResponse(SlowQueryLog::instance().toJson(),
+                                                            QHttpServerResponse::StatusCode::Ok);
+             });
 
-    server_->route("/api/admin/backup/import", QHttpServerRequest::Method::Post,
-                   [backupHandler](const QHttpServerRequest& request) {
-                       return backupHandler->importDatabase(request);
-                   });
+    addRoute("/api/admin/slow-queries", QHttpServerRequest::Method::Delete,
+             [](const HttpRequest&) {
+                 SlowQueryLog::instance().clear();
+                 return ResponseFactory::createJsonResponse(SlowQueryLog::instance().toJson(),
+                                                            QHttpServerResponse::StatusCode::Ok);
+             });
 }
 
 void RouteFactory::handleOptionsRequest()
@@ -1,25 +1,49 @@
 #ifndef ROUTEFACTORY_H
 #define ROUTEFACTORY_H
 #include <QtHttpServer/QHttpServer>
+#include <QThreadPool>
+#include <functional>
 #include "../controllers/dbcontroller.h"
+#include "../utils/httprequest.h"
+#include "../utils/streamresponder.h"
 
 
 class RouteFactory
 {
 public:
-    explicit RouteFactory(std::shared_ptr<QHttpServer> server, std::shared_ptr<DBController> dbcontroller);
+    // Inline runs handlers on the QCoreApplication thread; WorkerPool hands them to a
+    // bounded QThreadPool and leaves the main loop free for accepting connections.
+    enum class ExecutionMode { Inline, WorkerPool };
+
+    // Streaming routes run on their own pool of streamThreads in either mode.
+    explicit RouteFactory(std::shared_ptr<QHttpServer> server, std::shared_ptr<DBController> dbcontroller,
+                          ExecutionMode mode = ExecutionMode::Inline, int workerThreads = 0, int streamThreads = 0);
 
     void registerAllRoutes();
 
     void setupBackupRoutes();
 private:
+    using Handler = std::function<QHttpServerResponse(const HttpRequest&)>;
+    using StreamingHandler = std::function<void(const HttpRequest&, StreamResponder&)>;
+
     std::shared_ptr<DBController> dbcontroller_;
     std::shared_ptr<QHttpServer> server_;
+    ExecutionMode mode_;
+    std::shared_ptr<QThreadPool> workerPool_;
+    std::shared_ptr<QThreadPool> streamPool_;
+
+    void addRoute(const QString& path, QHttpServerRequest::Method method, Handler handler);
+    // Streaming handlers run on streamPool_ with their own DB connection, which they keep until
+    // the body is written: the cursor behind a stream stays on the thread that opened it, and
+    // the body is still produced as the socket drains (see StreamResponder).
+    void addStreamingRoute(const QString& path, QHttpServerRequest::Method method, StreamingHandler handler);
 
     void setupUserRoutes();
     void setupSensorRoutes();
     void setupSolarPanelRoutes();
     void setupMeasurementRoutes();
+    // Prometheus text exposition of MetricsRegistry, and the slow-query log.
+    void setupMetricsRoutes();
 
     void handleOptionsRequest();
 
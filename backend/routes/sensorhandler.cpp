@@ -1,9 +1,11 @@
 #include "sensorhandler.h"
 #include "../utils/responsefactory.h"
+#include "jsonliststream.h"
+#include <limits>
 
 SensorHandler::SensorHandler() : sensorRepository_(std::make_shared<SensorRepository>()) {}
 
-QHttpServerResponse SensorHandler::getSensor(const QHttpServerRequest& request) {
+QHttpServerResponse SensorHandler::getSensor(const HttpRequest& request) {
     bool ok;
     qint64 sensorId = request.query().queryItemValue("id").toLongLong(&ok);
 
@@ -21,28 +23,46 @@ QHttpServerResponse SensorHandler::getSensor(const QHttpServerRequest& request)
                                                QHttpServerResponse::StatusCode::NotFound);
 }
 
-QHttpServerResponse SensorHandler::getSensorList(const QHttpServerRequest& request) {
+void SensorHandler::getSensorList(const HttpRequest& request, StreamResponder& responder) {
     bool ok;
     qint64 sensorId = request.query().queryItemValue("panel_id").toLongLong(&ok);
 
     if (!ok) {
-        return ResponseFactory::createResponse("Sensor id is missing or invalid.",
-                                               QHttpServerResponse::StatusCode::BadRequest);
+        responder.sendResponse(ResponseFactory::createResponse("Sensor id is missing or invalid.",
+                                                               QHttpServerResponse::StatusCode::BadRequest));
+        return;
     }
 
-    auto sensors = sensorRepository_->getSensorsByPanelId(sensorId);
-    QJsonArray sensorArray;
-    for (const auto& sensor : sensors) {
-        sensorArray.append(sensor.toJson());
+    // Polls of an unchanged panel are answered from the version stamp alone.
+    QByteArray etag;
+    if (auto version = sensorRepository_->getSensorsVersionByPanelId(sensorId)) {
+        etag = ResponseFactory::entityTag("s" + *version);
+        if (ResponseFactory::isNotModified(request, etag)) {
+            responder.sendResponse(ResponseFactory::createNotModifiedResponse(etag));
+            return;
+        }
     }
-    QJsonObject response;
-    response["sensors"] = sensorArray;
-    response["total_count"] = 100;
-    return ResponseFactory::createJsonResponse(QJsonDocument(response).toJson(),
-                                               QHttpServerResponse::StatusCode::Ok);
+
+    auto cursor = std::make_shared<RowCursor<Sensor>>(sensorRepository_->openSensorsByPanelId(sensorId));
+    if (!cursor->isValid()) {
+        responder.sendResponse(ResponseFactory::createErrorResponse("Failed to read sensors.",
+                                                                    QHttpServerResponse::StatusCode::InternalServerError));
+        return;
+    }
+
+    ResponseFactory::streamJsonResponse(
+        responder,
+        makeJsonListProducer<Sensor>("sensors", cursor, std::numeric_limits<qint64>::max(),
+                                     [](QByteArray& out, const Sensor& sensor) {
+                                         sensor.writeJson(out);
+                                     },
+                                     [](QByteArray& out, qint64 rows, bool) {
+                                         out.append(",\"total_count\":").append(QByteArray::number(rows));
+                                     }),
+        QHttpServerResponse::StatusCode::Ok, etag);
 }
 
-QHttpServerResponse SensorHandler::deleteSensor(const QHttpServerRequest& request) {
+QHttpServerResponse SensorHandler::deleteSensor(const HttpRequest& request) {
     bool ok;
     qint64 sensorId = request.query().queryItemValue("id").toLongLong(&ok);
 
@@ -59,7 +79,7 @@ QHttpServerResponse SensorHandler::deleteSensor(const QHttpServerRequest& reques
                                                QHttpServerResponse::StatusCode::NotFound);
 }
 
-QHttpServerResponse SensorHandler::createSensor(const QHttpServerRequest& request) {
+QHttpServerResponse SensorHandler::createSensor(const HttpRequest& request) {
     QJsonParseError err;
     const auto json = QJsonDocument::fromJson(request.body(), &err).object();
 
@@ -1,18 +1,19 @@
 #ifndef SENSORHANDLER_H
 #define SENSORHANDLER_H
 
-#include <qhttpserverrequest.h>
+#include "../utils/httprequest.h"
 #include <qhttpserverresponse.h>
+#include "../utils/streamresponder.h"
 #include "../repositories/sensorrepository.h"
 #include "../repositories/solarpanelrepository.h"
 class SensorHandler {
 public:
     SensorHandler();
 
-    QHttpServerResponse getSensor(const QHttpServerRequest& request);
-    QHttpServerResponse getSensorList(const QHttpServerRequest& request);
-    QHttpServerResponse deleteSensor(const QHttpServerRequest& request);
-    QHttpServerResponse createSensor(const QHttpServerRequest& request);
+    QHttpServerResponse getSensor(const HttpRequest& request);
+    void getSensorList(const HttpRequest& request, StreamResponder& responder);
+    QHttpServerResponse deleteSensor(const HttpRequest& request);
+    QHttpServerResponse createSensor(const HttpRequest& request);
 
 private:
     std::shared_ptr<SensorRepository> sensorRepository_;
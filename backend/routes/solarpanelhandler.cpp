@@ -1,7 +1,8 @@
 #include "solarpanelhandler.h"
 #include "../utils/responsefactory.h" // Assuming ResponseFactory is in this path or similar
 #include "../models/user.h"    // Assuming User model is in this path
-#include <qhttpserverrequest.h>
+#include "../utils/httprequest.h"
+#include "../utils/jsonwriter.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -13,7 +14,7 @@
 SolarPanelHandler::SolarPanelHandler()
     : solarPanelRepository_(std::make_shared<SolarPanelRepository>()) {}
 
-QHttpServerResponse SolarPanelHandler::getSolarPanel(const QHttpServerRequest& request) {
+QHttpServerResponse SolarPanelHandler::getSolarPanel(const HttpRequest& request) {
     bool ok;
     qint64 panelId = request.query().queryItemValue("id").toLongLong(&ok);
 
@@ -30,7 +31,7 @@ QHttpServerResponse SolarPanelHandler::getSolarPanel(const QHttpServerRequest& r
     return ResponseFactory::createResponse("Solar panel not found.", QHttpServerResponse::StatusCode::NotFound);
 }
 
-QHttpServerResponse SolarPanelHandler::getSolarPanelListByUser(const QHttpServerRequest& request) {
+QHttpServerResponse SolarPanelHandler::getSolarPanelListByUser(const HttpRequest& request) {
     bool okUserId;
     int userId = request.query().queryItemValue("user_id").toInt(&okUserId);
 
@@ -48,19 +49,36 @@ QHttpServerResponse SolarPanelHandler::getSolarPanelListByUser(const QHttpServer
     if (!okLimit || limit <= 0) limit = 25; // Default to 25 if missing, invalid, or non-positive
 
 
+    // Polls of an unchanged panel list are answered from the version stamp alone.
+    QByteArray etag;
+    if (auto version = solarPanelRepository_->getPanelsVersionByUser(userId)) {
+        etag = ResponseFactory::entityTag("p" + *version);
+        if (ResponseFactory::isNotModified(request, etag)) {
+            return ResponseFactory::createNotModifiedResponse(etag);
+        }
+    }
+
     auto panels = solarPanelRepository_->getPanelsByUser(userId, page, limit);
-    QJsonArray panelArray;
-    for (const auto& panel : panels) {
-        panelArray.append(panel.toJson());
+    QByteArray response;
+    response.reserve(64 + panels.size() * 128);
+    response.append("{\"panels\":[");
+    for (qsizetype i = 0; i < panels.size(); ++i) {
+        if (i > 0) {
+            response.append(',');
+        }
+        panels.at(i).writeJson(response);
     }
-    QJsonObject response;
-    response["panels"] = panelArray;
+    response.append(']');
     // TODO: Replace hardcoded total_count with actual count from repository for proper pagination
-    response["total_count"] = 100; // This is hardcoded
-    return ResponseFactory::createJsonResponse(QJsonDocument(response).toJson(), QHttpServerResponse::StatusCode::Ok);
+    JsonWriter::appendKey(response, "total_count");
+    JsonWriter::appendInt(response, 100); // This is hardcoded
+    response.append('}');
+    auto httpResponse = ResponseFactory::createJsonResponse(response, QHttpServerResponse::StatusCode::Ok);
+    ResponseFactory::setEntityTag(httpResponse, etag);
+    return httpResponse;
 }
 
-QHttpServerResponse SolarPanelHandler::createSolarPanel(const QHttpServerRequest& request) {
+QHttpServerResponse SolarPanelHandler::createSolarPanel(const HttpRequest& request) {
     QJsonParseError err;
     QJsonDocument doc = QJsonDocument::fromJson(request.body(), &err);
 
@@ -105,7 +123,7 @@ QHttpServerResponse SolarPanelHandler::createSolarPanel(const QHttpServerRequest
     return ResponseFactory::createResponse("Failed to create solar panel.", QHttpServerResponse::StatusCode::InternalServerError);
 }
 
-QHttpServerResponse SolarPanelHandler::updateSolarPanel(const QHttpServerRequest& request) {
+QHttpServerResponse SolarPanelHandler::updateSolarPanel(const HttpRequest& request) {
     bool ok;
     qint64 id = request.query().queryItemValue("id").toLongLong(&ok);
 
@@ -170,7 +188,7 @@ QHttpServerResponse SolarPanelHandler::updateSolarPanel(const QHttpServerRequest
     return ResponseFactory::createResponse("Failed to update solar panel.", QHttpServerResponse::StatusCode::InternalServerError);
 }
 
-QHttpServerResponse SolarPanelHandler::deleteSolarPanel(const QHttpServerRequest& request) {
+QHttpServerResponse SolarPanelHandler::deleteSolarPanel(const HttpRequest& request) {
     bool ok;
     qint64 panelId = request.query().queryItemValue("id").toLongLong(&ok);
 
@@ -3,17 +3,18 @@
 
 #include "../repositories/solarpanelrepository.h"
 #include "../utils/responsefactory.h"
+#include "../utils/httprequest.h"
 
 class SolarPanelHandler
 {
 public:
     SolarPanelHandler();
 
-    QHttpServerResponse getSolarPanel(const QHttpServerRequest& request);
-    QHttpServerResponse getSolarPanelListByUser(const QHttpServerRequest& request);
-    QHttpServerResponse createSolarPanel(const QHttpServerRequest& request);
-    QHttpServerResponse updateSolarPanel(const QHttpServerRequest& request);
-    QHttpServerResponse deleteSolarPanel(const QHttpServerRequest& request);
+    QHttpServerResponse getSolarPanel(const HttpRequest& request);
+    QHttpServerResponse getSolarPanelListByUser(const HttpRequest& request);
+    QHttpServerResponse createSolarPanel(const HttpRequest& request);
+    QHttpServerResponse updateSolarPanel(const HttpRequest& request);
+    QHttpServerResponse deleteSolarPanel(const HttpRequest& request);
 
 private:
     std::shared_ptr<SolarPanelRepository> solarPanelRepository_;
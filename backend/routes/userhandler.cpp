@@ -1,7 +1,7 @@
 #include "userhandler.h"
 #include "../utils/responsefactory.h" // Ensure this path is correct
+#include "jsonliststream.h"
 #include "../models/user.h"           // Ensure this path is correct
-#include <QHttpServerRequest>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>     // Required for QJsonArray
@@ -13,7 +13,7 @@
 UserHandler::UserHandler() : userRepository_(std::make_shared<UserRepository>()) {}
 
 // Get a single user by ID
-QHttpServerResponse UserHandler::getUser(const QHttpServerRequest& request) {
+QHttpServerResponse UserHandler::getUser(const HttpRequest& request) {
     bool ok;
     // Corrected: Use QUrlQuery to parse query parameters
     QUrlQuery queryParams(request.url().query());
@@ -33,7 +33,7 @@ QHttpServerResponse UserHandler::getUser(const QHttpServerRequest& request) {
 }
 
 // Update an existing user
-QHttpServerResponse UserHandler::updateUser(const QHttpServerRequest& request) {
+QHttpServerResponse UserHandler::updateUser(const HttpRequest& request) {
     bool ok;
     // Corrected: Use QUrlQuery to parse query parameters
     QUrlQuery queryParams(request.url().query());
@@ -94,7 +94,7 @@ QHttpServerResponse UserHandler::updateUser(const QHttpServerRequest& request) {
 }
 
 // Delete a user
-QHttpServerResponse UserHandler::deleteUser(const QHttpServerRequest& request) {
+QHttpServerResponse UserHandler::deleteUser(const HttpRequest& request) {
     bool ok;
     // Corrected: Use QUrlQuery to parse query parameters
     QUrlQuery queryParams(request.url().query());
@@ -116,7 +116,7 @@ QHttpServerResponse UserHandler::deleteUser(const QHttpServerRequest& request) {
 }
 
 // Register a new user
-QHttpServerResponse UserHandler::registerUser(const QHttpServerRequest& request) {
+QHttpServerResponse UserHandler::registerUser(const HttpRequest& request) {
     QJsonParseError err;
     QJsonDocument doc = QJsonDocument::fromJson(request.body(), &err);
 
@@ -153,7 +153,7 @@ QHttpServerResponse UserHandler::registerUser(const QHttpServerRequest& request)
 }
 
 // Login a user
-QHttpServerResponse UserHandler::loginUser(const QHttpServerRequest& request) {
+QHttpServerResponse UserHandler::loginUser(const HttpRequest& request) {
     QJsonParseError err;
     QJsonDocument doc = QJsonDocument::fromJson(request.body(), &err);
 
@@ -187,7 +187,7 @@ QHttpServerResponse UserHandler::loginUser(const QHttpServerRequest& request) {
 }
 
 // New method implementation for listing users
-QHttpServerResponse UserHandler::getUserList(const QHttpServerRequest& request) {
+void UserHandler::getUserList(const HttpRequest& request, StreamResponder& responder) {
     QUrlQuery queryParams(request.url().query()); // This was already correct
     bool pageOk, limitOk;
     int page = queryParams.queryItemValue("page").toInt(&pageOk);
@@ -203,21 +203,26 @@ QHttpServerResponse UserHandler::getUserList(const QHttpServerRequest& request)
         limit = 100;
     }
 
-    QList<User> users = userRepository_->getUsers(page, limit);
+    // Counted before the cursor opens so the count does not interrupt the streamed query.
     int totalCount = userRepository_->getTotalUserCount();
-
-    QJsonArray usersArray;
-    for (const User& user : users) {
-        usersArray.append(user.toJson());
-    }
-
-    QJsonObject responseObject;
-    responseObject["users"] = usersArray;
-    responseObject["total_count"] = totalCount;
-    responseObject["page"] = page;
-    responseObject["limit"] = limit;
-    responseObject["total_pages"] = (totalCount + limit - 1) / limit; // Calculate total pages
-
-    return ResponseFactory::createJsonResponse(QJsonDocument(responseObject).toJson(QJsonDocument::Compact),
-                                               QHttpServerResponse::StatusCode::Ok);
+    auto cursor = std::make_shared<RowCursor<User>>(userRepository_->openUsers(page, limit));
+    if (!cursor->isValid()) {
+        responder.sendResponse(ResponseFactory::createErrorResponse("Failed to read users.",
+                                                                    QHttpServerResponse::StatusCode::InternalServerError));
+        return;
+    }
+
+    ResponseFactory::streamJsonResponse(
+        responder,
+        makeJsonListProducer<User>("users", cursor, limit,
+                                   [](QByteArray& out, const User& user) {
+                                       user.writeJson(out);
+                                   },
+                                   [totalCount, page, limit](QByteArray& out, qint64, bool) {
+                                       out.append(",\"total_count\":").append(QByteArray::number(totalCount))
+                                           .append(",\"page\":").append(QByteArray::number(page))
+                                           .append(",\"limit\":").append(QByteArray::number(limit))
+                                           .append(",\"total_pages\":").append(QByteArray::number((totalCount + limit - 1) / limit));
+                                   }),
+        QHttpServerResponse::StatusCode::Ok);
 }
@@ -2,7 +2,8 @@
 #define USERHANDLER_H
 
 #include <QHttpServerResponse> // Correct include
-#include <QHttpServerRequest>  // Required for request parameter
+#include "../utils/streamresponder.h"
+#include "../utils/httprequest.h" // Required for request parameter
 #include "../repositories/userrepository.h" // Ensure path is correct
 #include <memory> // Required for std::shared_ptr
 
@@ -10,14 +11,14 @@ class UserHandler
 {
 public:
     UserHandler();
-    QHttpServerResponse getUser(const QHttpServerRequest& request);
-    QHttpServerResponse updateUser(const QHttpServerRequest& request);
-    QHttpServerResponse deleteUser(const QHttpServerRequest& request);
-    QHttpServerResponse registerUser(const QHttpServerRequest& request);
-    QHttpServerResponse loginUser(const QHttpServerRequest& request);
+    QHttpServerResponse getUser(const HttpRequest& request);
+    QHttpServerResponse updateUser(const HttpRequest& request);
+    QHttpServerResponse deleteUser(const HttpRequest& request);
+    QHttpServerResponse registerUser(const HttpRequest& request);
+    QHttpServerResponse loginUser(const HttpRequest& request);
 
     // New method for listing users
-    QHttpServerResponse getUserList(const QHttpServerRequest& request);
+    void getUserList(const HttpRequest& request, StreamResponder& responder);
 
 private:
     std::shared_ptr<UserRepository> userRepository_;
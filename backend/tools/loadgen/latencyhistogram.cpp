@@ -0,0 +1,88 @@
+#include "latencyhistogram.h"
+#include <bit>
+
+namespace {
+
+constexpr int linearBuckets = 256;
+constexpr int subBuckets = 128;
+constexpr int maxBits = 37;
+constexpr qint64 maxMicros = (qint64(1) << maxBits) - 1;
+constexpr int bucketCount = linearBuckets + (maxBits - 8) * subBuckets;
+
+}
+
+LatencyHistogram::LatencyHistogram()
+    : buckets_(bucketCount, 0)
+{
+}
+
+void LatencyHistogram::record(qint64 micros)
+{
+    micros = qBound(qint64(0), micros, maxMicros);
+    ++buckets_[bucketOf(micros)];
+    ++count_;
+    max_ = qMax(max_, micros);
+    sum_ += double(micros);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < bucketCount; ++i) {
+        buckets_[i] += other.buckets_.at(i);
+    }
+    count_ += other.count_;
+    max_ = qMax(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+qint64 LatencyHistogram::count() const
+{
+    return count_;
+}
+
+qint64 LatencyHistogram::max() const
+{
+    return max_;
+}
+
+double LatencyHistogram::mean() const
+{
+    return count_ > 0 ? sum_ / double(count_) : 0;
+}
+
+qint64 LatencyHistogram::percentile(double q) const
+{
+    if (count_ == 0) {
+        return 0;
+    }
+    // The rank of the sample at q, counting from 1, so that p100 is the last one.
+    qint64 rank = qMax(qint64(1), qint64(q * double(count_) + 0.5));
+    qint64 seen = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        seen += buckets_.at(i);
+        if (seen >= rank) {
+            return qMin(upperBoundOf(i), max_);
+        }
+    }
+    return max_;
+}
+
+int LatencyHistogram::bucketOf(qint64 micros)
+{
+    if (micros < linearBuckets) {
+        return int(micros);
+    }
+    // Keep the top 8 bits: micros >> shift falls in [128, 256).
+    int shift = std::bit_width(quint64(micros)) - 8;
+    return linearBuckets + (shift - 1) * subBuckets + int(micros >> shift) - subBuckets;
+}
+
+qint64 LatencyHistogram::upperBoundOf(int bucket)
+{
+    if (bucket < linearBuckets) {
+        return bucket;
+    }
+    int shift = (bucket - linearBuckets) / subBuckets + 1;
+    qint64 top = (bucket - linearBuckets) % subBuckets + subBuckets;
+    return ((top + 1) << shift) - 1;
+}
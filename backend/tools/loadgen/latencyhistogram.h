@@ -0,0 +1,33 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QList>
+#include <QtGlobal>
+
+// Microsecond latencies in log-linear buckets: exact below 256 µs, within 1/128 of the value
+// above, up to about 38 hours. Percentiles are read back as the upper bound of their bucket.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(qint64 micros);
+    void merge(const LatencyHistogram &other);
+
+    qint64 count() const;
+    qint64 max() const;
+    double mean() const;
+    // q in [0, 1]; 0 when nothing was recorded.
+    qint64 percentile(double q) const;
+
+private:
+    static int bucketOf(qint64 micros);
+    static qint64 upperBoundOf(int bucket);
+
+    QList<qint64> buckets_;
+    qint64 count_ = 0;
+    qint64 max_ = 0;
+    double sum_ = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
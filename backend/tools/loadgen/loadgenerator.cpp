@@ -0,0 +1,410 @@
+#include "loadgenerator.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkReply>
+#include <QUrlQuery>
+
+namespace {
+
+// QNetworkAccessManager opens at most this many HTTP/1.1 connections per host.
+constexpr int connectionsPerManager = 6;
+constexpr qint64 lateSendNs = 10'000'000;
+
+double toMs(qint64 micros)
+{
+    return double(micros) / 1000.0;
+}
+
+QJsonObject histogramJson(const LatencyHistogram &histogram)
+{
+    QJsonObject json;
+    json["p50"] = toMs(histogram.percentile(0.50));
+    json["p95"] = toMs(histogram.percentile(0.95));
+    json["p99"] = toMs(histogram.percentile(0.99));
+    json["p999"] = toMs(histogram.percentile(0.999));
+    json["max"] = toMs(histogram.max());
+    json["mean"] = histogram.mean() / 1000.0;
+    return json;
+}
+
+QList<qint64> idsOf(const QJsonArray &array)
+{
+    QList<qint64> ids;
+    for (const QJsonValue &value : array) {
+        ids.append(value.toObject().value("id").toInteger());
+    }
+    return ids;
+}
+
+}
+
+LoadGenerator::LoadGenerator(const Scenario &scenario, const Settings &settings, QObject *parent)
+    : QObject(parent)
+    , scenario_(scenario)
+    , settings_(settings)
+    , random_(settings.seed != 0 ? settings.seed : QRandomGenerator::global()->generate())
+{
+    int managers = qMax(1, (settings_.connections + connectionsPerManager - 1) / connectionsPerManager);
+    for (int i = 0; i < managers; ++i) {
+        managers_.append(std::make_shared<QNetworkAccessManager>());
+    }
+    for (const Scenario::Weighted &entry : scenario_.mix) {
+        mixWeights_.append(entry.weight);
+    }
+    for (const Scenario::RangeWidth &width : scenario_.rangeWidths) {
+        widthWeights_.append(width.weight);
+    }
+
+    tickTimer_.setTimerType(Qt::PreciseTimer);
+    tickTimer_.setInterval(1);
+    connect(&tickTimer_, &QTimer::timeout, this, &LoadGenerator::onTick);
+
+    drainTimer_.setSingleShot(true);
+    connect(&drainTimer_, &QTimer::timeout, this, [this]() {
+        qWarning() << inFlight_ << "requests still unanswered after the drain timeout; aborting them.";
+        for (const auto &manager : managers_) {
+            for (QNetworkReply *reply : manager->findChildren<QNetworkReply *>()) {
+                reply->abort();
+            }
+        }
+    });
+}
+
+bool LoadGenerator::discover(QString *error)
+{
+    for (const Scenario::Credentials &user : scenario_.users) {
+        QJsonObject credentials;
+        credentials["email"] = user.email;
+        credentials["password"] = user.password;
+        int status = 0;
+        QJsonObject login = fetchJson(makeRequest("/api/users/login", QString()),
+                                      QJsonDocument(credentials).toJson(QJsonDocument::Compact), &status);
+        if (status != 200 || !login.contains("id")) {
+            qWarning() << "Login failed for" << user.email << "with status" << status;
+            continue;
+        }
+        qint64 userId = login.value("id").toInteger();
+        userIds_.append(userId);
+
+        QJsonObject panels = fetchJson(makeRequest("/api/solarpanel/list/user",
+                                                   QString("user_id=%1&limit=100").arg(userId)),
+                                       QByteArray(), &status);
+        for (qint64 panelId : idsOf(panels.value("panels").toArray())) {
+            panelIds_.append(panelId);
+            QJsonObject sensors = fetchJson(makeRequest("/api/sensor/list/solarpanel", QString("panel_id=%1").arg(panelId)),
+                                            QByteArray(), &status);
+            sensorIds_.append(idsOf(sensors.value("sensors").toArray()));
+        }
+    }
+
+    qInfo() << "Discovered" << userIds_.size() << "users," << panelIds_.size() << "panels and"
+            << sensorIds_.size() << "sensors.";
+
+    for (const Scenario::Weighted &entry : scenario_.mix) {
+        switch (entry.step) {
+        case Scenario::Step::PanelList:
+            if (userIds_.isEmpty()) {
+                *error = "No scenario user could log in.";
+                return false;
+            }
+            break;
+        case Scenario::Step::SensorList:
+            if (panelIds_.isEmpty()) {
+                *error = "The scenario users have no solar panels.";
+                return false;
+            }
+            break;
+        case Scenario::Step::LatestMeasurement:
+        case Scenario::Step::RangeQuery:
+            if (sensorIds_.isEmpty()) {
+                *error = "The panels of the scenario users have no sensors.";
+                return false;
+            }
+            break;
+        case Scenario::Step::Login:
+        case Scenario::Step::AdminUserList:
+            break;
+        }
+    }
+    return true;
+}
+
+void LoadGenerator::start()
+{
+    warmupNs_ = qint64(settings_.warmupSeconds) * 1'000'000'000;
+    endNs_ = qint64(settings_.durationSeconds) * 1'000'000'000;
+    clock_.start();
+    tickTimer_.start();
+    onTick();
+}
+
+void LoadGenerator::onTick()
+{
+    qint64 now = clock_.nsecsElapsed();
+    for (;;) {
+        qint64 dueNs = qint64(double(scheduled_) * 1e9 / settings_.rate);
+        if (dueNs >= endNs_) {
+            tickTimer_.stop();
+            schedulingDone_ = true;
+            drainTimer_.start(settings_.drainTimeoutSeconds * 1000);
+            finishIfDone();
+            return;
+        }
+        // Requests held back by maxInFlight keep their due time and go out on a later tick.
+        if (dueNs > now || inFlight_ >= settings_.maxInFlight) {
+            return;
+        }
+        send(dueNs);
+        ++scheduled_;
+    }
+}
+
+LoadGenerator::Target LoadGenerator::nextTarget()
+{
+    Target target;
+    Scenario::Step step = scenario_.mix.at(pick(mixWeights_)).step;
+    target.label = Scenario::stepName(step);
+    switch (step) {
+    case Scenario::Step::Login: {
+        const Scenario::Credentials &user = scenario_.users.at(random_.bounded(qsizetype(scenario_.users.size())));
+        QJsonObject credentials;
+        credentials["email"] = user.email;
+        credentials["password"] = user.password;
+        target.request = makeRequest("/api/users/login", QString());
+        target.body = QJsonDocument(credentials).toJson(QJsonDocument::Compact);
+        break;
+    }
+    case Scenario::Step::PanelList:
+        target.request = makeRequest("/api/solarpanel/list/user",
+                                     QString("user_id=%1").arg(userIds_.at(random_.bounded(qsizetype(userIds_.size())))));
+        target.conditional = true;
+        break;
+    case Scenario::Step::SensorList:
+        target.request = makeRequest("/api/sensor/list/solarpanel",
+                                     QString("panel_id=%1").arg(panelIds_.at(random_.bounded(qsizetype(panelIds_.size())))));
+        target.conditional = true;
+        break;
+    case Scenario::Step::LatestMeasurement:
+        target.request = makeRequest("/api/measurement/latest/sensor",
+                                     QString("sensor_id=%1").arg(sensorIds_.at(random_.bounded(qsizetype(sensorIds_.size())))));
+        target.conditional = true;
+        break;
+    case Scenario::Step::RangeQuery: {
+        const Scenario::RangeWidth &width = scenario_.rangeWidths.at(pick(widthWeights_));
+        QDateTime start = QDateTime::currentDateTimeUtc().addSecs(-width.seconds);
+        QUrlQuery query;
+        query.addQueryItem("sensor_id", QString::number(sensorIds_.at(random_.bounded(qsizetype(sensorIds_.size())))));
+        query.addQueryItem("start_date", start.toString(Qt::ISODate));
+        query.addQueryItem("limit", QString::number(scenario_.rangeLimit));
+        target.label = "range_" + width.name;
+        target.request = makeRequest("/api/measurement/list/sensor", query.toString(QUrl::FullyEncoded));
+        break;
+    }
+    case Scenario::Step::AdminUserList:
+        target.request = makeRequest("/api/users/list", QString("page=1&limit=%1").arg(scenario_.adminPageSize));
+        break;
+    }
+    return target;
+}
+
+void LoadGenerator::send(qint64 dueNs)
+{
+    Target target = nextTarget();
+    QString url = target.request.url().toString();
+    if (target.conditional && scenario_.conditionalRequests) {
+        auto tag = entityTags_.constFind(url);
+        if (tag != entityTags_.cend()) {
+            target.request.setRawHeader("If-None-Match", *tag);
+        }
+    }
+
+    QNetworkAccessManager *manager = managers_.at(nextManager_).get();
+    nextManager_ = (nextManager_ + 1) % managers_.size();
+    QNetworkReply *reply = target.body.isEmpty() ? manager->get(target.request)
+                                                 : manager->post(target.request, target.body);
+
+    qint64 sentNs = clock_.nsecsElapsed();
+    qint64 lagNs = sentNs - dueNs;
+    maxSendLagNs_ = qMax(maxSendLagNs_, lagNs);
+    if (lagNs > lateSendNs) {
+        ++lateSends_;
+    }
+    ++inFlight_;
+
+    QString label = target.label;
+    bool conditional = target.conditional;
+    connect(reply, &QNetworkReply::finished, this, [this, reply, label, url, conditional, dueNs, sentNs]() {
+        if (conditional) {
+            QByteArray tag = reply->rawHeader("ETag");
+            if (!tag.isEmpty()) {
+                entityTags_.insert(url, tag);
+            }
+        }
+        onReplyFinished(reply, label, dueNs, sentNs);
+    });
+}
+
+void LoadGenerator::onReplyFinished(QNetworkReply *reply, const QString &label, qint64 dueNs, qint64 sentNs)
+{
+    qint64 nowNs = clock_.nsecsElapsed();
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    qint64 bytes = reply->readAll().size();
+    reply->deleteLater();
+    --inFlight_;
+
+    if (dueNs >= warmupNs_) {
+        EndpointStats &stats = stats_[label];
+        stats.latency.record((nowNs - dueNs) / 1000);
+        stats.service.record((nowNs - sentNs) / 1000);
+        stats.bytes += bytes;
+        if (status == 304) {
+            ++stats.notModified;
+        } else if (status < 200 || status >= 300) {
+            ++stats.errors;
+        }
+    }
+
+    if (schedulingDone_) {
+        finishIfDone();
+    } else if (inFlight_ == settings_.maxInFlight - 1) {
+        // Requests may be waiting on the cap; do not leave them for the next tick.
+        onTick();
+    }
+}
+
+void LoadGenerator::finishIfDone()
+{
+    if (schedulingDone_ && inFlight_ == 0) {
+        drainTimer_.stop();
+        emit finished();
+    }
+}
+
+QNetworkRequest LoadGenerator::makeRequest(const QString &path, const QString &query) const
+{
+    QUrl url = settings_.baseUrl;
+    url.setPath(url.path().chopped(url.path().endsWith('/') ? 1 : 0) + path);
+    url.setQuery(query, QUrl::StrictMode);
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, false);
+    return request;
+}
+
+QJsonObject LoadGenerator::fetchJson(const QNetworkRequest &request, const QByteArray &body, int *status)
+{
+    QNetworkAccessManager *manager = managers_.first().get();
+    QNetworkReply *reply = body.isEmpty() ? manager->get(request) : manager->post(request, body);
+    QEventLoop loop;
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    QTimer::singleShot(10000, reply, &QNetworkReply::abort);
+    loop.exec();
+
+    *status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QJsonObject json = QJsonDocument::fromJson(reply->readAll()).object();
+    reply->deleteLater();
+    return json;
+}
+
+int LoadGenerator::pick(const QList<int> &weights)
+{
+    int total = 0;
+    for (int weight : weights) {
+        total += weight;
+    }
+    int roll = random_.bounded(total);
+    for (int i = 0; i < weights.size(); ++i) {
+        roll -= weights.at(i);
+        if (roll < 0) {
+            return i;
+        }
+    }
+    return int(weights.size()) - 1;
+}
+
+QJsonObject LoadGenerator::report() const
+{
+    double measuredSeconds = qMax(1, settings_.durationSeconds - settings_.warmupSeconds);
+    EndpointStats all;
+    QJsonObject endpoints;
+    auto endpointJson = [measuredSeconds](const EndpointStats &stats) {
+        QJsonObject json;
+        json["count"] = stats.latency.count();
+        json["errors"] = stats.errors;
+        json["not_modified"] = stats.notModified;
+        json["bytes"] = stats.bytes;
+        json["throughput"] = double(stats.latency.count()) / measuredSeconds;
+        json["latency_ms"] = histogramJson(stats.latency);
+        json["service_ms"] = histogramJson(stats.service);
+        return json;
+    };
+    for (auto it = stats_.cbegin(); it != stats_.cend(); ++it) {
+        endpoints[it.key()] = endpointJson(it.value());
+        all.latency.merge(it->latency);
+        all.service.merge(it->service);
+        all.errors += it->errors;
+        all.notModified += it->notModified;
+        all.bytes += it->bytes;
+    }
+
+    QJsonObject json;
+    json["base_url"] = settings_.baseUrl.toString();
+    json["rate"] = settings_.rate;
+    json["duration_seconds"] = settings_.durationSeconds;
+    json["warmup_seconds"] = settings_.warmupSeconds;
+    json["connections"] = int(managers_.size()) * connectionsPerManager;
+    json["late_sends"] = lateSends_;
+    json["max_send_lag_ms"] = double(maxSendLagNs_) / 1e6;
+    json["endpoints"] = endpoints;
+    json["all"] = endpointJson(all);
+    return json;
+}
+
+QString LoadGenerator::formatReport() const
+{
+    QJsonObject json = report();
+    QString text;
+    text += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n")
+                .arg("endpoint", -14)
+                .arg("count", 9)
+                .arg("errors", 7)
+                .arg("req/s", 9)
+                .arg("p50 ms", 9)
+                .arg("p95 ms", 9)
+                .arg("p99 ms", 9)
+                .arg("p99.9 ms", 9)
+                .arg("max ms", 9)
+                .arg("svc p99", 9);
+
+    auto row = [&text](const QString &name, const QJsonObject &endpoint) {
+        QJsonObject latency = endpoint.value("latency_ms").toObject();
+        text += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n")
+                    .arg(name, -14)
+                    .arg(endpoint.value("count").toInteger(), 9)
+                    .arg(endpoint.value("errors").toInteger(), 7)
+                    .arg(endpoint.value("throughput").toDouble(), 9, 'f', 1)
+                    .arg(latency.value("p50").toDouble(), 9, 'f', 2)
+                    .arg(latency.value("p95").toDouble(), 9, 'f', 2)
+                    .arg(latency.value("p99").toDouble(), 9, 'f', 2)
+                    .arg(latency.value("p999").toDouble(), 9, 'f', 2)
+                    .arg(latency.value("max").toDouble(), 9, 'f', 2)
+                    .arg(endpoint.value("service_ms").toObject().value("p99").toDouble(), 9, 'f', 2);
+    };
+    QJsonObject endpoints = json.value("endpoints").toObject();
+    for (auto it = endpoints.begin(); it != endpoints.end(); ++it) {
+        row(it.key(), it.value().toObject());
+    }
+    row("all", json.value("all").toObject());
+
+    text += "\nLatencies are measured from each request's scheduled send time; \"svc p99\" is measured from the actual send.\n";
+    if (lateSends_ > 0) {
+        text += QString("%1 requests went out more than 10 ms late (max %2 ms): the generator or its connection limit, "
+                        "not only the server, held them back.\n")
+                    .arg(lateSends_)
+                    .arg(double(maxSendLagNs_) / 1e6, 0, 'f', 1);
+    }
+    return text;
+}
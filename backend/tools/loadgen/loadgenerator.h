@@ -0,0 +1,110 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QUrl>
+#include <memory>
+#include "latencyhistogram.h"
+#include "scenario.h"
+
+class QNetworkReply;
+
+// Replays a Scenario against a running server at a fixed request rate.
+//
+// The schedule is open-loop: request k is due at k / rate seconds whether or not earlier ones
+// have been answered, and its latency is measured from that due time rather than from when it
+// was actually sent. A stalled server therefore shows up as the queue of requests that should
+// have gone out meanwhile, instead of as one slow sample (coordinated omission). The time from
+// sending to the answer is kept as well, as "service" latency.
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Settings {
+        QUrl baseUrl;
+        double rate = 50;             // Requests per second across all endpoints
+        int durationSeconds = 60;     // Including the warm-up
+        int warmupSeconds = 10;       // Requests due in this window are sent but not recorded
+        int connections = 24;         // HTTP/1.1 connections to the server
+        int maxInFlight = 1024;       // Due requests wait, still on the clock, beyond this
+        int drainTimeoutSeconds = 30; // Unanswered requests are aborted this long after the end
+        quint32 seed = 0;             // 0 picks a random seed
+    };
+
+    struct EndpointStats {
+        LatencyHistogram latency;     // From the due time
+        LatencyHistogram service;     // From the send time
+        qint64 errors = 0;            // Transport errors and statuses other than 2xx and 304
+        qint64 notModified = 0;
+        qint64 bytes = 0;
+    };
+
+    LoadGenerator(const Scenario &scenario, const Settings &settings, QObject *parent = nullptr);
+
+    // Logs in as every user and collects their panels and sensors; blocks until done.
+    bool discover(QString *error);
+    // Starts sending; finished() is emitted once the last request is answered or aborted.
+    void start();
+
+    QJsonObject report() const;
+    QString formatReport() const;
+
+signals:
+    void finished();
+
+private slots:
+    void onTick();
+
+private:
+    struct Target {
+        QString label;
+        QNetworkRequest request;
+        QByteArray body;              // POST when not empty
+        bool conditional = false;     // The URL is stable, so its ETag is worth sending back
+    };
+
+    Target nextTarget();
+    void send(qint64 dueNs);
+    void onReplyFinished(QNetworkReply *reply, const QString &label, qint64 dueNs, qint64 sentNs);
+    void finishIfDone();
+    QNetworkRequest makeRequest(const QString &path, const QString &query) const;
+    QJsonObject fetchJson(const QNetworkRequest &request, const QByteArray &body, int *status);
+    int pick(const QList<int> &weights);
+
+    Scenario scenario_;
+    Settings settings_;
+    QList<std::shared_ptr<QNetworkAccessManager>> managers_;
+    int nextManager_ = 0;
+    QRandomGenerator random_;
+    QList<int> mixWeights_;
+    QList<int> widthWeights_;
+
+    QList<qint64> userIds_;
+    QList<qint64> panelIds_;
+    QList<qint64> sensorIds_;
+    QHash<QString, QByteArray> entityTags_;
+
+    QTimer tickTimer_;
+    QTimer drainTimer_;
+    QElapsedTimer clock_;
+    qint64 scheduled_ = 0;
+    bool schedulingDone_ = false;
+    qint64 warmupNs_ = 0;
+    qint64 endNs_ = 0;
+    int inFlight_ = 0;
+    qint64 lateSends_ = 0;            // Sent more than 10 ms after their due time
+    qint64 maxSendLagNs_ = 0;
+    QMap<QString, EndpointStats> stats_;
+};
+
+#endif // LOADGENERATOR_H
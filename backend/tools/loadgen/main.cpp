@@ -0,0 +1,93 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTextStream>
+#include "loadgenerator.h"
+#include "scenario.h"
+
+// ArkaNova_loadgen: replays a mix of dashboard requests against a running server at a fixed
+// rate and reports throughput and latency percentiles per endpoint. See scenario.example.json
+// for the scenario format and LoadGenerator for how latency is measured.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ArkaNova_loadgen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Mixed-workload HTTP load generator for the ArkaNova API.");
+    parser.addHelpOption();
+    QCommandLineOption urlOption("url", "Base URL of the server.", "url", "http://localhost:4925");
+    QCommandLineOption rateOption("rate", "Requests per second across all endpoints.", "rate", "50");
+    QCommandLineOption durationOption("duration", "Seconds to run, warm-up included.", "seconds", "60");
+    QCommandLineOption warmupOption("warmup", "Seconds of load left out of the report.", "seconds", "10");
+    QCommandLineOption connectionsOption("connections", "HTTP connections to open.", "count", "24");
+    QCommandLineOption maxInFlightOption("max-in-flight", "Requests outstanding at once.", "count", "1024");
+    QCommandLineOption scenarioOption("scenario", "Scenario JSON file; the built-in dashboard mix otherwise.", "file");
+    QCommandLineOption seedOption("seed", "Seed for the request mix, for repeatable runs.", "seed", "0");
+    QCommandLineOption jsonOption("json", "Also write the report as JSON to this file.", "file");
+    parser.addOptions({urlOption, rateOption, durationOption, warmupOption, connectionsOption, maxInFlightOption,
+                       scenarioOption, seedOption, jsonOption});
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    Scenario scenario = Scenario::defaults();
+    if (parser.isSet(scenarioOption)) {
+        QFile file(parser.value(scenarioOption));
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "Cannot read " << file.fileName() << ": " << file.errorString() << Qt::endl;
+            return 1;
+        }
+        QString error;
+        auto loaded = Scenario::fromJson(file.readAll(), &error);
+        if (!loaded) {
+            err << file.fileName() << ": " << error << Qt::endl;
+            return 1;
+        }
+        scenario = *loaded;
+    }
+
+    LoadGenerator::Settings settings;
+    settings.baseUrl = QUrl(parser.value(urlOption));
+    settings.rate = parser.value(rateOption).toDouble();
+    settings.durationSeconds = parser.value(durationOption).toInt();
+    settings.warmupSeconds = parser.value(warmupOption).toInt();
+    settings.connections = parser.value(connectionsOption).toInt();
+    settings.maxInFlight = parser.value(maxInFlightOption).toInt();
+    settings.seed = parser.value(seedOption).toUInt();
+
+    if (!settings.baseUrl.isValid() || settings.rate <= 0 || settings.durationSeconds <= settings.warmupSeconds
+        || settings.warmupSeconds < 0 || settings.connections < 1 || settings.maxInFlight < 1) {
+        err << "Invalid options: the URL must be valid, the rate, connections and max-in-flight positive, "
+               "and the duration longer than the warm-up." << Qt::endl;
+        return 1;
+    }
+
+    LoadGenerator generator(scenario, settings);
+    QString error;
+    if (!generator.discover(&error)) {
+        err << error << Qt::endl;
+        return 1;
+    }
+
+    QString jsonPath = parser.value(jsonOption);
+    QObject::connect(&generator, &LoadGenerator::finished, &app, [&generator, &app, jsonPath]() {
+        QTextStream(stdout) << generator.formatReport();
+        if (!jsonPath.isEmpty()) {
+            QFile file(jsonPath);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                QTextStream(stderr) << "Cannot write " << jsonPath << ": " << file.errorString() << Qt::endl;
+                app.exit(1);
+                return;
+            }
+            file.write(QJsonDocument(generator.report()).toJson());
+        }
+        app.quit();
+    });
+
+    QTextStream(stdout) << "Sending " << settings.rate << " requests/s to " << settings.baseUrl.toString() << " for "
+                        << settings.durationSeconds << " s (" << settings.warmupSeconds << " s warm-up)..." << Qt::endl;
+    generator.start();
+    return app.exec();
+}
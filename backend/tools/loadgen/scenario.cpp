@@ -0,0 +1,165 @@
+#include "scenario.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+
+namespace {
+
+struct StepName {
+    Scenario::Step step;
+    const char *name;
+};
+
+constexpr StepName stepNames[] = {
+    {Scenario::Step::Login, "login"},
+    {Scenario::Step::PanelList, "panels"},
+    {Scenario::Step::SensorList, "sensors"},
+    {Scenario::Step::LatestMeasurement, "latest"},
+    {Scenario::Step::RangeQuery, "range"},
+    {Scenario::Step::AdminUserList, "admin_users"},
+};
+
+}
+
+Scenario Scenario::defaults()
+{
+    Scenario scenario;
+    scenario.users = {{"newuser@example.com", "new81dc9bdb52d04dc20036dbd8313ed055"}};
+    // Mostly the dashboard's 5 s latest-value poll, with an occasional chart, reload or login.
+    scenario.mix = {
+        {Step::LatestMeasurement, 50},
+        {Step::RangeQuery, 20},
+        {Step::SensorList, 10},
+        {Step::PanelList, 10},
+        {Step::Login, 5},
+        {Step::AdminUserList, 5},
+    };
+    scenario.rangeWidths = {
+        {"1h", 3600, 5},
+        {"6h", 6 * 3600, 3},
+        {"1d", 24 * 3600, 2},
+        {"7d", 7 * 24 * 3600, 1},
+    };
+    return scenario;
+}
+
+std::optional<Scenario> Scenario::fromJson(const QByteArray &json, QString *error)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(json, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        *error = "Scenario is not a JSON object: " + parseError.errorString();
+        return std::nullopt;
+    }
+    QJsonObject root = doc.object();
+    Scenario scenario = defaults();
+
+    if (root.contains("users")) {
+        scenario.users.clear();
+        for (const QJsonValue &value : root.value("users").toArray()) {
+            QJsonObject user = value.toObject();
+            if (!user.value("email").isString() || !user.value("password").isString()) {
+                *error = "Every user needs an email and a password.";
+                return std::nullopt;
+            }
+            scenario.users.append({user.value("email").toString(), user.value("password").toString()});
+        }
+    }
+
+    if (root.contains("mix")) {
+        scenario.mix.clear();
+        QJsonObject mix = root.value("mix").toObject();
+        for (auto it = mix.begin(); it != mix.end(); ++it) {
+            auto step = stepFromName(it.key());
+            if (!step) {
+                *error = "Unknown step in mix: " + it.key();
+                return std::nullopt;
+            }
+            int weight = it.value().toInt(-1);
+            if (weight < 0) {
+                *error = "The weight of " + it.key() + " must be a non-negative integer.";
+                return std::nullopt;
+            }
+            if (weight > 0) {
+                scenario.mix.append({*step, weight});
+            }
+        }
+    }
+
+    if (root.contains("range_widths")) {
+        scenario.rangeWidths.clear();
+        QJsonObject widths = root.value("range_widths").toObject();
+        for (auto it = widths.begin(); it != widths.end(); ++it) {
+            qint64 seconds = parseWidth(it.key());
+            int weight = it.value().toInt(-1);
+            if (seconds <= 0 || weight < 0) {
+                *error = "Invalid range width " + it.key() + "; use e.g. \"6h\": 3.";
+                return std::nullopt;
+            }
+            if (weight > 0) {
+                scenario.rangeWidths.append({it.key(), seconds, weight});
+            }
+        }
+    }
+
+    scenario.rangeLimit = root.value("range_limit").toInt(scenario.rangeLimit);
+    scenario.adminPageSize = root.value("admin_page_size").toInt(scenario.adminPageSize);
+    scenario.conditionalRequests = root.value("conditional_requests").toBool(scenario.conditionalRequests);
+
+    if (scenario.mix.isEmpty()) {
+        *error = "The mix has no step with a positive weight.";
+        return std::nullopt;
+    }
+    if (scenario.users.isEmpty()) {
+        *error = "The scenario needs at least one user.";
+        return std::nullopt;
+    }
+    bool sendsRanges = std::any_of(scenario.mix.cbegin(), scenario.mix.cend(), [](const Weighted &entry) {
+        return entry.step == Step::RangeQuery;
+    });
+    if (sendsRanges && scenario.rangeWidths.isEmpty()) {
+        *error = "The mix sends range queries but no range width has a positive weight.";
+        return std::nullopt;
+    }
+    return scenario;
+}
+
+const char *Scenario::stepName(Step step)
+{
+    for (const StepName &entry : stepNames) {
+        if (entry.step == step) {
+            return entry.name;
+        }
+    }
+    return "unknown";
+}
+
+std::optional<Scenario::Step> Scenario::stepFromName(const QString &name)
+{
+    for (const StepName &entry : stepNames) {
+        if (name == QLatin1String(entry.name)) {
+            return entry.step;
+        }
+    }
+    return std::nullopt;
+}
+
+qint64 Scenario::parseWidth(const QString &width)
+{
+    if (width.size() < 2) {
+        return 0;
+    }
+    bool ok;
+    qint64 amount = width.left(width.size() - 1).toLongLong(&ok);
+    if (!ok || amount <= 0) {
+        return 0;
+    }
+    switch (width.back().toLatin1()) {
+    case 's': return amount;
+    case 'm': return amount * 60;
+    case 'h': return amount * 3600;
+    case 'd': return amount * 86400;
+    default: return 0;
+    }
+}
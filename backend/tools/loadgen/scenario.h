@@ -0,0 +1,51 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <optional>
+
+// The request mix ArkaNova_loadgen replays: which dashboard steps it sends, in what
+// proportion, and as which users. Loaded from a JSON file shaped like scenario.example.json;
+// keys left out keep the defaults below.
+struct Scenario
+{
+    enum class Step { Login, PanelList, SensorList, LatestMeasurement, RangeQuery, AdminUserList };
+
+    struct Credentials {
+        QString email;
+        QString password;
+    };
+
+    struct Weighted {
+        Step step;
+        int weight;
+    };
+
+    // One width of /api/measurement/list/sensor range, ending now; reported as range_<name>.
+    struct RangeWidth {
+        QString name;
+        qint64 seconds;
+        int weight;
+    };
+
+    QList<Credentials> users;
+    QList<Weighted> mix;
+    QList<RangeWidth> rangeWidths;
+    int rangeLimit = 1000;
+    int adminPageSize = 25;
+    // Send the ETag of the previous answer back as If-None-Match, as the dashboard does.
+    bool conditionalRequests = true;
+
+    // The seeded user of db/ArkaNova.sql, polling the way the dashboard does.
+    static Scenario defaults();
+    static std::optional<Scenario> fromJson(const QByteArray &json, QString *error);
+
+    static const char *stepName(Step step);
+    static std::optional<Step> stepFromName(const QString &name);
+    // "30s", "15m", "6h" or "7d"; 0 on anything else.
+    static qint64 parseWidth(const QString &width);
+};
+
+#endif // SCENARIO_H
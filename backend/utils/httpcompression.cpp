@@ -0,0 +1,191 @@
+#include "httpcompression.h"
+#include <QList>
+#include <zlib.h>
+
+HttpCompression::Settings HttpCompression::settings_;
+
+namespace {
+// zlib picks the wrapper from windowBits: +16 selects gzip, plain 15 the zlib format that
+// HTTP calls "deflate".
+int windowBits(HttpCompression::Encoding encoding)
+{
+    return encoding == HttpCompression::Encoding::Gzip ? 15 + 16 : 15;
+}
+
+bool initDeflate(z_stream &stream, HttpCompression::Encoding encoding)
+{
+    stream = {};
+    return deflateInit2(&stream, HttpCompression::settings().level, Z_DEFLATED, windowBits(encoding),
+                        8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+bool deflateInto(z_stream &stream, QByteArray &out, const QByteArray &input, int flush)
+{
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.constData()));
+    stream.avail_in = uInt(input.size());
+
+    do {
+        qsizetype offset = out.size();
+        qsizetype room = qMax<qsizetype>(deflateBound(&stream, stream.avail_in) + 16, 4096);
+        out.resize(offset + room);
+        stream.next_out = reinterpret_cast<Bytef *>(out.data() + offset);
+        stream.avail_out = uInt(room);
+
+        int result = deflate(&stream, flush);
+        out.resize(offset + room - stream.avail_out);
+        if (result == Z_STREAM_ERROR) {
+            return false;
+        }
+        if (result == Z_STREAM_END) {
+            return true;
+        }
+    } while (flush == Z_FINISH || stream.avail_out == 0 || stream.avail_in > 0);
+    return true;
+}
+}
+
+void HttpCompression::setSettings(const Settings &settings)
+{
+    settings_ = settings;
+    settings_.level = qBound(Z_BEST_SPEED, settings_.level, Z_BEST_COMPRESSION);
+    settings_.minSize = qMax(0, settings_.minSize);
+}
+
+const HttpCompression::Settings &HttpCompression::settings()
+{
+    return settings_;
+}
+
+HttpCompression::Encoding HttpCompression::negotiate(const QByteArray &acceptEncoding)
+{
+    if (!settings_.enabled || acceptEncoding.isEmpty()) {
+        return Encoding::Identity;
+    }
+
+    double gzipQuality = -1;
+    double deflateQuality = -1;
+    double wildcardQuality = -1;
+    for (const QByteArray &coding : acceptEncoding.split(',')) {
+        QList<QByteArray> parts = coding.split(';');
+        QByteArray name = parts.first().trimmed().toLower();
+
+        double quality = 1;
+        for (qsizetype i = 1; i < parts.size(); ++i) {
+            QByteArray parameter = parts.at(i).trimmed();
+            if (parameter.startsWith("q=")) {
+                quality = parameter.mid(2).toDouble();
+            }
+        }
+
+        if (name == "gzip" || name == "x-gzip") {
+            gzipQuality = quality;
+        } else if (name == "deflate") {
+            deflateQuality = quality;
+        } else if (name == "*") {
+            wildcardQuality = quality;
+        }
+    }
+
+    if (gzipQuality < 0) {
+        gzipQuality = wildcardQuality;
+    }
+    if (deflateQuality < 0) {
+        deflateQuality = wildcardQuality;
+    }
+
+    if (gzipQuality > 0 && gzipQuality >= deflateQuality) {
+        return Encoding::Gzip;
+    }
+    if (deflateQuality > 0) {
+        return Encoding::Deflate;
+    }
+    return Encoding::Identity;
+}
+
+QByteArray HttpCompression::name(Encoding encoding)
+{
+    switch (encoding) {
+    case Encoding::Gzip: return "gzip";
+    case Encoding::Deflate: return "deflate";
+    case Encoding::Identity: break;
+    }
+    return "identity";
+}
+
+bool HttpCompression::isCompressible(const QByteArray &contentType)
+{
+    static const QByteArray precompressed[] = {
+        "application/gzip",
+        "application/x-gzip",
+        "application/zip",
+        "application/x-7z-compressed",
+        "application/x-bzip2",
+        "application/x-xz",
+        "application/zstd",
+        "image/",
+        "video/",
+        "audio/",
+    };
+
+    QByteArray type = contentType.toLower();
+    for (const QByteArray &prefix : precompressed) {
+        if (type.startsWith(prefix)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<QByteArray> HttpCompression::compress(const QByteArray &data, Encoding encoding)
+{
+    if (encoding == Encoding::Identity) {
+        return data;
+    }
+
+    z_stream stream;
+    if (!initDeflate(stream, encoding)) {
+        return std::nullopt;
+    }
+
+    QByteArray out;
+    out.reserve(deflateBound(&stream, uLong(data.size())));
+    bool ok = deflateInto(stream, out, data, Z_FINISH);
+    deflateEnd(&stream);
+    if (!ok) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+struct HttpCompression::Stream::State {
+    z_stream stream;
+    bool valid = false;
+    bool finished = false;
+};
+
+HttpCompression::Stream::Stream(Encoding encoding)
+    : state_(std::make_unique<State>())
+{
+    state_->valid = encoding != Encoding::Identity && initDeflate(state_->stream, encoding);
+}
+
+HttpCompression::Stream::~Stream()
+{
+    if (state_->valid) {
+        deflateEnd(&state_->stream);
+    }
+}
+
+bool HttpCompression::Stream::isValid() const
+{
+    return state_->valid;
+}
+
+bool HttpCompression::Stream::append(QByteArray &out, const QByteArray &input, bool finish)
+{
+    if (!state_->valid || state_->finished) {
+        return false;
+    }
+    state_->finished = finish;
+    return deflateInto(state_->stream, out, input, finish ? Z_FINISH : Z_SYNC_FLUSH);
+}
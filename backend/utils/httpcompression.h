@@ -0,0 +1,57 @@
+#ifndef HTTPCOMPRESSION_H
+#define HTTPCOMPRESSION_H
+
+#include <QByteArray>
+#include <memory>
+#include <optional>
+
+// gzip/deflate content coding for response bodies, negotiated from Accept-Encoding.
+class HttpCompression
+{
+public:
+    enum class Encoding { Identity, Gzip, Deflate };
+
+    struct Settings {
+        bool enabled = true;
+        int minSize = 1024;   // Smaller bodies go out uncompressed; the framing would eat the gain
+        int level = 6;        // zlib level, 1 (fastest) to 9 (smallest)
+    };
+
+    static void setSettings(const Settings &settings);
+    static const Settings &settings();
+
+    // Picks the coding the client prefers, gzip winning ties; Identity when none is acceptable
+    // or compression is disabled.
+    static Encoding negotiate(const QByteArray &acceptEncoding);
+    static QByteArray name(Encoding encoding);
+
+    // False for media types that are already compressed (archives, images, backups).
+    static bool isCompressible(const QByteArray &contentType);
+
+    // One-shot compression; std::nullopt when zlib fails.
+    static std::optional<QByteArray> compress(const QByteArray &data, Encoding encoding);
+
+    // Incremental compressor for streamed bodies. Every append() ends with a sync flush so the
+    // client can decode each chunk as soon as it arrives.
+    class Stream
+    {
+    public:
+        explicit Stream(Encoding encoding);
+        ~Stream();
+        Stream(const Stream &) = delete;
+        Stream &operator=(const Stream &) = delete;
+
+        bool isValid() const;
+        // Compresses `input` onto `out`; `finish` writes the stream trailer.
+        bool append(QByteArray &out, const QByteArray &input, bool finish = false);
+
+    private:
+        struct State;
+        std::unique_ptr<State> state_;
+    };
+
+private:
+    static Settings settings_;
+};
+
+#endif // HTTPCOMPRESSION_H
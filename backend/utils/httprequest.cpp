@@ -0,0 +1,47 @@
+#include "httprequest.h"
+
+namespace {
+const QByteArray capturedHeaders[] = {
+    "accept",
+    "accept-encoding",
+    "authorization",
+    "content-type",
+    "if-none-match",
+};
+}
+
+HttpRequest::HttpRequest(const QHttpServerRequest &request)
+    : url_(request.url()), query_(request.query()), body_(request.body()), method_(request.method())
+{
+    for (const QByteArray &header : capturedHeaders) {
+        QByteArray headerValue = request.value(header);
+        if (!headerValue.isEmpty()) {
+            headers_.insert(header, headerValue);
+        }
+    }
+}
+
+const QUrl &HttpRequest::url() const
+{
+    return url_;
+}
+
+const QUrlQuery &HttpRequest::query() const
+{
+    return query_;
+}
+
+const QByteArray &HttpRequest::body() const
+{
+    return body_;
+}
+
+QHttpServerRequest::Method HttpRequest::method() const
+{
+    return method_;
+}
+
+QByteArray HttpRequest::value(const QByteArray &key) const
+{
+    return headers_.value(key.toLower());
+}
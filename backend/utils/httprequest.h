@@ -0,0 +1,34 @@
+#ifndef HTTPREQUEST_H
+#define HTTPREQUEST_H
+
+#include <QtHttpServer/QHttpServerRequest>
+#include <QByteArray>
+#include <QHash>
+#include <QUrl>
+#include <QUrlQuery>
+
+// Copyable snapshot of the parts of a QHttpServerRequest the handlers read.
+// QHttpServerRequest cannot be copied and is reused by the server for the next request on the
+// connection, so handlers that run on a worker thread get one of these instead.
+class HttpRequest
+{
+public:
+    explicit HttpRequest(const QHttpServerRequest& request);
+
+    const QUrl& url() const;
+    const QUrlQuery& query() const;
+    const QByteArray& body() const;
+    QHttpServerRequest::Method method() const;
+
+    // Header lookup is case-insensitive. Only the headers the API reads are captured.
+    QByteArray value(const QByteArray& key) const;
+
+private:
+    QUrl url_;
+    QUrlQuery query_;
+    QByteArray body_;
+    QHttpServerRequest::Method method_;
+    QHash<QByteArray, QByteArray> headers_;
+};
+
+#endif // HTTPREQUEST_H
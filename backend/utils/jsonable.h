@@ -3,11 +3,18 @@
 
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QJsonDocument>
 
 class Jsonable {
 public:
     virtual ~Jsonable() {};
     virtual QJsonObject toJson() const = 0;
+
+    // Appends the compact UTF-8 form of toJson() to `out`. Models on hot list paths override it
+    // with JsonWriter so that no intermediate QJsonObject is built per row.
+    virtual void writeJson(QByteArray &out) const {
+        out.append(QJsonDocument(toJson()).toJson(QJsonDocument::Compact));
+    }
 };
 
 #endif // JSONABLE_H
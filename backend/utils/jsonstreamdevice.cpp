@@ -0,0 +1,80 @@
+#include "jsonstreamdevice.h"
+#include <QTimer>
+#include <cstring>
+
+JsonStreamDevice::JsonStreamDevice(Producer producer, qsizetype chunkSize, QObject *parent)
+    : QIODevice(parent), producer_(std::move(producer)), chunkSize_(qMax<qsizetype>(1024, chunkSize))
+{
+    body_.reserve(chunkSize_ + 1024);
+    framed_.reserve(chunkSize_ + 1024 + 16);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    // The responder starts pulling on readyRead as well as on socket progress; announce the body once.
+    QTimer::singleShot(0, this, [this]() {
+        emit readyRead();
+    });
+}
+
+bool JsonStreamDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 JsonStreamDevice::bytesAvailable() const
+{
+    fill();
+    return (framed_.size() - readPos_) + QIODevice::bytesAvailable();
+}
+
+bool JsonStreamDevice::atEnd() const
+{
+    return terminated_ && readPos_ >= framed_.size();
+}
+
+qint64 JsonStreamDevice::readData(char *data, qint64 maxSize)
+{
+    fill();
+    qint64 count = qMin<qint64>(maxSize, framed_.size() - readPos_);
+    if (count > 0) {
+        std::memcpy(data, framed_.constData() + readPos_, count);
+        readPos_ += count;
+    }
+    return count;
+}
+
+qint64 JsonStreamDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+void JsonStreamDevice::fill() const
+{
+    if (readPos_ < framed_.size() || terminated_) {
+        return;
+    }
+
+    // resize(0) keeps the capacity, so steady-state streaming does not reallocate.
+    framed_.resize(0);
+    readPos_ = 0;
+    body_.resize(0);
+    while (!producerDone_ && body_.size() < chunkSize_) {
+        if (!producer_(body_)) {
+            producerDone_ = true;
+        }
+    }
+
+    appendChunk(framed_, body_, producerDone_);
+    terminated_ = producerDone_;
+}
+
+void JsonStreamDevice::appendChunk(QByteArray &framed, const QByteArray &body, bool last)
+{
+    if (!body.isEmpty()) {
+        framed.append(QByteArray::number(body.size(), 16)).append("\r\n").append(body).append("\r\n");
+    }
+    if (last) {
+        framed.append("0\r\n\r\n");
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef JSONSTREAMDEVICE_H
+#define JSONSTREAMDEVICE_H
+
+#include <QIODevice>
+#include <functional>
+
+// Sequential, read-only device that produces an HTTP/1.1 chunked response body on demand.
+// QHttpServerResponder copies a device's bytes to the socket as the socket drains, so the
+// producer is only asked for more once the previous chunk has been read; memory stays at
+// about one chunk no matter how long the body is.
+class JsonStreamDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    // Appends the next part of the body to `out`; returns false once the body is complete.
+    using Producer = std::function<bool(QByteArray& out)>;
+
+    explicit JsonStreamDevice(Producer producer, qsizetype chunkSize = 16 * 1024, QObject *parent = nullptr);
+
+    // Appends `body` to `framed` as one chunk, followed by the terminating chunk if `last`.
+    static void appendChunk(QByteArray &framed, const QByteArray &body, bool last);
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+    bool atEnd() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    // Refills `framed_` with the next chunk once everything before it has been read.
+    void fill() const;
+
+    mutable Producer producer_;
+    qsizetype chunkSize_;
+    mutable QByteArray body_;
+    mutable QByteArray framed_;
+    mutable qsizetype readPos_ = 0;
+    mutable bool producerDone_ = false;
+    mutable bool terminated_ = false;
+};
+
+#endif // JSONSTREAMDEVICE_H
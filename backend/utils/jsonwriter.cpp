@@ -0,0 +1,104 @@
+#include "jsonwriter.h"
+#include <charconv>
+#include <cmath>
+
+namespace JsonWriter {
+
+void appendString(QByteArray &out, QStringView value)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    out.append('"');
+    const qsizetype length = value.size();
+    for (qsizetype i = 0; i < length; ++i) {
+        char16_t c = value.at(i).unicode();
+
+        if (c < 0x80) {
+            switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                if (c < 0x20) {
+                    const char escaped[] = {'\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF]};
+                    out.append(escaped, sizeof(escaped));
+                } else {
+                    out.append(char(c));
+                }
+            }
+            continue;
+        }
+
+        char32_t codePoint = c;
+        if (QChar::isHighSurrogate(c) && i + 1 < length && QChar::isLowSurrogate(value.at(i + 1).unicode())) {
+            codePoint = QChar::surrogateToUcs4(c, value.at(++i).unicode());
+        } else if (QChar::isSurrogate(c)) {
+            codePoint = 0xFFFD; // Unpaired surrogate
+        }
+
+        char encoded[4];
+        qsizetype size;
+        if (codePoint < 0x800) {
+            encoded[0] = char(0xC0 | (codePoint >> 6));
+            encoded[1] = char(0x80 | (codePoint & 0x3F));
+            size = 2;
+        } else if (codePoint < 0x10000) {
+            encoded[0] = char(0xE0 | (codePoint >> 12));
+            encoded[1] = char(0x80 | ((codePoint >> 6) & 0x3F));
+            encoded[2] = char(0x80 | (codePoint & 0x3F));
+            size = 3;
+        } else {
+            encoded[0] = char(0xF0 | (codePoint >> 18));
+            encoded[1] = char(0x80 | ((codePoint >> 12) & 0x3F));
+            encoded[2] = char(0x80 | ((codePoint >> 6) & 0x3F));
+            encoded[3] = char(0x80 | (codePoint & 0x3F));
+            size = 4;
+        }
+        out.append(encoded, size);
+    }
+    out.append('"');
+}
+
+void appendInt(QByteArray &out, qint64 value)
+{
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr - buffer);
+}
+
+void appendDouble(QByteArray &out, double value)
+{
+    if (!std::isfinite(value)) {
+        appendNull(out);
+        return;
+    }
+
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr - buffer);
+}
+
+void appendDouble(QByteArray &out, std::optional<double> value)
+{
+    if (value) {
+        appendDouble(out, *value);
+    } else {
+        appendNull(out);
+    }
+}
+
+void appendBool(QByteArray &out, bool value)
+{
+    out.append(value ? "true" : "false");
+}
+
+void appendNull(QByteArray &out)
+{
+    out.append("null");
+}
+
+}
@@ -0,0 +1,33 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <QByteArray>
+#include <QStringView>
+#include <QtGlobal>
+#include <optional>
+
+// Appends compact JSON tokens straight into a caller-owned buffer. Unlike QJsonObject and
+// QJsonDocument it allocates nothing per value: numbers are formatted with std::to_chars and
+// strings are escaped and UTF-8 encoded in place.
+namespace JsonWriter {
+
+void appendString(QByteArray &out, QStringView value);
+void appendInt(QByteArray &out, qint64 value);
+// Shortest representation that round-trips; NaN and infinities become null.
+void appendDouble(QByteArray &out, double value);
+void appendDouble(QByteArray &out, std::optional<double> value);
+void appendBool(QByteArray &out, bool value);
+void appendNull(QByteArray &out);
+
+// Appends `"key":`, preceded by a comma unless `first`. Keys are trusted ASCII literals.
+inline void appendKey(QByteArray &out, const char *key, bool first = false)
+{
+    if (!first) {
+        out.append(',');
+    }
+    out.append('"').append(key).append("\":");
+}
+
+}
+
+#endif // JSONWRITER_H
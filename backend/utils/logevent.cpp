@@ -0,0 +1,87 @@
+#include "logevent.h"
+#include "jsonwriter.h"
+#include <chrono>
+
+LogSite::LogSite(const char *event, Logger::LogLevel level, Policy policy)
+    : event_(event), level_(level), policy_(policy)
+{
+    policy_.sampleEvery = qMax(1, policy_.sampleEvery);
+    policy_.maxPerSecond = qMax(0, policy_.maxPerSecond);
+}
+
+bool LogSite::shouldLog()
+{
+    if (!Logger::instance().isEnabled(level_)) {
+        return false;
+    }
+
+    if (policy_.sampleEvery > 1
+        && calls_.fetch_add(1, std::memory_order_relaxed) % quint64(policy_.sampleEvery) != 0) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (policy_.maxPerSecond > 0) {
+        qint64 second = std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::steady_clock::now().time_since_epoch()).count();
+        qint64 window = windowSecond_.load(std::memory_order_relaxed);
+        if (window != second && windowSecond_.compare_exchange_strong(window, second, std::memory_order_relaxed)) {
+            windowCount_.store(0, std::memory_order_relaxed);
+        }
+        if (windowCount_.fetch_add(1, std::memory_order_relaxed) >= policy_.maxPerSecond) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+quint64 LogSite::takeSuppressed()
+{
+    return suppressed_.exchange(0, std::memory_order_relaxed);
+}
+
+LogEvent::LogEvent(LogSite &site)
+    : site_(site)
+{
+    fields_.reserve(128);
+    JsonWriter::appendKey(fields_, "event", true);
+    JsonWriter::appendString(fields_, QString::fromLatin1(site.event()));
+}
+
+LogEvent &LogEvent::add(const char *key, QStringView value)
+{
+    JsonWriter::appendKey(fields_, key);
+    JsonWriter::appendString(fields_, value);
+    return *this;
+}
+
+LogEvent &LogEvent::add(const char *key, double value)
+{
+    JsonWriter::appendKey(fields_, key);
+    JsonWriter::appendDouble(fields_, value);
+    return *this;
+}
+
+LogEvent &LogEvent::add(const char *key, bool value)
+{
+    JsonWriter::appendKey(fields_, key);
+    JsonWriter::appendBool(fields_, value);
+    return *this;
+}
+
+LogEvent &LogEvent::addInt(const char *key, qint64 value)
+{
+    JsonWriter::appendKey(fields_, key);
+    JsonWriter::appendInt(fields_, value);
+    return *this;
+}
+
+void LogEvent::write()
+{
+    quint64 suppressed = site_.takeSuppressed();
+    if (suppressed > 0) {
+        addInt("suppressed", qint64(suppressed));
+    }
+    Logger::instance().logStructured(std::move(fields_), site_.level());
+}
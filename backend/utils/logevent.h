@@ -0,0 +1,73 @@
+#ifndef LOGEVENT_H
+#define LOGEVENT_H
+
+#include <QByteArray>
+#include <QStringView>
+#include <atomic>
+#include <concepts>
+#include "logger.h"
+
+// One call site of a structured log event, declared as a function-local static so its
+// counters live as long as the process. shouldLog() applies the level, then keeps one call in
+// sampleEvery, then at most maxPerSecond of those; everything it turns away is counted and
+// reported as "suppressed" on the next event that gets through.
+//
+//     static LogSite site("mqtt.message", Logger::LogLevel::Debug, {.sampleEvery = 100});
+//     if (site.shouldLog()) {
+//         LogEvent(site).add("topic", topic).add("bytes", message.size()).write();
+//     }
+class LogSite
+{
+public:
+    struct Policy {
+        int sampleEvery = 1;    // 1 keeps every call
+        int maxPerSecond = 0;   // 0 means no limit
+    };
+
+    LogSite(const char* event, Logger::LogLevel level, Policy policy = {});
+
+    bool shouldLog();
+
+    const char* event() const { return event_; }
+    Logger::LogLevel level() const { return level_; }
+    // Calls turned away since the previous event, resetting the count.
+    quint64 takeSuppressed();
+
+private:
+    const char* event_;
+    Logger::LogLevel level_;
+    Policy policy_;
+
+    std::atomic<quint64> calls_ {0};
+    std::atomic<quint64> suppressed_ {0};
+    std::atomic<qint64> windowSecond_ {0};
+    std::atomic<int> windowCount_ {0};
+};
+
+// Builds the fields of one JSON-lines event; write() hands it to the Logger, which adds the
+// timestamp and level. Keys are trusted ASCII literals.
+class LogEvent
+{
+public:
+    explicit LogEvent(LogSite& site);
+
+    LogEvent& add(const char* key, QStringView value);
+    LogEvent& add(const char* key, double value);
+    LogEvent& add(const char* key, bool value);
+    template <typename T>
+        requires std::integral<T> && (!std::same_as<T, bool>)
+    LogEvent& add(const char* key, T value)
+    {
+        return addInt(key, qint64(value));
+    }
+
+    void write();
+
+private:
+    LogEvent& addInt(const char* key, qint64 value);
+
+    LogSite& site_;
+    QByteArray fields_;
+};
+
+#endif // LOGEVENT_H
@@ -1,12 +1,27 @@
 #include "logger.h"
-#include <iostream>
+#include <QTimeZone>
+#include <algorithm>
+#include <cstdio>
 
 Logger::Logger()
-    : consoleOutputEnabled_(true), currentLogLevel_(LogLevel::Info) {}
+    : currentLogLevel_(LogLevel::Info), consoleOutputEnabled_(true), flushIntervalMs_(Settings().flushIntervalMs),
+      queueCapacity_(Settings().queueCapacity), overflowPolicy_(Settings().overflowPolicy)
+{
+    writer_.reset(QThread::create([this]() { run(); }));
+    writer_->start();
+}
 
 Logger::~Logger()
 {
-    if(logFile_.isOpen()) {
+    {
+        QMutexLocker locker(&flowMutex_);
+        stopping_ = true;
+        wakeWriter_.wakeAll();
+        spaceAvailable_.wakeAll();
+    }
+    writer_->wait();
+
+    if (logFile_.isOpen()) {
         logFile_.close();
     }
 }
@@ -17,34 +32,108 @@ Logger &Logger::instance()
     return loggerInstance;
 }
 
+int Logger::severity(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::Debug: return 0;
+    case LogLevel::Info: return 1;
+    case LogLevel::Warning: return 2;
+    case LogLevel::Error: return 3;
+    }
+    return 1;
+}
+
+const char *Logger::levelName(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::Info: return "INFO";
+    case LogLevel::Warning: return "WARNING";
+    case LogLevel::Error: return "ERROR";
+    case LogLevel::Debug: return "DEBUG";
+    }
+    return "INFO";
+}
+
+Logger::Shard &Logger::currentShard()
+{
+    // Each thread sticks to one shard, so producers on different threads rarely share a lock.
+    thread_local int shard = nextShard_.fetch_add(1, std::memory_order_relaxed) % shardCount;
+    return shards_[shard];
+}
+
 void Logger::log(const QString &message, LogLevel level)
 {
-    QString formattedMessage = formatMessage(message, level);
+    if (!isEnabled(level) || !reserveSlot()) {
+        return;
+    }
+    enqueue(Entry{0, QDateTime::currentMSecsSinceEpoch(), level, message, QByteArray()});
+}
+
+void Logger::logStructured(QByteArray fields, LogLevel level)
+{
+    if (!reserveSlot()) {
+        return;
+    }
+    enqueue(Entry{0, QDateTime::currentMSecsSinceEpoch(), level, QString(), std::move(fields)});
+}
+
+bool Logger::reserveSlot()
+{
+    qint64 capacity = queueCapacity_.load(std::memory_order_relaxed);
+    if (queued_.fetch_add(1, std::memory_order_relaxed) >= capacity) {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        // The writer thread never waits on itself.
+        if (overflowPolicy_.load(std::memory_order_relaxed) == OverflowPolicy::Drop
+            || QThread::currentThread() == writer_.get()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
 
-    QMutexLocker locker(&mutex_);
+        QMutexLocker locker(&flowMutex_);
+        wakeWriter_.wakeOne();
+        while (queued_.load(std::memory_order_relaxed) >= capacity && !stopping_) {
+            spaceAvailable_.wait(&flowMutex_);
+        }
+        queued_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
 
-    if(logFile_.isOpen()) {
-        logStream_ << formattedMessage << Qt::endl;
+void Logger::enqueue(Entry &&entry)
+{
+    bool urgent = entry.level == LogLevel::Error;
+    Shard &shard = currentShard();
+    {
+        QMutexLocker locker(&shard.mutex);
+        entry.sequence = sequence_.fetch_add(1, std::memory_order_relaxed);
+        shard.entries.push_back(std::move(entry));
     }
 
-    if (consoleOutputEnabled_) {
-        std::cout << formattedMessage.toStdString() << std::endl;
+    if (urgent) {
+        wakeWriter_.wakeOne();
     }
 }
 
+void Logger::configure(const Settings &settings)
+{
+    flushIntervalMs_ = qMax(1, settings.flushIntervalMs);
+    queueCapacity_ = qMax(1, settings.queueCapacity);
+    overflowPolicy_ = settings.overflowPolicy;
+}
+
 void Logger::setLogFile(const QString &filePath)
 {
-    QMutexLocker locker(&mutex_);
+    flush();
 
-    if(logFile_.isOpen()) {
+    QMutexLocker locker(&fileMutex_);
+
+    if (logFile_.isOpen()) {
         logFile_.close();
     }
 
     logFile_.setFileName(filePath);
 
-    if (logFile_.open(QIODevice::WriteOnly | QIODevice::Append)) {
-        logStream_.setDevice(&logFile_);
-    } else {
+    if (!logFile_.open(QIODevice::WriteOnly | QIODevice::Append)) {
         qWarning() << "Failed to open log file:" << filePath;
     }
 }
@@ -59,18 +148,122 @@ void Logger::setLogLevel(LogLevel level)
     currentLogLevel_ = level;
 }
 
-QString Logger::formatMessage(const QString &message, LogLevel level)
+void Logger::flush()
 {
-    QString levelStr;
-    switch (level) {
-        case LogLevel::Info: levelStr = "INFO"; break;
-        case LogLevel::Warning: levelStr = "WARNING"; break;
-        case LogLevel::Error: levelStr = "ERROR"; break;
-        case LogLevel::Debug: levelStr = "DEBUG"; break;
+    if (QThread::currentThread() == writer_.get()) {
+        return;
     }
 
-    return QString("[%1] [%2] %3")
-        .arg(QDateTime::currentDateTime()
-        .toString("dd-MM-yyyy HH:mm::ss"))
-        .arg(levelStr).arg(message);
+    quint64 target = sequence_.load(std::memory_order_relaxed);
+    QMutexLocker locker(&flowMutex_);
+    while (writtenCount_ < target && !stopping_) {
+        wakeWriter_.wakeOne();
+        flushed_.wait(&flowMutex_, 100);
+    }
+}
+
+void Logger::run()
+{
+    std::vector<Entry> batch;
+    for (;;) {
+        bool stopping;
+        {
+            QMutexLocker locker(&flowMutex_);
+            if (!stopping_) {
+                wakeWriter_.wait(&flowMutex_, flushIntervalMs_.load(std::memory_order_relaxed));
+            }
+            stopping = stopping_;
+        }
+
+        drain(batch);
+        quint64 dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        if (!batch.empty() || dropped > 0) {
+            write(batch, dropped);
+        }
+
+        {
+            QMutexLocker locker(&flowMutex_);
+            writtenCount_ += batch.size();
+            spaceAvailable_.wakeAll();
+            flushed_.wakeAll();
+        }
+        batch.clear();
+
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void Logger::drain(std::vector<Entry> &batch)
+{
+    for (Shard &shard : shards_) {
+        QMutexLocker locker(&shard.mutex);
+        if (shard.entries.empty()) {
+            continue;
+        }
+        batch.insert(batch.end(), std::make_move_iterator(shard.entries.begin()),
+                     std::make_move_iterator(shard.entries.end()));
+        shard.entries.clear();
+    }
+    queued_.fetch_sub(qint64(batch.size()), std::memory_order_relaxed);
+
+    std::sort(batch.begin(), batch.end(), [](const Entry &a, const Entry &b) {
+        return a.sequence < b.sequence;
+    });
+}
+
+void Logger::write(const std::vector<Entry> &batch, quint64 dropped)
+{
+    QByteArray out;
+    out.reserve(qsizetype(batch.size()) * 96 + 64);
+
+    auto appendLine = [&](qint64 timestampMs, LogLevel level, const QString &message) {
+        // Every line of a busy second shares the same stamp; format it once.
+        qint64 second = timestampMs / 1000;
+        if (second != lastStampSecond_) {
+            lastStampSecond_ = second;
+            lastStamp_ = QDateTime::fromSecsSinceEpoch(second).toString("dd-MM-yyyy HH:mm:ss").toUtf8();
+        }
+        out.append('[').append(lastStamp_).append("] [").append(levelName(level)).append("] ");
+        out.append(message.toUtf8()).append('\n');
+    };
+
+    auto appendStructured = [&](const Entry &entry) {
+        qint64 second = entry.timestampMs / 1000;
+        if (second != lastIsoSecond_) {
+            lastIsoSecond_ = second;
+            lastIsoStamp_ = QDateTime::fromSecsSinceEpoch(second, QTimeZone::UTC).toString(Qt::ISODate).toUtf8();
+            lastIsoStamp_.chop(1);   // The trailing Z goes after the milliseconds
+        }
+        char millis[8];
+        std::snprintf(millis, sizeof(millis), ".%03dZ", int(entry.timestampMs % 1000));
+        out.append("{\"ts\":\"").append(lastIsoStamp_).append(millis).append("\",\"level\":\"");
+        out.append(levelName(entry.level)).append("\",").append(entry.fields).append("}\n");
+    };
+
+    for (const Entry &entry : batch) {
+        if (entry.fields.isEmpty()) {
+            appendLine(entry.timestampMs, entry.level, entry.message);
+        } else {
+            appendStructured(entry);
+        }
+    }
+    if (dropped > 0) {
+        appendLine(QDateTime::currentMSecsSinceEpoch(), LogLevel::Warning,
+                   QString("Logger: queue full, dropped %1 message(s)").arg(dropped));
+    }
+
+    {
+        QMutexLocker locker(&fileMutex_);
+        if (logFile_.isOpen()) {
+            logFile_.write(out);
+            logFile_.flush();
+        }
+    }
+
+    if (consoleOutputEnabled_.load(std::memory_order_relaxed)) {
+        std::fwrite(out.constData(), 1, size_t(out.size()), stdout);
+        std::fflush(stdout);
+    }
 }
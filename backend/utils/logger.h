@@ -3,23 +3,56 @@
 
 #include <QString>
 #include <QFile>
-#include <QTextStream>
 #include <QDateTime>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
 
+// Writes log lines from a background thread. log() checks the level before doing any work,
+// then only stamps the message and appends it to one of several independently locked queues;
+// the writer drains them every flushIntervalMs, formats the batch and writes it with one
+// write (and one flush) per output.
 class Logger
 {
 public:
     enum class LogLevel { Info, Warning, Error, Debug };
 
+    enum class OverflowPolicy {
+        Drop,    // Discard new messages while the queue is full and report how many were lost
+        Block    // Make the logging thread wait for the writer
+    };
+
+    struct Settings {
+        int flushIntervalMs = 200;
+        int queueCapacity = 65536;
+        OverflowPolicy overflowPolicy = OverflowPolicy::Drop;
+    };
+
     static Logger& instance();
 
+    // Cheap enough to guard building an expensive message.
+    bool isEnabled(LogLevel level) const
+    {
+        return severity(level) >= severity(currentLogLevel_.load(std::memory_order_relaxed));
+    }
+
     void log(const QString& message, LogLevel level = LogLevel::Info);
+    // Queues one JSON line: timestamp and level followed by `fields`, the comma-separated
+    // members LogEvent built. The level is not checked again.
+    void logStructured(QByteArray fields, LogLevel level);
 
+    void configure(const Settings& settings);
     void setLogFile(const QString& filePath);
     void enableConsoleOutput(bool enabled);
     void setLogLevel(LogLevel level);
 
+    // Blocks until everything logged so far has been written.
+    void flush();
+
 private:
     Logger();
     ~Logger();
@@ -27,13 +60,62 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    QString formatMessage(const QString& message, LogLevel level);
+    struct Entry {
+        quint64 sequence;
+        qint64 timestampMs;
+        LogLevel level;
+        QString message;
+        QByteArray fields;      // Set for structured entries, which have no message
+    };
+
+    struct Shard {
+        QMutex mutex;
+        std::vector<Entry> entries;
+    };
+
+    static constexpr int shardCount = 8;
 
+    static int severity(LogLevel level);
+    static const char* levelName(LogLevel level);
+
+    Shard& currentShard();
+    // Waits for or refuses room in the queue according to the overflow policy.
+    bool reserveSlot();
+    void enqueue(Entry&& entry);
+    void run();
+    // Moves every queued entry into `batch`, in the order they were logged.
+    void drain(std::vector<Entry>& batch);
+    void write(const std::vector<Entry>& batch, quint64 dropped);
+
+    std::array<Shard, shardCount> shards_;
+    std::atomic<quint64> sequence_ {0};
+    std::atomic<int> nextShard_ {0};
+    std::atomic<qint64> queued_ {0};
+    std::atomic<quint64> dropped_ {0};
+
+    std::atomic<LogLevel> currentLogLevel_;
+    std::atomic<bool> consoleOutputEnabled_;
+    std::atomic<int> flushIntervalMs_;
+    std::atomic<int> queueCapacity_;
+    std::atomic<OverflowPolicy> overflowPolicy_;
+
+    // Wakes the writer early and lets blocked producers wait for room.
+    QMutex flowMutex_;
+    QWaitCondition wakeWriter_;
+    QWaitCondition spaceAvailable_;
+    QWaitCondition flushed_;
+    quint64 writtenCount_ = 0;      // Entries written so far, compared against sequence_
+    bool stopping_ = false;
+
+    // Owned by the writer thread once it runs; setLogFile() takes fileMutex_.
+    QMutex fileMutex_;
     QFile logFile_;
-    QTextStream logStream_;
-    QMutex mutex_;
-    bool consoleOutputEnabled_;
-    LogLevel currentLogLevel_;
+    qint64 lastStampSecond_ = -1;
+    QByteArray lastStamp_;
+    qint64 lastIsoSecond_ = -1;
+    QByteArray lastIsoStamp_;
+
+    std::unique_ptr<QThread> writer_;
 };
 
 #endif // LOGGER_H
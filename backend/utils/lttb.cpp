@@ -0,0 +1,170 @@
+#include "lttb.h"
+#include <cmath>
+#include <utility>
+
+namespace {
+double y(const MeasurementPoint &point)
+{
+    return point.value.value_or(0.0);
+}
+}
+
+LttbDownsampler::LttbDownsampler(int threshold, qint64 endUs)
+    : threshold_(qMax(3, threshold)), endUs_(endUs)
+{
+    output_.reserve(threshold_);
+}
+
+void LttbDownsampler::add(const MeasurementPoint &point)
+{
+    ++inputCount_;
+    if (inputCount_ <= threshold_) {
+        raw_.append(point);
+        return;
+    }
+
+    // The series turned out longer than the threshold: replay what was buffered.
+    if (!raw_.isEmpty()) {
+        const QList<MeasurementPoint> buffered = std::move(raw_);
+        raw_.clear();
+        for (const MeasurementPoint &bufferedPoint : buffered) {
+            stream(bufferedPoint);
+        }
+    }
+    stream(point);
+}
+
+QList<MeasurementPoint> LttbDownsampler::takeSelected()
+{
+    QList<MeasurementPoint> selected;
+    selected.swap(output_);
+    return selected;
+}
+
+QList<MeasurementPoint> LttbDownsampler::finish()
+{
+    if (!started_) {
+        return std::exchange(raw_, {});
+    }
+
+    const MeasurementPoint last = *held_;
+    if (current_.count > 0) {
+        if (next_.count > 0) {
+            selectFrom(current_, next_.sumX / next_.count, next_.sumY / next_.count);
+            selectFrom(next_, x(last), y(last));
+        } else {
+            selectFrom(current_, x(last), y(last));
+        }
+    }
+    output_.append(last);
+    return std::exchange(output_, {});
+}
+
+qint64 LttbDownsampler::inputCount() const
+{
+    return inputCount_;
+}
+
+void LttbDownsampler::stream(const MeasurementPoint &point)
+{
+    if (!started_) {
+        started_ = true;
+        originUs_ = point.recordedAtUs;
+        bucketWidthUs_ = qMax<double>(1.0, double(endUs_ - originUs_) / (threshold_ - 2));
+        output_.append(point);
+        anchor_ = point;
+        return;
+    }
+
+    if (held_) {
+        addToBuckets(*held_);
+    }
+    held_ = point;
+}
+
+void LttbDownsampler::addToBuckets(const MeasurementPoint &point)
+{
+    int index = qBound(0, int(x(point) / bucketWidthUs_), threshold_ - 3);
+
+    if (current_.index < 0 || index == current_.index) {
+        current_.index = index;
+        addToBucket(current_, point);
+        return;
+    }
+    if (next_.index < 0 || index == next_.index) {
+        next_.index = index;
+        addToBucket(next_, point);
+        return;
+    }
+
+    // A third bucket has started, so the next one is complete and the current one can be decided.
+    selectFrom(current_, next_.sumX / next_.count, next_.sumY / next_.count);
+    current_ = std::move(next_);
+    next_ = Bucket();
+    next_.index = index;
+    addToBucket(next_, point);
+}
+
+void LttbDownsampler::addToBucket(Bucket &bucket, const MeasurementPoint &point) const
+{
+    double px = x(point);
+    double py = y(point);
+    bucket.sumX += px;
+    bucket.sumY += py;
+    ++bucket.count;
+
+    // Monotone chain: points arrive sorted by x, so both hull halves are maintained incrementally.
+    auto cross = [this, px, py](const MeasurementPoint &o, const MeasurementPoint &a) {
+        return (x(a) - x(o)) * (py - y(o)) - (y(a) - y(o)) * (px - x(o));
+    };
+    // Readings sharing a timestamp keep only the lowest (lower half) or highest (upper half) one.
+    bool addLower = bucket.lower.isEmpty() || x(bucket.lower.last()) != px || py < y(bucket.lower.last());
+    if (addLower) {
+        if (!bucket.lower.isEmpty() && x(bucket.lower.last()) == px) {
+            bucket.lower.removeLast();
+        }
+        while (bucket.lower.size() >= 2 && cross(bucket.lower.at(bucket.lower.size() - 2), bucket.lower.last()) <= 0) {
+            bucket.lower.removeLast();
+        }
+        bucket.lower.append(point);
+    }
+
+    bool addUpper = bucket.upper.isEmpty() || x(bucket.upper.last()) != px || py > y(bucket.upper.last());
+    if (addUpper) {
+        if (!bucket.upper.isEmpty() && x(bucket.upper.last()) == px) {
+            bucket.upper.removeLast();
+        }
+        while (bucket.upper.size() >= 2 && cross(bucket.upper.at(bucket.upper.size() - 2), bucket.upper.last()) >= 0) {
+            bucket.upper.removeLast();
+        }
+        bucket.upper.append(point);
+    }
+}
+
+void LttbDownsampler::selectFrom(const Bucket &bucket, double cx, double cy)
+{
+    double ax = x(anchor_);
+    double ay = y(anchor_);
+    const MeasurementPoint *best = nullptr;
+    double bestArea = -1;
+
+    for (const QList<MeasurementPoint> *hull : {&bucket.lower, &bucket.upper}) {
+        for (const MeasurementPoint &candidate : *hull) {
+            double area = std::abs((x(candidate) - ax) * (cy - ay) - (cx - ax) * (y(candidate) - ay));
+            if (area > bestArea || (area == bestArea && candidate.recordedAtUs < best->recordedAtUs)) {
+                bestArea = area;
+                best = &candidate;
+            }
+        }
+    }
+
+    if (best) {
+        output_.append(*best);
+        anchor_ = *best;
+    }
+}
+
+double LttbDownsampler::x(const MeasurementPoint &point) const
+{
+    return double(point.recordedAtUs - originUs_);
+}
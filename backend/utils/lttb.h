@@ -0,0 +1,64 @@
+#ifndef LTTB_H
+#define LTTB_H
+
+#include <QList>
+#include <optional>
+#include "../models/measurementpoint.h"
+
+// Largest-Triangle-Three-Buckets downsampling over a time-ordered stream of points.
+//
+// The first and last points are always kept; the span between them is split into
+// threshold - 2 equal time buckets and each non-empty bucket contributes the point that forms
+// the largest triangle with the point chosen before it and the average of the next non-empty
+// bucket. That area is the absolute value of an affine function of the candidate, so its
+// maximum lies on the bucket's convex hull: only the hulls of the two open buckets are kept
+// rather than all of their rows. Hulls of noisy data stay small, but a convex run (a steady
+// ramp, say) can put every row of a bucket on it, so memory is O(bucket size) in the worst
+// case. Output is at most `threshold` points.
+class LttbDownsampler
+{
+public:
+    // endUs is the end of the requested range; buckets span from the first point to it.
+    LttbDownsampler(int threshold, qint64 endUs);
+
+    // Points must arrive in ascending recordedAtUs order and carry a value.
+    void add(const MeasurementPoint &point);
+    // Hands over the points selected so far, so output can be written while input still arrives.
+    QList<MeasurementPoint> takeSelected();
+    // Returns the points not yet taken, ending with the last input point.
+    QList<MeasurementPoint> finish();
+
+    qint64 inputCount() const;
+
+private:
+    struct Bucket {
+        int index = -1;
+        QList<MeasurementPoint> lower;
+        QList<MeasurementPoint> upper;
+        double sumX = 0;
+        double sumY = 0;
+        qint64 count = 0;
+    };
+
+    void stream(const MeasurementPoint &point);
+    void addToBuckets(const MeasurementPoint &point);
+    void addToBucket(Bucket &bucket, const MeasurementPoint &point) const;
+    void selectFrom(const Bucket &bucket, double cx, double cy);
+    double x(const MeasurementPoint &point) const;
+
+    int threshold_;
+    qint64 endUs_;
+    qint64 inputCount_ = 0;
+    bool started_ = false;
+    qint64 originUs_ = 0;
+    double bucketWidthUs_ = 1;
+
+    QList<MeasurementPoint> raw_;            // Input so far while it still fits under the threshold
+    std::optional<MeasurementPoint> held_;   // Latest point, kept out of the buckets in case it is the last
+    MeasurementPoint anchor_;                // Point chosen from the previous bucket
+    Bucket current_;
+    Bucket next_;
+    QList<MeasurementPoint> output_;
+};
+
+#endif // LTTB_H
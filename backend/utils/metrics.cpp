@@ -0,0 +1,296 @@
+#include "metrics.h"
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Threads are spread over the cells of a series round-robin; two threads sharing a cell only
+// share a cache line, never a lost update.
+size_t threadStripe()
+{
+    static std::atomic<size_t> nextStripe {0};
+    thread_local size_t stripe = nextStripe.fetch_add(1, std::memory_order_relaxed);
+    return stripe;
+}
+
+QByteArray formatNumber(double value)
+{
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    return QByteArray::number(value, 'g', 15);
+}
+
+QByteArray escapeLabelValue(const QByteArray &value)
+{
+    QByteArray escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped.append('\\').append(c);
+        } else if (c == '\n') {
+            escaped.append("\\n");
+        } else {
+            escaped.append(c);
+        }
+    }
+    return escaped;
+}
+
+QByteArray renderLabels(const MetricsRegistry::Labels &labels)
+{
+    if (labels.isEmpty()) {
+        return QByteArray();
+    }
+    QByteArray rendered("{");
+    for (qsizetype i = 0; i < labels.size(); ++i) {
+        if (i > 0) {
+            rendered.append(',');
+        }
+        rendered.append(labels.at(i).first).append("=\"").append(escapeLabelValue(labels.at(i).second)).append('"');
+    }
+    return rendered.append('}');
+}
+
+// Adds one more label to an already rendered set, for the histogram's le.
+QByteArray withLabel(const QByteArray &labels, const QByteArray &name, const QByteArray &value)
+{
+    QByteArray pair = name + "=\"" + value + '"';
+    if (labels.isEmpty()) {
+        return '{' + pair + '}';
+    }
+    return labels.left(labels.size() - 1) + ',' + pair + '}';
+}
+
+}
+
+void MetricsRegistry::Counter::increment(quint64 amount)
+{
+    cells_[threadStripe() % cells_.size()].value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+quint64 MetricsRegistry::Counter::value() const
+{
+    quint64 total = 0;
+    for (const Cell &cell : cells_) {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void MetricsRegistry::Gauge::set(double value)
+{
+    value_.store(value, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::Gauge::add(double amount)
+{
+    double current = value_.load(std::memory_order_relaxed);
+    while (!value_.compare_exchange_weak(current, current + amount, std::memory_order_relaxed)) {
+    }
+}
+
+double MetricsRegistry::Gauge::value() const
+{
+    return value_.load(std::memory_order_relaxed);
+}
+
+namespace {
+constexpr size_t histogramStripes = 16;
+constexpr size_t cellsPerCacheLine = 64 / sizeof(std::atomic<quint64>);
+}
+
+MetricsRegistry::Histogram::Histogram(const std::vector<double> &bounds)
+    : bounds_(bounds)
+{
+    std::sort(bounds_.begin(), bounds_.end());
+    bounds_.erase(std::unique(bounds_.begin(), bounds_.end()), bounds_.end());
+    for (double bound : bounds_) {
+        boundsNs_.push_back(qint64(std::llround(bound * 1e9)));
+    }
+
+    // Per stripe: one cell per bound, one for +Inf and one for the sum in nanoseconds.
+    size_t used = bounds_.size() + 2;
+    stride_ = (used + cellsPerCacheLine - 1) / cellsPerCacheLine * cellsPerCacheLine;
+    size_t cellCount = stride_ * histogramStripes;
+    cells_ = std::make_unique<std::atomic<quint64>[]>(cellCount);
+    for (size_t i = 0; i < cellCount; ++i) {
+        cells_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricsRegistry::Histogram::observeNs(qint64 nanoseconds)
+{
+    nanoseconds = qMax<qint64>(0, nanoseconds);
+    size_t bucket = size_t(std::lower_bound(boundsNs_.begin(), boundsNs_.end(), nanoseconds) - boundsNs_.begin());
+    std::atomic<quint64> *stripe = &cells_[(threadStripe() % histogramStripes) * stride_];
+    stripe[bucket].fetch_add(1, std::memory_order_relaxed);
+    stripe[bounds_.size() + 1].fetch_add(quint64(nanoseconds), std::memory_order_relaxed);
+}
+
+MetricsRegistry::Histogram::Snapshot MetricsRegistry::Histogram::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.bounds = bounds_;
+    snapshot.cumulative.assign(bounds_.size() + 1, 0);
+    quint64 sumNs = 0;
+    for (size_t s = 0; s < histogramStripes; ++s) {
+        const std::atomic<quint64> *stripe = &cells_[s * stride_];
+        for (size_t b = 0; b <= bounds_.size(); ++b) {
+            snapshot.cumulative[b] += stripe[b].load(std::memory_order_relaxed);
+        }
+        sumNs += stripe[bounds_.size() + 1].load(std::memory_order_relaxed);
+    }
+    for (size_t b = 1; b < snapshot.cumulative.size(); ++b) {
+        snapshot.cumulative[b] += snapshot.cumulative[b - 1];
+    }
+    snapshot.count = snapshot.cumulative.back();
+    snapshot.sumSeconds = double(sumNs) / 1e9;
+    return snapshot;
+}
+
+MetricsRegistry &MetricsRegistry::instance()
+{
+    static MetricsRegistry registryInstance;
+    return registryInstance;
+}
+
+const std::vector<double> &MetricsRegistry::defaultLatencyBounds()
+{
+    static const std::vector<double> bounds {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+                                             0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+    return bounds;
+}
+
+MetricsRegistry::Series &MetricsRegistry::seriesFor(const QByteArray &name, const QByteArray &help, Type type,
+                                                     const Labels &labels)
+{
+    QByteArray rendered = renderLabels(labels);
+
+    auto family = std::find_if(families_.begin(), families_.end(), [&](const std::unique_ptr<Family> &f) {
+        return f->name == name;
+    });
+    if (family == families_.end()) {
+        families_.push_back(std::make_unique<Family>(Family{name, help, type, {}}));
+        family = families_.end() - 1;
+    }
+    Q_ASSERT((*family)->type == type);
+
+    for (const std::unique_ptr<Series> &series : (*family)->series) {
+        if (series->labels == rendered) {
+            return *series;
+        }
+    }
+    (*family)->series.push_back(std::make_unique<Series>());
+    Series &series = *(*family)->series.back();
+    series.labels = rendered;
+    return series;
+}
+
+MetricsRegistry::Counter &MetricsRegistry::counter(const QByteArray &name, const QByteArray &help, const Labels &labels)
+{
+    QMutexLocker locker(&mutex_);
+    Series &series = seriesFor(name, help, Type::Counter, labels);
+    if (!series.counter) {
+        series.counter = std::make_unique<Counter>();
+    }
+    return *series.counter;
+}
+
+MetricsRegistry::Gauge &MetricsRegistry::gauge(const QByteArray &name, const QByteArray &help, const Labels &labels)
+{
+    QMutexLocker locker(&mutex_);
+    Series &series = seriesFor(name, help, Type::Gauge, labels);
+    if (!series.gauge) {
+        series.gauge = std::make_unique<Gauge>();
+    }
+    return *series.gauge;
+}
+
+MetricsRegistry::Histogram &MetricsRegistry::histogram(const QByteArray &name, const QByteArray &help,
+                                                       const Labels &labels, const std::vector<double> &bounds)
+{
+    QMutexLocker locker(&mutex_);
+    Series &series = seriesFor(name, help, Type::Histogram, labels);
+    if (!series.histogram) {
+        series.histogram = std::make_unique<Histogram>(bounds);
+    }
+    return *series.histogram;
+}
+
+void MetricsRegistry::gaugeCallback(const QByteArray &name, const QByteArray &help, const Labels &labels,
+                                    std::function<double()> read)
+{
+    QMutexLocker locker(&mutex_);
+    seriesFor(name, help, Type::Gauge, labels).read = std::move(read);
+}
+
+void MetricsRegistry::counterCallback(const QByteArray &name, const QByteArray &help, const Labels &labels,
+                                      std::function<double()> read)
+{
+    QMutexLocker locker(&mutex_);
+    seriesFor(name, help, Type::Counter, labels).read = std::move(read);
+}
+
+QByteArray MetricsRegistry::scrape() const
+{
+    QMutexLocker locker(&mutex_);
+    QByteArray out;
+    out.reserve(16 * 1024);
+
+    for (const std::unique_ptr<Family> &family : families_) {
+        const char *type = family->type == Type::Counter ? "counter"
+                           : family->type == Type::Gauge ? "gauge"
+                                                         : "histogram";
+        out.append("# HELP ").append(family->name).append(' ').append(family->help).append('\n');
+        out.append("# TYPE ").append(family->name).append(' ').append(type).append('\n');
+
+        for (const std::unique_ptr<Series> &series : family->series) {
+            if (series->read) {
+                out.append(family->name).append(series->labels).append(' ')
+                    .append(formatNumber(series->read())).append('\n');
+            } else if (series->counter) {
+                out.append(family->name).append(series->labels).append(' ')
+                    .append(QByteArray::number(series->counter->value())).append('\n');
+            } else if (series->gauge) {
+                out.append(family->name).append(series->labels).append(' ')
+                    .append(formatNumber(series->gauge->value())).append('\n');
+            } else if (series->histogram) {
+                Histogram::Snapshot snapshot = series->histogram->snapshot();
+                for (size_t b = 0; b < snapshot.cumulative.size(); ++b) {
+                    QByteArray le = b < snapshot.bounds.size() ? formatNumber(snapshot.bounds[b]) : QByteArray("+Inf");
+                    out.append(family->name).append("_bucket").append(withLabel(series->labels, "le", le)).append(' ')
+                        .append(QByteArray::number(snapshot.cumulative[b])).append('\n');
+                }
+                out.append(family->name).append("_sum").append(series->labels).append(' ')
+                    .append(formatNumber(snapshot.sumSeconds)).append('\n');
+                out.append(family->name).append("_count").append(series->labels).append(' ')
+                    .append(QByteArray::number(snapshot.count)).append('\n');
+            }
+        }
+    }
+    return out;
+}
+
+namespace {
+MetricsRegistry::Histogram &dbQueryHistogram(const char *method)
+{
+    thread_local QHash<const char *, MetricsRegistry::Histogram *> cache;
+    MetricsRegistry::Histogram *&histogram = cache[method];
+    if (!histogram) {
+        histogram = &MetricsRegistry::instance().histogram("arkanova_db_query_duration_seconds",
+                                                           "Time spent in a repository method, by method.",
+                                                           {{"method", method}});
+    }
+    return *histogram;
+}
+}
+
+DbQueryTimer::DbQueryTimer(const char *method)
+    : timer_(dbQueryHistogram(method))
+{
+}
@@ -0,0 +1,151 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Process-wide registry of counters, gauges and duration histograms, rendered in the
+// Prometheus text format by scrape(). Series are created once, usually into a function-local
+// static, and updated without locks: counters and histograms are split into cache-line
+// sized cells, one per thread stripe, that scrape() adds up.
+class MetricsRegistry
+{
+public:
+    using Labels = QList<QPair<QByteArray, QByteArray>>;
+
+    class Counter
+    {
+    public:
+        void increment(quint64 amount = 1);
+        quint64 value() const;
+
+    private:
+        struct alignas(64) Cell {
+            std::atomic<quint64> value {0};
+        };
+        std::array<Cell, 16> cells_;
+    };
+
+    class Gauge
+    {
+    public:
+        void set(double value);
+        void add(double amount);
+        double value() const;
+
+    private:
+        std::atomic<double> value_ {0};
+    };
+
+    // Durations only; bucket bounds are in seconds.
+    class Histogram
+    {
+    public:
+        explicit Histogram(const std::vector<double>& bounds);
+
+        void observeNs(qint64 nanoseconds);
+
+        struct Snapshot {
+            std::vector<double> bounds;
+            std::vector<quint64> cumulative;   // One per bound, then +Inf
+            quint64 count = 0;
+            double sumSeconds = 0;
+        };
+        Snapshot snapshot() const;
+
+    private:
+        std::vector<qint64> boundsNs_;
+        std::vector<double> bounds_;
+        size_t stride_;   // Buckets, +Inf and the sum, rounded up to whole cache lines
+        std::unique_ptr<std::atomic<quint64>[]> cells_;
+    };
+
+    // Observes the lifetime of the object into a histogram.
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram& histogram)
+            : histogram_(histogram), start_(std::chrono::steady_clock::now())
+        {
+        }
+        ~ScopedTimer()
+        {
+            histogram_.observeNs(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start_).count());
+        }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Histogram& histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    static MetricsRegistry& instance();
+
+    // Latency buckets from 0.5 ms to 10 s.
+    static const std::vector<double>& defaultLatencyBounds();
+
+    // Each returns the series already registered under the same name and labels, if any.
+    Counter& counter(const QByteArray& name, const QByteArray& help, const Labels& labels = {});
+    Gauge& gauge(const QByteArray& name, const QByteArray& help, const Labels& labels = {});
+    Histogram& histogram(const QByteArray& name, const QByteArray& help, const Labels& labels = {},
+                         const std::vector<double>& bounds = defaultLatencyBounds());
+    // Series whose value is read at scrape time, for totals and levels other components already
+    // keep. `read` runs on the scraping thread with the registry locked.
+    void gaugeCallback(const QByteArray& name, const QByteArray& help, const Labels& labels,
+                       std::function<double()> read);
+    void counterCallback(const QByteArray& name, const QByteArray& help, const Labels& labels,
+                         std::function<double()> read);
+
+    QByteArray scrape() const;
+
+private:
+    MetricsRegistry() = default;
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Series {
+        QByteArray labels;   // Rendered as {a="b",...}, or empty
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> read;
+    };
+
+    struct Family {
+        QByteArray name;
+        QByteArray help;
+        Type type;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    Series& seriesFor(const QByteArray& name, const QByteArray& help, Type type, const Labels& labels);
+
+    mutable QMutex mutex_;
+    std::vector<std::unique_ptr<Family>> families_;
+};
+
+// Times a repository method into arkanova_db_query_duration_seconds{method="..."}. `method`
+// must be a string literal: series are cached per thread by its address.
+class DbQueryTimer
+{
+public:
+    explicit DbQueryTimer(const char* method);
+
+private:
+    MetricsRegistry::ScopedTimer timer_;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,107 @@
+#include "packedseries.h"
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+
+const QByteArray PackedSeriesWriter::contentType = "application/vnd.arkanova.series";
+
+namespace {
+template <typename T>
+void appendLittleEndian(QByteArray &out, T value)
+{
+    char bytes[sizeof(T)];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, sizeof(T));
+}
+}
+
+PackedSeriesWriter::PackedSeriesWriter(const QList<Column> &columns)
+    : columns_(columns), staged_(columns.size())
+{
+}
+
+bool PackedSeriesWriter::isAccepted(const QByteArray &acceptHeader)
+{
+    for (const QByteArray &range : acceptHeader.split(',')) {
+        QList<QByteArray> parts = range.split(';');
+        if (parts.first().trimmed().toLower() != contentType) {
+            continue;
+        }
+
+        for (qsizetype i = 1; i < parts.size(); ++i) {
+            QByteArray parameter = parts.at(i).trimmed();
+            if (parameter.startsWith("q=")) {
+                bool ok;
+                double quality = parameter.mid(2).toDouble(&ok);
+                return ok && quality > 0;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+const QList<PackedSeriesWriter::Column> &PackedSeriesWriter::columns() const
+{
+    return columns_;
+}
+
+void PackedSeriesWriter::writeHeader(QByteArray &out) const
+{
+    qsizetype start = out.size();
+    out.append("ANS1");
+    appendLittleEndian<quint16>(out, quint16(columns_.size()));
+    appendLittleEndian<quint16>(out, 0);
+    for (const Column &column : columns_) {
+        out.append(char(column.type));
+        out.append(char(column.name.size()));
+        out.append(column.name);
+    }
+    while ((out.size() - start) % 8 != 0) {
+        out.append('\0');
+    }
+}
+
+void PackedSeriesWriter::appendInt64(int column, qint64 value)
+{
+    appendLittleEndian<qint64>(staged_[column], value);
+}
+
+void PackedSeriesWriter::appendFloat64(int column, std::optional<double> value)
+{
+    double number = value.value_or(std::numeric_limits<double>::quiet_NaN());
+    quint64 bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+    appendLittleEndian<quint64>(staged_[column], bits);
+}
+
+qsizetype PackedSeriesWriter::pendingRows() const
+{
+    return staged_.isEmpty() ? 0 : staged_.first().size() / 8;
+}
+
+void PackedSeriesWriter::writeBatch(QByteArray &out)
+{
+    qsizetype rows = pendingRows();
+    if (rows == 0) {
+        return;
+    }
+
+    out.reserve(out.size() + 8 + rows * 8 * staged_.size());
+    appendLittleEndian<quint32>(out, quint32(rows));
+    appendLittleEndian<quint32>(out, 0);
+    for (QByteArray &column : staged_) {
+        out.append(column);
+        column.resize(0);
+    }
+}
+
+void PackedSeriesWriter::writeEnd(QByteArray &out, const QByteArray &trailerJson)
+{
+    writeBatch(out);
+    appendLittleEndian<quint32>(out, 0);
+    appendLittleEndian<quint32>(out, 0);
+    appendLittleEndian<quint32>(out, quint32(trailerJson.size()));
+    appendLittleEndian<quint32>(out, 0);
+    out.append(trailerJson);
+}
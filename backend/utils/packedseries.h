@@ -0,0 +1,60 @@
+#ifndef PACKEDSERIES_H
+#define PACKEDSERIES_H
+
+#include <QByteArray>
+#include <QList>
+#include <optional>
+
+// Writer for application/vnd.arkanova.series, a columnar alternative to the JSON series bodies.
+// Everything is little-endian:
+//
+//   header   "ANS1", u16 column count, u16 reserved,
+//            per column: u8 type (1 = int64, 2 = float64), u8 name length, ASCII name,
+//            zero padding up to a multiple of 8 bytes
+//   batch    u32 row count, u32 reserved, then each column in header order as row count
+//            contiguous 8-byte values; missing float64 values are NaN
+//   end      a batch with row count 0, then u32 trailer length, u32 reserved and a UTF-8 JSON
+//            object with the same metadata the JSON body carries (total_count, next_cursor, ...)
+//
+// Because the header and every batch prefix are multiples of 8 bytes, each column starts
+// 8-byte aligned relative to the start of the body and can be viewed in place as an array.
+class PackedSeriesWriter
+{
+public:
+    static const QByteArray contentType;
+
+    enum class ColumnType : quint8 {
+        Int64 = 1,
+        Float64 = 2,
+    };
+
+    struct Column {
+        QByteArray name;
+        ColumnType type;
+    };
+
+    explicit PackedSeriesWriter(const QList<Column> &columns);
+
+    // True when the Accept header lists contentType with a non-zero quality.
+    static bool isAccepted(const QByteArray &acceptHeader);
+
+    const QList<Column> &columns() const;
+
+    void writeHeader(QByteArray &out) const;
+
+    // Values are staged per column until writeBatch(); every column must get one per row.
+    void appendInt64(int column, qint64 value);
+    void appendFloat64(int column, std::optional<double> value);
+    qsizetype pendingRows() const;
+
+    // Writes the staged rows as one batch; does nothing when no rows are staged.
+    void writeBatch(QByteArray &out);
+    // Writes any staged rows, the end marker and the trailer.
+    void writeEnd(QByteArray &out, const QByteArray &trailerJson);
+
+private:
+    QList<Column> columns_;
+    QList<QByteArray> staged_;
+};
+
+#endif // PACKEDSERIES_H
@@ -1,21 +1,65 @@
 #include "responsefactory.h"
 #include <QJsonObject> // Required for QJsonObject
 #include <QJsonDocument> // Required for QJsonDocument
+#include "httpcompression.h"
+#include <utility>
+
+namespace {
+// Accept-Encoding of the request whose handler is running on this thread.
+thread_local QByteArray currentAcceptEncoding;
+// Status of the last response ResponseFactory produced for that request.
+thread_local int currentStatusCode = 0;
+
+// Feeds the producer's output through a compressor in slices of about this many raw bytes,
+// sync-flushing after each so the client can decode every chunk as it arrives.
+constexpr qsizetype compressedSliceSize = 16 * 1024;
+
+using Header = std::pair<QByteArray, QByteArray>;
+
+// QHttpServerResponder only takes headers as an initializer list, so the optional ones are
+// spliced in here.
+template <typename... ExtraHeaders>
+void writeStream(QHttpServerResponder &responder, QIODevice *device, QHttpServerResponder::StatusCode statusCode,
+                 const QByteArray &contentType, const ExtraHeaders &...extraHeaders)
+{
+    responder.write(device,
+                    {Header("Content-Type", contentType),
+                     extraHeaders...,
+                     Header("Vary", "Accept, Accept-Encoding"),
+                     Header("Transfer-Encoding", "chunked"),
+                     Header("Access-Control-Allow-Origin", "*"),
+                     Header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, PATCH, OPTIONS"),
+                     Header("Access-Control-Allow-Headers", "Content-Type, Authorization, X-Requested-With"),
+                     Header("Access-Control-Max-Age", "86400")},
+                    statusCode);
+}
+}
+
+ResponseFactory::RequestScope::RequestScope(const HttpRequest &request)
+    : previousAcceptEncoding_(std::exchange(currentAcceptEncoding, request.value("Accept-Encoding"))),
+      previousStatusCode_(std::exchange(currentStatusCode, 0))
+{
+}
+
+ResponseFactory::RequestScope::~RequestScope()
+{
+    currentAcceptEncoding = std::move(previousAcceptEncoding_);
+    currentStatusCode = previousStatusCode_;
+}
+
+int ResponseFactory::RequestScope::statusCode() const
+{
+    return currentStatusCode;
+}
 
 QHttpServerResponse ResponseFactory::createResponse(const QString &content, QHttpServerResponse::StatusCode statusCode)
 {
-    QHttpServerResponse response(content.toUtf8(), statusCode); // Direct initialization
-    addCorsHeaders(response);
-    response.setHeader("Content-Type", "text/plain; charset=utf-8"); // Specify charset
-    return response;
+    return buildResponse("text/plain; charset=utf-8", content.toUtf8(), statusCode);
 }
 
 QHttpServerResponse ResponseFactory::createJsonResponse(const QByteArray &content, QHttpServerResponse::StatusCode statusCode)
 {
-    QHttpServerResponse response(content, statusCode); // Direct initialization
-    addCorsHeaders(response);
-    response.setHeader("Content-Type", "application/json; charset=utf-8"); // Specify charset
-    return response;
+    return buildResponse("application/json; charset=utf-8", content, statusCode);
 }
 
 // Implementation of the new method
@@ -31,6 +75,148 @@ QHttpServerResponse ResponseFactory::createErrorResponse(const QString &errorMes
     return createJsonResponse(jsonData, statusCode);
 }
 
+QHttpServerResponse ResponseFactory::createBinaryResponse(const QByteArray &content, const QByteArray &contentType,
+                                                          QHttpServerResponse::StatusCode statusCode)
+{
+    return buildResponse(contentType, content, statusCode, "Accept");
+}
+
+QHttpServerResponse ResponseFactory::buildResponse(const QByteArray &contentType, const QByteArray &content,
+                                                   QHttpServerResponse::StatusCode statusCode, const QByteArray &vary)
+{
+    currentStatusCode = int(statusCode);
+    bool compressible = HttpCompression::settings().enabled && HttpCompression::isCompressible(contentType);
+
+    auto encoding = HttpCompression::Encoding::Identity;
+    if (compressible && content.size() >= HttpCompression::settings().minSize) {
+        encoding = HttpCompression::negotiate(currentAcceptEncoding);
+    }
+
+    std::optional<QByteArray> compressed;
+    if (encoding != HttpCompression::Encoding::Identity) {
+        compressed = HttpCompression::compress(content, encoding);
+    }
+
+    QHttpServerResponse response(contentType, compressed ? *compressed : content, statusCode);
+    addCorsHeaders(response);
+    if (compressed) {
+        response.setHeader("Content-Encoding", HttpCompression::name(encoding));
+    }
+
+    QByteArray varyHeader = vary;
+    if (compressible) {
+        varyHeader.append(varyHeader.isEmpty() ? "Accept-Encoding" : ", Accept-Encoding");
+    }
+    if (!varyHeader.isEmpty()) {
+        response.setHeader("Vary", varyHeader);
+    }
+    return response;
+}
+
+void ResponseFactory::streamJsonResponse(StreamResponder &responder, JsonStreamDevice::Producer producer,
+                                         QHttpServerResponder::StatusCode statusCode, const QByteArray &etag)
+{
+    streamResponse(responder, "application/json; charset=utf-8", std::move(producer), statusCode, etag);
+}
+
+void ResponseFactory::streamResponse(StreamResponder &responder, const QByteArray &contentType,
+                                     JsonStreamDevice::Producer producer, QHttpServerResponder::StatusCode statusCode,
+                                     const QByteArray &etag)
+{
+    currentStatusCode = int(statusCode);
+
+    // Streamed bodies are list-sized, so the size threshold does not apply to them.
+    auto encoding = HttpCompression::Encoding::Identity;
+    if (HttpCompression::settings().enabled && HttpCompression::isCompressible(contentType)) {
+        encoding = HttpCompression::negotiate(currentAcceptEncoding);
+    }
+
+    auto compressor = std::make_shared<HttpCompression::Stream>(encoding);
+    if (compressor->isValid()) {
+        producer = [inner = std::move(producer), compressor, raw = std::make_shared<QByteArray>()](QByteArray& out) {
+            raw->resize(0);
+            bool more = true;
+            while (more && raw->size() < compressedSliceSize) {
+                more = inner(*raw);
+            }
+            compressor->append(out, *raw, !more);
+            return more;
+        };
+    }
+
+    // The head is written on the socket's thread. Without a Content-Length the responder copies
+    // the device's bytes verbatim, so the relayed chunks carry the chunked framing themselves.
+    bool compressed = compressor->isValid();
+    auto writeHead = [statusCode, contentType, etag, compressed, encoding](QHttpServerResponder &socketResponder,
+                                                                           QIODevice *device) {
+        Header contentEncoding("Content-Encoding", HttpCompression::name(encoding));
+        Header entityTagHeader("ETag", etag);
+        Header cacheControl("Cache-Control", "no-cache");
+        if (compressed && !etag.isEmpty()) {
+            writeStream(socketResponder, device, statusCode, contentType, contentEncoding, entityTagHeader, cacheControl);
+        } else if (compressed) {
+            writeStream(socketResponder, device, statusCode, contentType, contentEncoding);
+        } else if (!etag.isEmpty()) {
+            writeStream(socketResponder, device, statusCode, contentType, entityTagHeader, cacheControl);
+        } else {
+            writeStream(socketResponder, device, statusCode, contentType);
+        }
+    };
+    responder.stream(writeHead, std::move(producer));
+}
+
+QByteArray ResponseFactory::entityTag(const QByteArray &version)
+{
+    QByteArray tag = '"' + version;
+    auto encoding = HttpCompression::negotiate(currentAcceptEncoding);
+    if (encoding != HttpCompression::Encoding::Identity) {
+        tag.append('-').append(HttpCompression::name(encoding));
+    }
+    return tag.append('"');
+}
+
+bool ResponseFactory::isNotModified(const HttpRequest &request, const QByteArray &etag)
+{
+    QByteArray ifNoneMatch = request.value("If-None-Match").trimmed();
+    if (ifNoneMatch.isEmpty() || etag.isEmpty()) {
+        return false;
+    }
+    if (ifNoneMatch == "*") {
+        return true;
+    }
+
+    // If-None-Match uses the weak comparison, so a W/ prefix is ignored.
+    for (QByteArray candidate : ifNoneMatch.split(',')) {
+        candidate = candidate.trimmed();
+        if (candidate.startsWith("W/")) {
+            candidate = candidate.mid(2);
+        }
+        if (candidate == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QHttpServerResponse ResponseFactory::createNotModifiedResponse(const QByteArray &etag)
+{
+    currentStatusCode = int(QHttpServerResponse::StatusCode::NotModified);
+    QHttpServerResponse response(QHttpServerResponse::StatusCode::NotModified);
+    addCorsHeaders(response);
+    setEntityTag(response, etag);
+    response.setHeader("Vary", "Accept-Encoding");
+    return response;
+}
+
+void ResponseFactory::setEntityTag(QHttpServerResponse &response, const QByteArray &etag)
+{
+    if (etag.isEmpty()) {
+        return;
+    }
+    response.setHeader("ETag", etag);
+    response.setHeader("Cache-Control", "no-cache");
+}
+
 void ResponseFactory::addCorsHeaders(QHttpServerResponse &response)
 {
     response.setHeader("Access-Control-Allow-Origin", "*");
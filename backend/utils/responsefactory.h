@@ -2,13 +2,36 @@
 #define RESPONSEFACTORYH_H
 
 #include <QtHttpServer/QHttpServerResponse>
+#include <QtHttpServer/QHttpServerResponder>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QString> // Required for QString
+#include "jsonstreamdevice.h"
+#include "streamresponder.h"
+#include "httprequest.h"
 
 class ResponseFactory
 {
 public:
+    // Held by RouteFactory while a handler runs. Responses built on this thread in the meantime
+    // are compressed according to the request's Accept-Encoding.
+    class RequestScope
+    {
+    public:
+        explicit RequestScope(const HttpRequest &request);
+        ~RequestScope();
+        RequestScope(const RequestScope &) = delete;
+        RequestScope &operator=(const RequestScope &) = delete;
+
+        // Status of the last response built or streamed by ResponseFactory in this scope, 0 if
+        // none; how streaming routes learn what they answered.
+        int statusCode() const;
+
+    private:
+        QByteArray previousAcceptEncoding_;
+        int previousStatusCode_;
+    };
+
     static QHttpServerResponse createResponse(const QString &content, QHttpServerResponse::StatusCode statusCode);
 
     static QHttpServerResponse createJsonResponse(const QByteArray &content, QHttpServerResponse::StatusCode statusCode);
@@ -16,8 +39,35 @@ public:
     // New method for creating standardized JSON error responses
     static QHttpServerResponse createErrorResponse(const QString &errorMessage, QHttpServerResponse::StatusCode statusCode);
 
+    // Body in a negotiated non-JSON format such as PackedSeriesWriter::contentType.
+    static QHttpServerResponse createBinaryResponse(const QByteArray &content, const QByteArray &contentType,
+                                                    QHttpServerResponse::StatusCode statusCode);
+
+    // Writes a chunked JSON body pulled from the producer as the client reads it. The producer
+    // runs on the calling thread; returns once the body is written (see StreamResponder).
+    static void streamJsonResponse(StreamResponder &responder, JsonStreamDevice::Producer producer,
+                                   QHttpServerResponder::StatusCode statusCode, const QByteArray &etag = QByteArray());
+    static void streamResponse(StreamResponder &responder, const QByteArray &contentType,
+                               JsonStreamDevice::Producer producer, QHttpServerResponder::StatusCode statusCode,
+                               const QByteArray &etag = QByteArray());
+
+    // Strong entity tag for a representation version such as a row id or an updated_at stamp.
+    // The content coding negotiated for the current request is part of the tag, since the
+    // compressed and plain bodies differ byte for byte.
+    static QByteArray entityTag(const QByteArray &version);
+    // True when the request's If-None-Match lists `etag` (or is "*").
+    static bool isNotModified(const HttpRequest &request, const QByteArray &etag);
+    static QHttpServerResponse createNotModifiedResponse(const QByteArray &etag);
+    // Adds ETag and asks caches to revalidate before reusing the body.
+    static void setEntityTag(QHttpServerResponse &response, const QByteArray &etag);
+
     static void addCorsHeaders(QHttpServerResponse &response);
 private:
+    // Compresses bodies of at least HttpCompression::settings().minSize when the current request
+    // accepts it; `vary` lists the request headers other than Accept-Encoding the body depends on.
+    static QHttpServerResponse buildResponse(const QByteArray &contentType, const QByteArray &content,
+                                             QHttpServerResponse::StatusCode statusCode,
+                                             const QByteArray &vary = QByteArray());
 
 };
 
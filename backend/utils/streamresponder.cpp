@@ -0,0 +1,191 @@
+#include "streamresponder.h"
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QIODevice>
+#include <QList>
+#include <QMutex>
+#include <QTimer>
+#include <QWaitCondition>
+#include <cstring>
+
+namespace {
+
+// Chunks the producing thread may be ahead of the socket.
+constexpr qsizetype maxQueuedChunks = 2;
+
+void postToMainThread(std::function<void()> call)
+{
+    QMetaObject::invokeMethod(QCoreApplication::instance(), std::move(call), Qt::QueuedConnection);
+}
+
+class RelayDevice;
+
+// Framed chunks on their way from the producing thread to the device.
+struct Channel {
+    QMutex mutex;
+    QWaitCondition drained;
+    QList<QByteArray> chunks;
+    RelayDevice *device = nullptr;   // Set while the device exists
+    bool finished = false;           // The terminating chunk is queued
+    bool aborted = false;            // The device is gone, or the producer gave up waiting
+
+    // Tells the device there is something to read; the mutex must be held.
+    void notifyLocked();
+};
+
+// Sequential device on the socket's thread that hands out the chunks queued in a Channel.
+class RelayDevice : public QIODevice
+{
+public:
+    explicit RelayDevice(std::shared_ptr<Channel> channel) : channel_(std::move(channel))
+    {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+        QMutexLocker locker(&channel_->mutex);
+        channel_->device = this;
+        locker.unlock();
+        QTimer::singleShot(0, this, [this]() {
+            emit readyRead();
+        });
+    }
+
+    ~RelayDevice() override
+    {
+        QMutexLocker locker(&channel_->mutex);
+        channel_->device = nullptr;
+        channel_->aborted = true;
+        channel_->drained.wakeAll();
+    }
+
+    bool isSequential() const override
+    {
+        return true;
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        take();
+        return (current_.size() - readPos_) + QIODevice::bytesAvailable();
+    }
+
+    bool atEnd() const override
+    {
+        take();
+        if (readPos_ < current_.size()) {
+            return false;
+        }
+        QMutexLocker locker(&channel_->mutex);
+        return channel_->chunks.isEmpty() && (channel_->finished || channel_->aborted);
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        take();
+        qint64 count = qMin<qint64>(maxSize, current_.size() - readPos_);
+        if (count > 0) {
+            std::memcpy(data, current_.constData() + readPos_, count);
+            readPos_ += count;
+        }
+        return count;
+    }
+
+    qint64 writeData(const char *, qint64) override
+    {
+        return -1;
+    }
+
+private:
+    // Moves on to the next queued chunk once the current one has been read.
+    void take() const
+    {
+        if (readPos_ < current_.size()) {
+            return;
+        }
+        QMutexLocker locker(&channel_->mutex);
+        if (channel_->chunks.isEmpty()) {
+            return;
+        }
+        current_ = channel_->chunks.takeFirst();
+        readPos_ = 0;
+        channel_->drained.wakeAll();
+    }
+
+    std::shared_ptr<Channel> channel_;
+    mutable QByteArray current_;
+    mutable qsizetype readPos_ = 0;
+};
+
+void Channel::notifyLocked()
+{
+    if (device) {
+        // Posted while the mutex keeps the device alive; if it is deleted before the event is
+        // delivered, Qt drops the event with it.
+        RelayDevice *target = device;
+        QMetaObject::invokeMethod(target, [target]() {
+            emit target->readyRead();
+        }, Qt::QueuedConnection);
+    }
+}
+
+}
+
+struct StreamResponder::Target {
+    explicit Target(QHttpServerResponder &&responder) : responder(std::move(responder)) {}
+    QHttpServerResponder responder;
+};
+
+StreamResponder::StreamResponder(QHttpServerResponder &&responder)
+    : target_(new Target(std::move(responder)), [](Target *target) {
+          postToMainThread([target]() {
+              delete target;
+          });
+      })
+{
+}
+
+void StreamResponder::sendResponse(QHttpServerResponse &&response)
+{
+    auto shared = std::make_shared<QHttpServerResponse>(std::move(response));
+    postToMainThread([target = target_, shared]() {
+        target->responder.sendResponse(std::move(*shared));
+    });
+}
+
+bool StreamResponder::stream(HeadWriter writeHead, JsonStreamDevice::Producer producer, qsizetype chunkSize)
+{
+    auto channel = std::make_shared<Channel>();
+    // The responder takes ownership of the device.
+    postToMainThread([target = target_, channel, writeHead = std::move(writeHead)]() {
+        writeHead(target->responder, new RelayDevice(channel));
+    });
+
+    QByteArray body;
+    bool more = true;
+    while (more) {
+        body.resize(0);
+        while (more && body.size() < chunkSize) {
+            more = producer(body);
+        }
+        QByteArray framed;
+        framed.reserve(body.size() + 16);
+        JsonStreamDevice::appendChunk(framed, body, !more);
+
+        QMutexLocker locker(&channel->mutex);
+        QDeadlineTimer deadline(stallTimeoutMs);
+        while (channel->chunks.size() >= maxQueuedChunks && !channel->aborted) {
+            if (!channel->drained.wait(&channel->mutex, deadline)) {
+                // The client stopped reading; give the worker and its connection back.
+                channel->aborted = true;
+                channel->notifyLocked();
+                return false;
+            }
+        }
+        if (channel->aborted) {
+            return false;
+        }
+        channel->chunks.append(std::move(framed));
+        channel->finished = !more;
+        channel->notifyLocked();
+    }
+    return true;
+}
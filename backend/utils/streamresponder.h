@@ -0,0 +1,43 @@
+#ifndef STREAMRESPONDER_H
+#define STREAMRESPONDER_H
+
+#include <QtHttpServer/QHttpServerResponder>
+#include <QtHttpServer/QHttpServerResponse>
+#include <functional>
+#include <memory>
+#include "jsonstreamdevice.h"
+
+// Answers a streaming route from a thread other than the one that owns its socket.
+//
+// RouteFactory runs streaming handlers on stream workers that hold their own pooled
+// connection, so opening and walking a cursor never blocks the main loop. The responder stays
+// on the main thread: sendResponse() and the response head are posted there, and stream()
+// produces the body on the calling thread at most a couple of chunks ahead of the socket,
+// which reads them through a device on the main thread. stream() therefore returns only once
+// the body is complete, the client has gone, or the client stopped reading for
+// stallTimeoutMs; the cursor and the connection behind it stay on the worker throughout.
+class StreamResponder
+{
+public:
+    // Writes the response head on the socket's thread, with the device that carries the body.
+    using HeadWriter = std::function<void(QHttpServerResponder&, QIODevice*)>;
+
+    static constexpr int stallTimeoutMs = 60000;
+
+    // Must be constructed on the thread that owns the responder's socket.
+    explicit StreamResponder(QHttpServerResponder&& responder);
+
+    StreamResponder(const StreamResponder&) = delete;
+    StreamResponder& operator=(const StreamResponder&) = delete;
+
+    void sendResponse(QHttpServerResponse&& response);
+    // Blocks until the body is written; returns false if it was cut short.
+    bool stream(HeadWriter writeHead, JsonStreamDevice::Producer producer, qsizetype chunkSize = 16 * 1024);
+
+private:
+    struct Target;
+    // Deleted on the socket's thread whichever thread lets go of it last.
+    std::shared_ptr<Target> target_;
+};
+
+#endif // STREAMRESPONDER_H
@@ -49,21 +49,34 @@ SET default_table_access_method = heap;
 --
 
 CREATE TABLE public.measurement (
-    id integer NOT NULL,
-    data bytea NOT NULL,
-    recorded_at timestamp without time zone NOT NULL,
+    id bigint NOT NULL,
+    value double precision,
+    recorded_at timestamp without time zone DEFAULT CURRENT_TIMESTAMP NOT NULL,
     sensor_id integer NOT NULL
-);
+)
+PARTITION BY RANGE (recorded_at);
 
 
 ALTER TABLE public.measurement OWNER TO kirixo;
 
+--
+-- Name: measurement_default; Type: TABLE; Schema: public; Owner: kirixo
+--
+-- Catches rows outside every pre-created range; the backend's PartitionManager creates
+-- the measurement_pYYYYMM / measurement_pYYYYMMDD partitions ahead of time.
+--
+
+CREATE TABLE public.measurement_default PARTITION OF public.measurement DEFAULT;
+
+
+ALTER TABLE public.measurement_default OWNER TO kirixo;
+
 --
 -- Name: measurement_id_seq; Type: SEQUENCE; Schema: public; Owner: kirixo
 --
 
 CREATE SEQUENCE public.measurement_id_seq
-    AS integer
+    AS bigint
     START WITH 1
     INCREMENT BY 1
     NO MINVALUE
@@ -334,10 +347,18 @@ SELECT pg_catalog.setval('public.user_id_seq', 6, true);
 
 --
 -- Name: measurement measurement_pk; Type: CONSTRAINT; Schema: public; Owner: kirixo
+-- Not ONLY: the key is built on measurement_default too, and later partitions inherit it.
 --
 
-ALTER TABLE ONLY public.measurement
-    ADD CONSTRAINT measurement_pk PRIMARY KEY (id);
+ALTER TABLE public.measurement
+    ADD CONSTRAINT measurement_pk PRIMARY KEY (id, recorded_at);
+
+
+--
+-- Name: measurement_sensor_recorded_at; Type: INDEX; Schema: public; Owner: kirixo
+--
+
+CREATE INDEX measurement_sensor_recorded_at ON public.measurement USING btree (sensor_id, recorded_at, id);
 
 
 --
@@ -380,13 +401,6 @@ ALTER TABLE ONLY public."user"
     ADD CONSTRAINT user_pk PRIMARY KEY (id);
 
 
---
--- Name: measurement trg_measurement_insert; Type: TRIGGER; Schema: public; Owner: kirixo
---
-
-CREATE TRIGGER trg_measurement_insert BEFORE INSERT ON public.measurement FOR EACH ROW EXECUTE FUNCTION public.set_recorded_at();
-
-
 --
 -- Name: sensor trg_sensor_insert; Type: TRIGGER; Schema: public; Owner: kirixo
 --
@@ -433,7 +447,7 @@ CREATE TRIGGER trg_user_update BEFORE UPDATE ON public."user" FOR EACH ROW EXECU
 -- Name: measurement measurement_sensor; Type: FK CONSTRAINT; Schema: public; Owner: kirixo
 --
 
-ALTER TABLE ONLY public.measurement
+ALTER TABLE public.measurement
     ADD CONSTRAINT measurement_sensor FOREIGN KEY (sensor_id) REFERENCES public.sensor(id) ON UPDATE CASCADE ON DELETE CASCADE;
 
 
@@ -0,0 +1,12 @@
+--
+-- Batched ingest supplies recorded_at for every row, so the BEFORE INSERT trigger that
+-- overwrote it with CURRENT_TIMESTAMP becomes a column default instead.
+--
+
+BEGIN;
+
+ALTER TABLE public.measurement ALTER COLUMN recorded_at SET DEFAULT CURRENT_TIMESTAMP;
+
+DROP TRIGGER IF EXISTS trg_measurement_insert ON public.measurement;
+
+COMMIT;
@@ -0,0 +1,19 @@
+--
+-- Readings used to be stored as the text of a double inside a bytea column and parsed on
+-- every read. They move to a native double precision column; rows whose payload is not a
+-- number keep a NULL value.
+--
+
+BEGIN;
+
+ALTER TABLE public.measurement ADD COLUMN value double precision;
+
+UPDATE public.measurement
+SET value = CASE
+    WHEN convert_from(data, 'UTF8') ~ '^\s*[-+]?(\d+\.?\d*|\.\d+)([eE][-+]?\d+)?\s*$'
+        THEN convert_from(data, 'UTF8')::double precision
+    END;
+
+ALTER TABLE public.measurement DROP COLUMN data;
+
+COMMIT;
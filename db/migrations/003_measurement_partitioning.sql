@@ -0,0 +1,63 @@
+--
+-- Turns measurement into a table range-partitioned on recorded_at so range reads and
+-- retention only touch the partitions they need. Existing rows are copied into monthly
+-- partitions; afterwards the backend's PartitionManager creates new ones ahead of time
+-- (daily or monthly, see [Partitioning] in config.ini). The primary key has to include the
+-- partition key, and ids become bigint.
+--
+
+BEGIN;
+
+ALTER TABLE public.measurement RENAME TO measurement_legacy;
+ALTER TABLE public.measurement_legacy RENAME CONSTRAINT measurement_pk TO measurement_legacy_pk;
+ALTER TABLE public.measurement_legacy DROP CONSTRAINT measurement_sensor;
+
+CREATE TABLE public.measurement (
+    id bigint NOT NULL,
+    value double precision,
+    recorded_at timestamp without time zone DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    sensor_id integer NOT NULL
+)
+PARTITION BY RANGE (recorded_at);
+
+ALTER TABLE public.measurement OWNER TO kirixo;
+
+CREATE TABLE public.measurement_default PARTITION OF public.measurement DEFAULT;
+ALTER TABLE public.measurement_default OWNER TO kirixo;
+
+DO $$
+DECLARE
+    month_start timestamp;
+    last_month timestamp;
+BEGIN
+    SELECT date_trunc('month', min(recorded_at)), date_trunc('month', max(recorded_at))
+    INTO month_start, last_month
+    FROM public.measurement_legacy;
+
+    WHILE month_start IS NOT NULL AND month_start <= last_month LOOP
+        EXECUTE format('CREATE TABLE public.%I PARTITION OF public.measurement FOR VALUES FROM (%L) TO (%L)',
+                       'measurement_p' || to_char(month_start, 'YYYYMM'),
+                       month_start, month_start + interval '1 month');
+        month_start := month_start + interval '1 month';
+    END LOOP;
+END $$;
+
+INSERT INTO public.measurement (id, value, recorded_at, sensor_id)
+SELECT id, value, recorded_at, sensor_id FROM public.measurement_legacy;
+
+ALTER SEQUENCE public.measurement_id_seq AS bigint;
+ALTER SEQUENCE public.measurement_id_seq OWNED BY public.measurement.id;
+ALTER TABLE public.measurement ALTER COLUMN id SET DEFAULT nextval('public.measurement_id_seq'::regclass);
+
+DROP TABLE public.measurement_legacy;
+
+-- Without ONLY so the key is built on every partition created above, not just declared on the parent.
+ALTER TABLE public.measurement
+    ADD CONSTRAINT measurement_pk PRIMARY KEY (id, recorded_at);
+
+CREATE INDEX measurement_sensor_recorded_at ON public.measurement USING btree (sensor_id, recorded_at, id);
+
+ALTER TABLE public.measurement
+    ADD CONSTRAINT measurement_sensor FOREIGN KEY (sensor_id) REFERENCES public.sensor(id) ON UPDATE CASCADE ON DELETE CASCADE;
+
+COMMIT;
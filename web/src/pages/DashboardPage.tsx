@@ -42,6 +42,9 @@ ChartJS.register(
   Legend
 );
 
+// Charts ask the backend for an LTTB-downsampled series instead of paging through raw rows
+const CHART_POINTS = 1000;
+
 const DashboardPage: React.FC = () => {
   const { t, i18n } = useTranslation(['dashboard', 'common']);
   const [loading, setLoading] = useState(true);
@@ -165,7 +168,7 @@ const DashboardPage: React.FC = () => {
       }
 
       const response = await fetch(
-        `${API_CONFIG.BASE_URL}/api/measurement/list/sensor?sensor_id=${filters.sensorId}&start_date=${startDate.toISOString()}&end_date=${now.toISOString()}`,
+        `${API_CONFIG.BASE_URL}/api/measurement/list/sensor?sensor_id=${filters.sensorId}&start_date=${startDate.toISOString()}&end_date=${now.toISOString()}&points=${CHART_POINTS}`,
         {
           headers: {
             'Content-Type': 'application/json',
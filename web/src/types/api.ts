@@ -29,6 +29,8 @@ export interface Measurement {
 
 export interface MeasurementListResponse {
   measurements: Measurement[];
+  total_count?: number;
+  next_cursor?: string | null;
 }
 
 export interface LatestMeasurement {